@@ -0,0 +1,199 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "AllocStats.h"
+#include "Allocator.h"
+#include "ScriptModule.h"
+
+extern cMemoryAllocator g_Allocator;
+
+namespace {
+    /** The allocations attributed to one script class.
+     */
+    struct ScriptStats {
+        const char* name;     //!< The name of the script class
+        ulong       messages; //!< How many messages the class has handled
+        ulong       allocs;   //!< How many blocks were allocated while handling them
+        ulong       bytes;    //!< How many bytes were requested while handling them
+    };
+
+
+    /** A message that is being handled.
+     */
+    struct Frame {
+        size_t script;       //!< The index of the handling script's class in scripts
+        ulong  allocs;       //!< The allocator's count when the message arrived
+        ulong  bytes;        //!< The allocator's byte total when the message arrived
+        ulong  child_allocs; //!< The allocations made by messages sent while handling this one
+        ulong  child_bytes;  //!< The bytes requested by messages sent while handling this one
+    };
+
+    const size_t MAX_DEPTH = 32; //!< Messages nested deeper than this are not attributed
+
+    // Note that this must not allocate until it is used, as it is constructed
+    // before the module's allocator is available.
+    std::vector<ScriptStats> scripts;
+
+    Frame  frames[MAX_DEPTH];
+    size_t depth        = 0;
+
+    bool   timing       = false; //!< Has a sim time been seen yet?
+    uint   start_time   = 0;     //!< The sim time the rate is measured from
+    uint   latest_time  = 0;     //!< The latest sim time seen
+    ulong  start_allocs = 0;     //!< The allocator's count at start_time
+
+
+    /** Find the stats for the specified script class, adding them if needed.
+     *  Script names are normally the same string for every instance, so the
+     *  pointer is checked before the contents.
+     */
+    size_t find_script(const char* name)
+    {
+        for(size_t index = 0; index < scripts.size(); ++index) {
+            if(scripts[index].name == name) return index;
+        }
+
+        for(size_t index = 0; index < scripts.size(); ++index) {
+            if(!strcmp(scripts[index].name, name)) return index;
+        }
+
+        ScriptStats stats = { name, 0, 0, 0 };
+        scripts.push_back(stats);
+
+        return scripts.size() - 1;
+    }
+
+
+    /** Write a line of the dump to the file, or the monolog if it is NULL.
+     */
+    void write_line(FILE* out, const char* format, ...)
+    {
+        char buffer[256];
+
+        va_list args;
+        va_start(args, format);
+        vsnprintf(buffer, sizeof(buffer), format, args);
+        va_end(args);
+
+        if(out) {
+            fprintf(out, "%s\n", buffer);
+        } else {
+            g_pfnMPrintf("%s\n", buffer);
+        }
+    }
+}
+
+
+/* ------------------------------------------------------------------------
+ *  Public interface
+ */
+
+void AllocStats::enter(const char* script, const uint time)
+{
+    if(depth < MAX_DEPTH) {
+        Frame& frame = frames[depth];
+        frame.script = find_script(script);
+
+        // Read the counts after find_script(), so its own allocations are not counted
+        const cMemoryAllocator::Stats& stats = g_Allocator.GetStats();
+        frame.allocs       = stats.allocs;
+        frame.bytes        = stats.bytes;
+        frame.child_allocs = 0;
+        frame.child_bytes  = 0;
+
+        // Loading a game can move the sim time backwards, so start again if it does
+        if(!timing || time < latest_time) {
+            timing       = true;
+            start_time   = time;
+            start_allocs = stats.allocs;
+        }
+        latest_time = time;
+    }
+
+    ++depth;
+}
+
+
+void AllocStats::leave(void)
+{
+    if(!depth) return;
+    --depth;
+
+    if(depth < MAX_DEPTH) {
+        const cMemoryAllocator::Stats& stats = g_Allocator.GetStats();
+        Frame& frame = frames[depth];
+
+        ulong allocs = stats.allocs - frame.allocs;
+        ulong bytes  = stats.bytes  - frame.bytes;
+
+        ScriptStats& script = scripts[frame.script];
+        ++script.messages;
+        script.allocs += allocs - frame.child_allocs;
+        script.bytes  += bytes  - frame.child_bytes;
+
+        if(depth) {
+            frames[depth - 1].child_allocs += allocs;
+            frames[depth - 1].child_bytes  += bytes;
+        }
+    }
+}
+
+
+bool AllocStats::dump(const char* filename)
+{
+    FILE* out = NULL;
+    if(filename && *filename) {
+        out = fopen(filename, "w");
+        if(!out) return false;
+    }
+
+    const cMemoryAllocator::Stats& stats = g_Allocator.GetStats();
+
+    write_line(out, "Allocation stats at sim time %u", latest_time);
+    write_line(out, "  Total: %lu allocations, %lu bytes", stats.allocs, stats.bytes);
+    write_line(out, "  Live:  %lu blocks, %lu bytes", stats.blocks, stats.size);
+    write_line(out, "  Peak:  %lu blocks, %lu bytes", stats.peakblocks, stats.peaksize);
+    write_line(out, "  Slabs: %lu", stats.slabs);
+
+    if(timing && latest_time > start_time) {
+        double seconds = (latest_time - start_time) / 1000.0;
+        write_line(out, "  Rate:  %.1f allocations per sim second over %.1f seconds", (stats.allocs - start_allocs) / seconds, seconds);
+    }
+
+    write_line(out, "  %-8s %10s %10s %10s", "Class", "Allocs", "Live", "Peak");
+    for(int cls = 0; cls <= cMemoryAllocator::kHeapClass; ++cls) {
+        const cMemoryAllocator::ClassStats& counts = stats.classes[cls];
+
+        if(counts.blocksize) {
+            write_line(out, "  %-8lu %10lu %10lu %10lu", counts.blocksize, counts.allocs, counts.live, counts.peak);
+        } else {
+            write_line(out, "  %-8s %10lu %10lu %10lu", "heap", counts.allocs, counts.live, counts.peak);
+        }
+    }
+
+    write_line(out, "  %-32s %10s %10s %12s %10s", "Script", "Messages", "Allocs", "Bytes", "Per msg");
+    for(std::vector<ScriptStats>::const_iterator it = scripts.begin(); it != scripts.end(); ++it) {
+        write_line(out, "  %-32s %10lu %10lu %12lu %10.2f", it -> name, it -> messages, it -> allocs, it -> bytes,
+                   it -> messages ? double(it -> allocs) / it -> messages : 0.0);
+    }
+
+    if(out) fclose(out);
+
+    return true;
+}
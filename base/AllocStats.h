@@ -0,0 +1,65 @@
+/** @file
+ * This file contains the interface for the AllocStats class, which reports
+ * the module's memory use in every build.
+ *
+ * @author Chris Page &lt;chris@starforge.co.uk&gt;
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef ALLOCSTATS_H
+#define ALLOCSTATS_H
+
+#include <lg/config.h>
+
+/** Module-wide allocation statistics. The allocator keeps running totals,
+ *  high-water marks, and per size class counts; on top of those, this
+ *  attributes the allocations made while each message is handled to the
+ *  class of the script handling it (not counting any messages that script
+ *  sends while doing so, which are attributed to their own scripts), and
+ *  works out how many allocations are made per second of sim time.
+ *
+ *  The statistics are written to the monolog, or to a file, when any script
+ *  receives a DumpAllocStats message. If the message's data is a string, it
+ *  is used as the name of the file to write to.
+ */
+class AllocStats
+{
+public:
+    /** Note that a script has started handling a message. Every call to this
+     *  must be matched by a call to leave().
+     *
+     * @param script The name of the script's class. This is not copied.
+     * @param time   The sim time of the message.
+     */
+    static void enter(const char* script, const uint time);
+
+
+    /** Note that the script passed to the last unmatched enter() has finished
+     *  handling its message.
+     */
+    static void leave(void);
+
+
+    /** Write the statistics out.
+     *
+     * @param filename The name of the file to write to, or NULL to write to
+     *                 the monolog.
+     * @return true if the statistics were written, false if the file could
+     *         not be opened.
+     */
+    static bool dump(const char* filename = NULL);
+};
+
+#endif // ALLOCSTATS_H
@@ -0,0 +1,182 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#include <lg/interface.h>
+#include <lg/scrmanagers.h>
+#include <lg/objects.h>
+#include <map>
+#include <string>
+#include <utility>
+#include "ArchetypeCache.h"
+#include "ScriptModule.h"
+
+namespace {
+    /** Case-insensitive ordering for object names.
+     */
+    struct NameLess {
+        bool operator()(const std::string& left, const std::string& right) const
+            { return ::_stricmp(left.c_str(), right.c_str()) < 0; }
+    };
+
+
+    /** A cached list of the concrete descendants of an archetype.
+     */
+    struct DescendantList {
+        uint             generation; //!< The generation the list was fetched in
+        std::vector<int> objects;    //!< The IDs of the descendants
+    };
+
+
+    typedef std::map<std::string, int, NameLess>             NameCache;
+    typedef std::map<std::pair<int, bool>, DescendantList>   DescendantCache;
+
+    NameCache       name_cache;
+    DescendantCache descendant_cache;
+
+    uint current_generation  = 1; //!< Changes whenever objects are created or destroyed
+    uint current_database    = 1; //!< Changes whenever the object database changes
+    uint name_generation     = 0; //!< The generation the name cache was filled in
+
+
+    /** Advance a generation counter, skipping 0 so that it never matches an
+     *  entry that has not been filled in yet.
+     */
+    void advance(uint& counter)
+    {
+        if(!++counter) ++counter;
+    }
+
+
+    /** Object system listener callback. Any change to the set of objects means
+     *  cached lists may be out of date.
+     */
+    void __stdcall object_notify(int obj_id, ulong msg, void* data)
+    {
+        advance(current_generation);
+
+        if(msg != kObjNotifyCreate && msg != kObjNotifyDelete)
+            advance(current_database);
+    }
+
+
+    /** Registers the object system listener the first time the cache is used,
+     *  and removes it again when the module is unloaded, as the game must not
+     *  call into the module once it has gone.
+     */
+    class ObjectListener
+    {
+    public:
+        ObjectListener() : handle(0)
+            { /* fnord */ }
+
+        ~ObjectListener()
+        {
+            if(handle && g_pScriptManager) {
+                SInterface<IObjectSystem> obj_sys(g_pScriptManager);
+                obj_sys -> Unlisten(handle);
+            }
+        }
+
+        void listen()
+        {
+            if(handle) return;
+
+            static sObjListenerDesc desc = { object_notify, NULL };
+
+            SInterface<IObjectSystem> obj_sys(g_pScriptManager);
+            handle = obj_sys -> Listen(&desc);
+        }
+
+    private:
+        int handle; //!< The handle for the listener, 0 if it is not registered
+    };
+
+    ObjectListener listener;
+}
+
+
+/* ------------------------------------------------------------------------
+ *  Public interface
+ */
+
+int ArchetypeCache::find(const char* name)
+{
+    listener.listen();
+
+    // Names could come and go with objects, so start again if anything has changed
+    if(name_generation != current_generation) {
+        name_cache.clear();
+        name_generation = current_generation;
+    }
+
+    std::string key(name);
+    NameCache::iterator found = name_cache.lower_bound(key);
+    if(found != name_cache.end() && !name_cache.key_comp()(key, found -> first))
+        return found -> second;
+
+    SInterface<IObjectSystem> obj_sys(g_pScriptManager);
+    int obj_id = obj_sys -> GetObjectNamed(name);
+
+    name_cache.insert(found, std::make_pair(key, obj_id));
+
+    return obj_id;
+}
+
+
+const std::vector<int>& ArchetypeCache::descendants(const int archetype, const bool do_full)
+{
+    listener.listen();
+
+    DescendantList& list = descendant_cache[std::make_pair(archetype, do_full)];
+    // New entries start at generation 0, which current_generation never is
+    if(list.generation == current_generation)
+        return list.objects;
+
+    list.generation = current_generation;
+    list.objects.clear();
+
+    SInterface<ITraitManager> trait_mgr(g_pScriptManager);
+
+    ulong flags = kTraitQueryChildren;
+    if(do_full) flags |= kTraitQueryFull; // If dofull is on, query direct and indirect descendants
+
+    SInterface<IObjectQuery> query = trait_mgr -> Query(archetype, flags);
+    if(query) {
+        for(; !query -> Done(); query -> Next()) {
+            int obj_id = query -> Object();
+
+            // Only concrete objects are wanted
+            if(obj_id > 0) list.objects.push_back(obj_id);
+        }
+    }
+
+    return list.objects;
+}
+
+
+uint ArchetypeCache::generation()
+{
+    listener.listen();
+
+    return current_generation;
+}
+
+
+uint ArchetypeCache::database_generation()
+{
+    listener.listen();
+
+    return current_database;
+}
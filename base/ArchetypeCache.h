@@ -0,0 +1,77 @@
+/** @file
+ * This file contains the interface for the ArchetypeCache class, which
+ * caches archetype IDs and the concrete descendants of archetypes for
+ * all the scripts in the module.
+ *
+ * @author Chris Page &lt;chris@starforge.co.uk&gt;
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef ARCHETYPECACHE_H
+#define ARCHETYPECACHE_H
+
+#include <lg/config.h>
+#include <vector>
+
+/** A module-wide cache of archetype lookups. Archetype names are resolved to
+ *  IDs once, and the list of concrete descendants of an archetype is fetched
+ *  from the trait manager once and then shared by every script that targets
+ *  that archetype.
+ *
+ *  The first time the cache is used it registers an object system listener
+ *  with the game, and whenever an object is created or destroyed, or the
+ *  object database changes, everything in the cache is discarded and will
+ *  be fetched again when it is next needed.
+ */
+class ArchetypeCache
+{
+public:
+    /** Look up the ID of the object with the specified name. This is the
+     *  same as IObjectSystem::GetObjectNamed(), except that the result is
+     *  cached.
+     *
+     * @param name The name of the object to look up.
+     * @return The ID of the named object, or 0 if there is no such object.
+     */
+    static int find(const char* name);
+
+
+    /** Fetch the concrete descendants of the specified archetype.
+     *
+     * @param archetype The ID of the archetype to fetch the descendants of.
+     * @param do_full   If false, only direct concrete descendants are included,
+     *                  if true, all concrete descendants are.
+     * @return A reference to a list of object IDs, in the order the game lists
+     *         them. This is only valid until an object is created or destroyed,
+     *         so it should not be kept.
+     */
+    static const std::vector<int>& descendants(const int archetype, const bool do_full);
+
+
+    /** Obtain a number that changes whenever an object is created or destroyed,
+     *  or the object database changes. Code that keeps information derived from
+     *  the cache can compare this to decide whether to refresh it.
+     */
+    static uint generation();
+
+
+    /** Obtain a number that changes whenever the object database changes
+     *  (for example, when a game is loaded). Object IDs seen before the
+     *  database changed may now refer to different objects.
+     */
+    static uint database_generation();
+};
+
+#endif // ARCHETYPECACHE_H
@@ -0,0 +1,352 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#include <lg/interface.h>
+#include <lg/scrmanagers.h>
+#include <lg/scrservices.h>
+#include <lg/links.h>
+#include <lg/objects.h>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <utility>
+#include "ArchetypeCache.h"
+#include "ArchetypeGrid.h"
+#include "DesignParam.h"
+#include "ScriptLib.h"
+
+const float ArchetypeGrid::CELL_SIZE = 32.0f;
+const uint  ArchetypeGrid::REFRESH_PER_SEARCH;
+const uint  ArchetypeGrid::ATTACH_COUNT;
+const char* const ArchetypeGrid::ATTACH_FLAVOURS[ArchetypeGrid::ATTACH_COUNT] = { "DetailAttachement", "PhysAttach", "ParticleAttachement", "~CreatureAttachment" };
+
+namespace {
+    // Cell coordinates are packed into 21 bits each in cell keys, offset so that
+    // negative coordinates pack correctly.
+    const int                CELL_BITS   = 21;
+    const int                CELL_OFFSET = 1 << (CELL_BITS - 1);
+    const unsigned long long CELL_MASK   = (1ULL << CELL_BITS) - 1;
+
+    typedef std::map<std::pair<int, bool>, ArchetypeGrid*> GridMap;
+
+    GridMap grids; //!< The grids created so far, keyed by archetype and search depth
+
+
+    /** Work out which cell along one axis contains the specified coordinate.
+     */
+    int cell_coord(const float coord)
+    {
+        return static_cast<int>(std::floor(coord / ArchetypeGrid::CELL_SIZE));
+    }
+
+
+    /** Pack the specified cell coordinates into a cell key.
+     */
+    unsigned long long pack_cell(const int x, const int y, const int z)
+    {
+        return ((static_cast<unsigned long long>(x + CELL_OFFSET) & CELL_MASK) << (CELL_BITS * 2)) |
+               ((static_cast<unsigned long long>(y + CELL_OFFSET) & CELL_MASK) << CELL_BITS) |
+                (static_cast<unsigned long long>(z + CELL_OFFSET) & CELL_MASK);
+    }
+
+
+    /** Unpack the coordinate of the cell with the specified key along one axis.
+     *
+     * @param key   The key of the cell.
+     * @param shift The number of bits to shift the key to reach the coordinate.
+     */
+    int unpack_cell(const unsigned long long key, const int shift)
+    {
+        return static_cast<int>((key >> shift) & CELL_MASK) - CELL_OFFSET;
+    }
+
+
+    /** Calculate the distances from a point to the nearest and furthest points
+     *  in the cell with the specified key.
+     *
+     * @param key      The key of the cell.
+     * @param pos      The point to measure from.
+     * @param nearest  A reference to a float to store the nearest distance in.
+     * @param furthest A reference to a float to store the furthest distance in.
+     */
+    void cell_distances(const unsigned long long key, const cScrVec& pos, float& nearest, float& furthest)
+    {
+        const float point[3] = { pos.x, pos.y, pos.z };
+        double near_sq = 0.0, far_sq = 0.0;
+
+        for(int axis = 0; axis < 3; ++axis) {
+            float low  = unpack_cell(key, CELL_BITS * (2 - axis)) * ArchetypeGrid::CELL_SIZE;
+            float high = low + ArchetypeGrid::CELL_SIZE;
+
+            double near_axis = 0.0;
+            if(point[axis] < low) {
+                near_axis = low - point[axis];
+            } else if(point[axis] > high) {
+                near_axis = point[axis] - high;
+            }
+
+            double far_axis = std::max(std::fabs(point[axis] - low), std::fabs(point[axis] - high));
+
+            near_sq += near_axis * near_axis;
+            far_sq  += far_axis * far_axis;
+        }
+
+        nearest  = static_cast<float>(std::sqrt(near_sq));
+        furthest = static_cast<float>(std::sqrt(far_sq));
+    }
+
+
+    /** Does the specified distance pass a radius search?
+     */
+    inline bool in_range(const float distance, const float radius, const bool lessthan)
+    {
+        return (lessthan && (distance < radius)) || (!lessthan && (distance > radius));
+    }
+}
+
+
+/* ------------------------------------------------------------------------
+ *  Public interface
+ */
+
+ArchetypeGrid& ArchetypeGrid::get(const int archetype, const bool do_full)
+{
+    std::pair<GridMap::iterator, bool> added = grids.insert(std::make_pair(std::make_pair(archetype, do_full), static_cast<ArchetypeGrid*>(NULL)));
+    if(added.second)
+        added.first -> second = new ArchetypeGrid(archetype, do_full);
+
+    return *added.first -> second;
+}
+
+
+void ArchetypeGrid::search(TargetList* matches, const cScrVec& from_pos, const float radius, const bool lessthan)
+{
+    // The grid only needs rebuilding if objects have been created or destroyed
+    if(generation != ArchetypeCache::generation()) {
+        rebuild();
+    } else {
+        refresh_positions();
+    }
+
+    found.clear();
+
+    // Mobile objects could be anywhere by now, so check where they are
+    if(!mobile.empty()) {
+        SService<IObjectSrv> obj_srv(g_pScriptManager);
+
+        std::vector<uint>::const_iterator it;
+        for(it = mobile.begin(); it != mobile.end(); ++it) {
+            Member& member = members[*it];
+
+            obj_srv -> Position(member.position, member.obj_id);
+            if(in_range(static_cast<float>(from_pos.Distance(member.position)), radius, lessthan))
+                found.push_back(*it);
+        }
+    }
+
+    // For small 'inside' searches, just look up the cells the sphere's bounding box
+    // covers. Otherwise go through the occupied cells, skipping or accepting whole
+    // cells where possible.
+    int low_x  = cell_coord(from_pos.x - radius), low_y  = cell_coord(from_pos.y - radius), low_z  = cell_coord(from_pos.z - radius);
+    int high_x = cell_coord(from_pos.x + radius), high_y = cell_coord(from_pos.y + radius), high_z = cell_coord(from_pos.z + radius);
+    double box_cells = double(high_x - low_x + 1) * double(high_y - low_y + 1) * double(high_z - low_z + 1);
+
+    if(lessthan && box_cells <= cells.size()) {
+        for(int x = low_x; x <= high_x; ++x) {
+            for(int y = low_y; y <= high_y; ++y) {
+                for(int z = low_z; z <= high_z; ++z) {
+                    CellMap::const_iterator cell = cells.find(pack_cell(x, y, z));
+                    if(cell != cells.end())
+                        search_cell(cell -> second, from_pos, radius, lessthan);
+                }
+            }
+        }
+    } else {
+        float nearest, furthest;
+
+        CellMap::const_iterator cell;
+        for(cell = cells.begin(); cell != cells.end(); ++cell) {
+            cell_distances(cell -> first, from_pos, nearest, furthest);
+
+            // Does the whole cell fail or pass?
+            if(lessthan ? (nearest >= radius) : (furthest <= radius)) continue;
+
+            if(lessthan ? (furthest < radius) : (nearest > radius)) {
+                found.insert(found.end(), cell -> second.begin(), cell -> second.end());
+            } else {
+                search_cell(cell -> second, from_pos, radius, lessthan);
+            }
+        }
+    }
+
+    // Put the matches back in the order the game lists them in
+    std::sort(found.begin(), found.end());
+
+    TargetObj newtarget = { 0, 0 };
+    std::vector<uint>::const_iterator it;
+    for(it = found.begin(); it != found.end(); ++it) {
+        newtarget.obj_id = members[*it].obj_id;
+        matches -> push_back(newtarget);
+    }
+}
+
+
+/* ------------------------------------------------------------------------
+ *  Grid maintenance
+ */
+
+void ArchetypeGrid::rebuild()
+{
+    // Sort the old members by ID, so that the snapshots of any that are still
+    // descendants of the archetype can be found and reused. If the database has
+    // changed, the IDs may refer to different objects, so nothing is kept.
+    std::vector<Member> previous;
+    previous.swap(members);
+    if(database != ArchetypeCache::database_generation())
+        previous.clear();
+
+    std::sort(previous.begin(), previous.end(), [](const Member& left, const Member& right) { return left.obj_id < right.obj_id; });
+
+    mobile.clear();
+    cells.clear();
+
+    SService<IObjectSrv>    obj_srv(g_pScriptManager);
+    SService<ILinkToolsSrv> link_tools(g_pScriptManager);
+
+    // Flavour IDs can change if the game loads a different gamesys
+    for(uint flavour = 0; flavour < ATTACH_COUNT; ++flavour)
+        attach_ids[flavour] = link_tools -> LinkKindNamed(ATTACH_FLAVOURS[flavour]);
+
+    const std::vector<int>& objects = ArchetypeCache::descendants(archetype, do_full);
+    members.reserve(objects.size());
+
+    std::vector<int>::const_iterator it;
+    for(it = objects.begin(); it != objects.end(); ++it) {
+        int obj_id = *it;
+
+        Member member;
+        std::vector<Member>::const_iterator known =
+            std::lower_bound(previous.begin(), previous.end(), obj_id, [](const Member& left, int id) { return left.obj_id < id; });
+
+        if(known != previous.end() && known -> obj_id == obj_id) {
+            member = *known;
+        } else {
+            member.obj_id = obj_id;
+            member.mobile = is_mobile(obj_id);
+            obj_srv -> Position(member.position, obj_id);
+        }
+
+        uint index = members.size();
+        if(member.mobile) {
+            mobile.push_back(index);
+        } else {
+            member.cell = cell_key(member.position);
+            cells[member.cell].push_back(index);
+        }
+
+        members.push_back(member);
+    }
+
+    generation   = ArchetypeCache::generation();
+    database     = ArchetypeCache::database_generation();
+    refresh_next = 0;
+}
+
+
+void ArchetypeGrid::refresh_positions()
+{
+    if(cells.empty()) return;
+
+    SService<IObjectSrv> obj_srv(g_pScriptManager);
+
+    uint checks = std::min<uint>(REFRESH_PER_SEARCH, members.size());
+    for(uint check = 0; check < checks; ++check, ++refresh_next) {
+        if(refresh_next >= members.size()) refresh_next = 0;
+
+        Member& member = members[refresh_next];
+        if(member.mobile) continue;
+
+        // Objects may be given physics, or attached to something, after the
+        // grid was built, in which case they need checking on every search
+        if(is_mobile(member.obj_id)) {
+            remove_from_cell(refresh_next);
+            member.mobile = true;
+            mobile.push_back(refresh_next);
+            continue;
+        }
+
+        obj_srv -> Position(member.position, member.obj_id);
+
+        // If the object has moved to another cell, move its index too
+        unsigned long long key = cell_key(member.position);
+        if(key != member.cell) {
+            remove_from_cell(refresh_next);
+
+            cells[key].push_back(refresh_next);
+            member.cell = key;
+        }
+    }
+}
+
+
+bool ArchetypeGrid::is_mobile(const int obj_id)
+{
+    SService<IPhysSrv> phys_srv(g_pScriptManager);
+    if(phys_srv -> HasPhysics(obj_id)) return true;
+
+    SService<ILinkSrv> link_srv(g_pScriptManager);
+    for(uint flavour = 0; flavour < ATTACH_COUNT; ++flavour) {
+        // Flavours the game doesn't know about have an ID of 0, which would match any link
+        if(!attach_ids[flavour]) continue;
+
+        true_bool attached;
+        link_srv -> AnyExist(attached, attach_ids[flavour], obj_id, 0);
+        if(attached) return true;
+    }
+
+    return false;
+}
+
+
+void ArchetypeGrid::remove_from_cell(const uint index)
+{
+    CellMap::iterator cell = cells.find(members[index].cell);
+    if(cell == cells.end()) return;
+
+    std::vector<uint>& indices = cell -> second;
+    std::vector<uint>::iterator pos = std::find(indices.begin(), indices.end(), index);
+    if(pos != indices.end()) {
+        *pos = indices.back();
+        indices.pop_back();
+    }
+
+    if(indices.empty()) cells.erase(cell);
+}
+
+
+unsigned long long ArchetypeGrid::cell_key(const cScrVec& position)
+{
+    return pack_cell(cell_coord(position.x), cell_coord(position.y), cell_coord(position.z));
+}
+
+
+void ArchetypeGrid::search_cell(const std::vector<uint>& cell, const cScrVec& from_pos, const float radius, const bool lessthan)
+{
+    std::vector<uint>::const_iterator it;
+    for(it = cell.begin(); it != cell.end(); ++it) {
+        if(in_range(static_cast<float>(from_pos.Distance(members[*it].position)), radius, lessthan))
+            found.push_back(*it);
+    }
+}
@@ -0,0 +1,167 @@
+/** @file
+ * This file contains the interface for the ArchetypeGrid class, a spatial
+ * index over the concrete descendants of an archetype that is used to
+ * speed up radius target searches.
+ *
+ * @author Chris Page &lt;chris@starforge.co.uk&gt;
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef ARCHETYPEGRID_H
+#define ARCHETYPEGRID_H
+
+#include <lg/config.h>
+#include <lg/types.h>
+#include <unordered_map>
+#include <vector>
+
+class TargetList;
+
+/** A uniform grid over the positions of the concrete descendants of an
+ *  archetype. Radius searches only need to look at the objects in the
+ *  cells the search sphere overlaps, rather than fetching the position of
+ *  every descendant of the archetype each time.
+ *
+ *  The game does not tell scripts when objects move, so the grid works from
+ *  snapshots of object positions:
+ *
+ *  - Objects with physics (AIs, projectiles, moving terrain, and so on) may
+ *    move at any time, as may objects attached to another object by one of
+ *    the ATTACH_FLAVOURS links. These 'mobile' objects are not placed in the
+ *    grid, and their current position is checked on every search.
+ *  - Other objects only move if something teleports them, so their position
+ *    is recorded when they are added to the grid, and a few of them are
+ *    re-checked on each search, moving them to a new cell if they have been
+ *    teleported, or out of the grid if they have become mobile.
+ *  - The set of descendants comes from ArchetypeCache, and the grid is
+ *    rebuilt whenever an object is created or destroyed, keeping the
+ *    snapshots of objects that are still present. Snapshots are thrown
+ *    away if the object database changes, as IDs may have been reused.
+ *
+ *  Grids are shared by all the scripts in the module, one per archetype
+ *  and search depth, and are created the first time they are needed.
+ */
+class ArchetypeGrid
+{
+public:
+    /** The length of the sides of the grid cells, in world units.
+     */
+    static const float CELL_SIZE;
+
+    /** The number of objects in the grid whose positions are re-checked on
+     *  each search.
+     */
+    static const uint REFRESH_PER_SEARCH = 16;
+
+    /** The number of link flavours in ATTACH_FLAVOURS.
+     */
+    static const uint ATTACH_COUNT = 4;
+
+    /** The link flavours, from the attached object, that make an object move
+     *  along with another.
+     */
+    static const char* const ATTACH_FLAVOURS[ATTACH_COUNT];
+
+
+    /** Obtain the grid for the specified archetype, creating it if needed.
+     *
+     * @param archetype The ID of the archetype to obtain the grid for.
+     * @param do_full   If false, the grid contains the direct concrete
+     *                  descendants of the archetype. If true, it contains
+     *                  all its concrete descendants.
+     * @return A reference to the grid.
+     */
+    static ArchetypeGrid& get(const int archetype, const bool do_full);
+
+
+    /** Search the grid for objects inside, or outside, a sphere. Matches are
+     *  added to the list in the order the game lists the archetype's
+     *  descendants, as if every descendant had been checked in turn.
+     *
+     * @param matches  A pointer to the list to add matched objects to.
+     * @param from_pos The centre of the sphere.
+     * @param radius   The radius of the sphere.
+     * @param lessthan If true, objects must be less than the radius from
+     *                 the centre, otherwise they must be further away.
+     */
+    void search(TargetList* matches, const cScrVec& from_pos, const float radius, const bool lessthan);
+
+private:
+    /** An object in the grid.
+     */
+    struct Member {
+        int                obj_id;   //!< The ID of the object
+        cScrVec            position; //!< The position of the object when it was last checked
+        bool               mobile;   //!< Does the object have physics, or is it attached to something?
+        unsigned long long cell;     //!< The key of the cell the object is in, if it is not mobile
+    };
+
+    typedef std::unordered_map<unsigned long long, std::vector<uint> > CellMap;
+
+
+    ArchetypeGrid(const int archetype_id, const bool full) :
+        archetype(archetype_id), do_full(full), generation(0), database(0), refresh_next(0)
+        { /* fnord */ }
+
+
+    /** Fetch the list of descendants of the archetype, and rebuild the grid
+     *  from it. Objects that were in the previous list keep their recorded
+     *  position, new objects have their positions fetched.
+     */
+    void rebuild();
+
+
+    /** Re-check the positions of the next REFRESH_PER_SEARCH objects in the
+     *  grid, moving them to new cells if they have moved, or out of the grid
+     *  if they have become mobile.
+     */
+    void refresh_positions();
+
+
+    /** Determine whether the specified object has physics, or is attached to
+     *  another object, so that it may move without being teleported.
+     */
+    bool is_mobile(const int obj_id);
+
+
+    /** Remove the member with the specified index from the cell it is in.
+     */
+    void remove_from_cell(const uint index);
+
+
+    /** Calculate the key of the cell containing the specified position.
+     */
+    static unsigned long long cell_key(const cScrVec& position);
+
+
+    /** Check the objects in the specified cell, adding the indices of any
+     *  that match the search to the found list.
+     */
+    void search_cell(const std::vector<uint>& cell, const cScrVec& from_pos, const float radius, const bool lessthan);
+
+    int                  archetype;    //!< The ID of the archetype the grid is for
+    bool                 do_full;      //!< Does the grid include indirect descendants?
+    uint                 generation;   //!< The ArchetypeCache generation the grid was built in, 0 if never
+    uint                 database;     //!< The ArchetypeCache database generation the snapshots were taken in
+    uint                 refresh_next; //!< The index of the next object to re-check the position of
+    long                 attach_ids[ATTACH_COUNT]; //!< The IDs of the ATTACH_FLAVOURS, looked up by rebuild()
+
+    std::vector<Member>  members;      //!< The descendants of the archetype, in the order the game lists them
+    std::vector<uint>    mobile;       //!< The indices of the mobile members
+    CellMap              cells;        //!< The indices of the other members in each cell
+    std::vector<uint>    found;        //!< The indices of the members matched by the current search
+};
+
+#endif // ARCHETYPEGRID_H
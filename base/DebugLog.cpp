@@ -0,0 +1,369 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#include <lg/interface.h>
+#include <lg/scrmanagers.h>
+#include <lg/objects.h>
+#include <lg/properties.h>
+#include <cstdio>
+#include <cstring>
+#include "DebugLog.h"
+#include "TraceLog.h"
+#include "ScriptModule.h"
+
+namespace {
+    const unsigned RECORD_COUNT = 32;   //!< How many records the log can hold before it must be flushed
+    const size_t   MPRINT_LIMIT = 900;  //!< The longest string MPrint can cope with
+
+    DebugLog::Record records[RECORD_COUNT]; //!< The log, as a ring of records
+    unsigned first = 0;                     //!< The index of the oldest record in the ring
+    unsigned count = 0;                     //!< How many records are waiting to be printed
+
+
+    /** Fetch the value of an argument as an integer, converting if needed.
+     */
+    long long arg_integer(const DebugLog::Arg& arg)
+    {
+        switch(arg.type) {
+            case DebugLog::Arg::SIGNED:   return arg.i;
+            case DebugLog::Arg::UNSIGNED: return static_cast<long long>(arg.u);
+            case DebugLog::Arg::REAL:     return static_cast<long long>(arg.d);
+            default:                 return static_cast<long long>(reinterpret_cast<size_t>(arg.p));
+        }
+    }
+
+
+    /** Fetch the value of an argument as a double, converting if needed.
+     */
+    double arg_real(const DebugLog::Arg& arg)
+    {
+        switch(arg.type) {
+            case DebugLog::Arg::SIGNED:   return static_cast<double>(arg.i);
+            case DebugLog::Arg::UNSIGNED: return static_cast<double>(arg.u);
+            case DebugLog::Arg::REAL:     return arg.d;
+            default:                 return 0.0;
+        }
+    }
+
+
+    /** Print a single value into the output buffer using the specified
+     *  conversion specification.
+     *
+     * @return The number of characters added to the output buffer.
+     */
+    template <typename T>
+    size_t print_value(char* out, const size_t space, const char* spec, T value)
+    {
+        int len = snprintf(out, space, spec, value);
+
+        if(len < 0) {
+            *out = '\0';
+            return 0;
+        }
+
+        return (static_cast<size_t>(len) < space) ? len : space - 1;
+    }
+
+
+    /** Print an argument using the specified conversion specification. The
+     *  argument is converted to the type the specification expects, exactly
+     *  as it would have been read by printf.
+     *
+     * @return The number of characters added to the output buffer.
+     */
+    size_t print_arg(char* out, const size_t space, const char* spec, const size_t spec_len, const DebugLog::Arg& arg)
+    {
+        char conv = spec[spec_len - 1];
+        char size = spec[spec_len - 2];
+        bool wide = (size == 'l' || size == 'q' || size == 'j' || size == '4');
+        bool huge = wide && (spec[spec_len - 3] == 'l' || size == 'q' || size == 'j' || size == '4');
+
+        switch(conv) {
+            case 'd':
+            case 'i':
+            case 'c':
+                if(huge) return print_value(out, space, spec, arg_integer(arg));
+                if(wide) return print_value(out, space, spec, static_cast<long>(arg_integer(arg)));
+                return print_value(out, space, spec, static_cast<int>(arg_integer(arg)));
+
+            case 'o':
+            case 'u':
+            case 'x':
+            case 'X':
+                if(huge) return print_value(out, space, spec, static_cast<unsigned long long>(arg_integer(arg)));
+                if(wide) return print_value(out, space, spec, static_cast<unsigned long>(arg_integer(arg)));
+                return print_value(out, space, spec, static_cast<unsigned>(arg_integer(arg)));
+
+            case 's':
+                return print_value(out, space, spec, (arg.type == DebugLog::Arg::STRING) ? arg.s : "");
+
+            case 'p':
+                return print_value(out, space, spec, arg.p);
+
+            // 'n' is deliberately not supported
+            case 'n':
+                return 0;
+
+            default:
+                if(size == 'L') return print_value(out, space, spec, static_cast<long double>(arg_real(arg)));
+                return print_value(out, space, spec, arg_real(arg));
+        }
+    }
+
+
+    /** Obtain the next argument slot in the record, or NULL if it is full.
+     */
+    DebugLog::Arg* next_arg(DebugLog::Record* record, const DebugLog::Arg::Type type)
+    {
+        if(record -> arg_count >= DebugLog::MAX_ARGS) return NULL;
+
+        DebugLog::Arg* arg = &record -> args[record -> arg_count++];
+        arg -> type = type;
+
+        return arg;
+    }
+}
+
+
+/* ------------------------------------------------------------------------
+ *  Public interface
+ */
+
+void DebugLog::flush(void)
+{
+    char name[256];
+    char buffer[MPRINT_LIMIT];
+    int  name_id = 0;
+    bool tracing = count && TraceLog::enabled();
+
+    while(count) {
+        Record& record = records[first];
+
+        // The trace stores the record as-is, and leaves formatting to the decoder
+        if(tracing) {
+            TraceLog::append(record);
+
+        } else {
+            // Consecutive messages tend to be about the same object, so only look
+            // up its name when the object changes
+            if(record.obj_id != name_id || !name_id) {
+                object_name(name, sizeof(name), record.obj_id);
+                name_id = record.obj_id;
+            }
+
+            format(record, buffer, sizeof(buffer));
+            g_pfnMPrintf("%s[%s(%s)]: %s\n", record.level, record.script, name, buffer);
+        }
+
+        first = (first + 1) % RECORD_COUNT;
+        --count;
+    }
+}
+
+
+void DebugLog::format(const Record& record, char* buffer, const size_t size)
+{
+    const char* fmt = record.format;
+    char*       out = buffer;
+    char*       end = buffer + size - 1;
+    unsigned    arg = 0;
+
+    while(*fmt && out < end) {
+        if(*fmt != '%') {
+            *out++ = *fmt++;
+
+        } else if(fmt[1] == '%') {
+            *out++ = '%';
+            fmt += 2;
+
+        } else {
+            char   spec[32];
+            size_t len = 0;
+
+            // Copy the flags, width, precision, and size into the spec
+            spec[len++] = *fmt++;
+            while(*fmt && !strchr("diouxXeEfFgGaAcspn", *fmt) && len < sizeof(spec) - 2)
+                spec[len++] = *fmt++;
+
+            // Give up on truncated specs, or specs without arguments
+            if(!*fmt || arg >= record.arg_count) break;
+
+            spec[len++] = *fmt++;
+            spec[len] = '\0';
+
+            out += print_arg(out, end - out + 1, spec, len, record.args[arg++]);
+        }
+    }
+
+    *out = '\0';
+}
+
+
+void DebugLog::object_name(char* buffer, const size_t size, const int obj_id)
+{
+    // The script manager goes away when the module is unloaded
+    if(!g_pScriptManager) {
+        snprintf(buffer, size, "%d", obj_id);
+        return;
+    }
+
+    // NOTE: obj_name isn't freed when GetName sets it to non-NULL. As near
+    // as I can tell, it doesn't need to, it only needs to be freed when
+    // using the version of GetName in ObjectSrv... Probably. Maybe. >.<
+    // The docs for this are pretty shit, so this is mostly guesswork.
+
+    SInterface<IObjectSystem> ObjSys(g_pScriptManager);
+    const char* obj_name = ObjSys -> GetName(obj_id);
+
+    // If the object system has returned a name here, the concrete object
+    // has been given a name, so use it
+    if(obj_name) {
+        snprintf(buffer, size, "%s (%d)", obj_name, obj_id);
+
+    // Otherwise, the concrete object has no name, get its archetype name
+    // if possible and use that instead.
+    } else {
+        SInterface<ITraitManager> TraitMan(g_pScriptManager);
+        object archetype_id = TraitMan -> GetArchetype(obj_id);
+        const char* archetype_name = ObjSys -> GetName(archetype_id);
+
+        // Archetype name found, use it in the string
+        if(archetype_name) {
+            snprintf(buffer, size, "A %s (%d)", archetype_name, obj_id);
+
+        // Can't find a name or archetype name (!), so just use the ID
+        } else {
+            snprintf(buffer, size, "%d", obj_id);
+        }
+    }
+}
+
+
+/* ------------------------------------------------------------------------
+ *  Record construction
+ */
+
+DebugLog::Record* DebugLog::begin(const char* level, const char* script, const int obj_id, const uint time, const char* format)
+{
+    if(count == RECORD_COUNT)
+        flush();
+
+    Record* record = &records[(first + count) % RECORD_COUNT];
+    record -> level     = level;
+    record -> script    = script;
+    record -> obj_id    = obj_id;
+    record -> time      = time;
+    record -> format    = format;
+    record -> arg_count = 0;
+    record -> text_used = 0;
+
+    return record;
+}
+
+
+void DebugLog::end(Record* record, const bool flush_now)
+{
+    ++count;
+
+    if(flush_now) {
+        flush();
+
+        // Keep a copy of the trace leading up to the problem
+        if(TraceLog::enabled())
+            TraceLog::dump_error(record -> time);
+    }
+}
+
+
+void DebugLog::add_arg(Record* record, const int value)
+{
+    Arg* arg = next_arg(record, Arg::SIGNED);
+    if(arg) arg -> i = value;
+}
+
+
+void DebugLog::add_arg(Record* record, const long value)
+{
+    Arg* arg = next_arg(record, Arg::SIGNED);
+    if(arg) arg -> i = value;
+}
+
+
+void DebugLog::add_arg(Record* record, const long long value)
+{
+    Arg* arg = next_arg(record, Arg::SIGNED);
+    if(arg) arg -> i = value;
+}
+
+
+void DebugLog::add_arg(Record* record, const unsigned value)
+{
+    Arg* arg = next_arg(record, Arg::UNSIGNED);
+    if(arg) arg -> u = value;
+}
+
+
+void DebugLog::add_arg(Record* record, const unsigned long value)
+{
+    Arg* arg = next_arg(record, Arg::UNSIGNED);
+    if(arg) arg -> u = value;
+}
+
+
+void DebugLog::add_arg(Record* record, const unsigned long long value)
+{
+    Arg* arg = next_arg(record, Arg::UNSIGNED);
+    if(arg) arg -> u = value;
+}
+
+
+void DebugLog::add_arg(Record* record, const double value)
+{
+    Arg* arg = next_arg(record, Arg::REAL);
+    if(arg) arg -> d = value;
+}
+
+
+void DebugLog::add_arg(Record* record, const char* value)
+{
+    Arg* arg = next_arg(record, Arg::STRING);
+    if(!arg) return;
+
+    if(!value) value = "(null)";
+
+    // Copy as much of the string as will fit into the record's text, so that
+    // the caller's string does not need to outlive the record.
+    size_t space = sizeof(record -> text) - record -> text_used;
+    char*  copy  = &record -> text[record -> text_used];
+
+    if(space) {
+        size_t len = strlen(value);
+        if(len >= space) len = space - 1;
+
+        memcpy(copy, value, len);
+        copy[len] = '\0';
+        record -> text_used += len + 1;
+        arg -> s = copy;
+    } else {
+        arg -> s = "";
+    }
+}
+
+
+void DebugLog::add_arg(Record* record, const void* value)
+{
+    Arg* arg = next_arg(record, Arg::POINTER);
+    if(arg) arg -> p = value;
+}
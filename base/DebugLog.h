@@ -0,0 +1,176 @@
+/** @file
+ * This file contains the interface for the DebugLog class, which records
+ * debugging messages cheaply when they are written, and only formats them
+ * when they are sent to the monolog.
+ *
+ * @author Chris Page &lt;chris@starforge.co.uk&gt;
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef DEBUGLOG_H
+#define DEBUGLOG_H
+
+#include <lg/config.h>
+#include <cstddef>
+
+/** The lowest debug level that will be compiled into the module: 0 includes
+ *  all messages, 1 drops debug messages, 2 keeps only errors, and 3 removes
+ *  all debug output. This is normally set by the Makefile.
+ */
+#ifndef TW_DEBUG_LEVEL
+#define TW_DEBUG_LEVEL 0
+#endif
+
+
+/** A module-wide log of debugging messages waiting to be written to the
+ *  monolog. Writing a message copies its format string pointer and arguments
+ *  into a record in a fixed-size ring, without allocating, formatting, or
+ *  looking up the name of the object the message is about. The records are
+ *  formatted and printed when flush() is called, which TWBaseScript does once
+ *  it has finished handling each message, or when the ring fills up.
+ *
+ *  As formatting is deferred, the format string must remain valid until the
+ *  record is flushed - in practice, it should be a string literal. String
+ *  arguments are copied into the record, so they may be temporaries.
+ */
+class DebugLog
+{
+public:
+    static const unsigned MAX_ARGS  = 12;  //!< The most arguments a record can hold
+    static const unsigned TEXT_SIZE = 512; //!< The space in a record for copies of string arguments
+
+    /** A single argument to a record's format string.
+     */
+    struct Arg {
+        enum Type {
+            SIGNED,   //!< Any signed integer type
+            UNSIGNED, //!< Any unsigned integer type
+            REAL,     //!< A float or double
+            STRING,   //!< A string, copied into the record's text
+            POINTER   //!< Any other pointer
+        } type;
+
+        union {
+            long long          i;
+            unsigned long long u;
+            double             d;
+            const char*        s;
+            const void*        p;
+        };
+    };
+
+    /** A message waiting in the log. Records live in a fixed ring and are
+     *  reused, so nothing here allocates.
+     */
+    struct Record {
+        const char* level;            //!< The name of the message's debug level
+        const char* script;           //!< The name of the script that wrote the message
+        int         obj_id;           //!< The object the script is attached to
+        uint        time;             //!< The sim time of the message being handled when this was written
+        const char* format;           //!< The format string, which must outlive the record
+        unsigned    arg_count;        //!< How many arguments have been stored in args
+        Arg         args[MAX_ARGS];   //!< The arguments for the format
+        size_t      text_used;        //!< How much of text has been used
+        char        text[TEXT_SIZE];  //!< Storage for copies of string arguments
+    };
+
+
+    /** Write a message to the log. Errors should be flushed straight away, in
+     *  case the script does not survive to flush them normally.
+     *
+     * @param level     The name of the debug level of the message.
+     * @param script    The name of the script writing the message. This must
+     *                  remain valid until the record is flushed.
+     * @param obj_id    The ID of the object the script is attached to.
+     * @param time      The current sim time, in milliseconds.
+     * @param flush_now If true, flush the log after writing the message.
+     * @param format    A printf compatible format string.
+     * @param args      The arguments for the format.
+     */
+    template <typename... Args>
+    static void write(const char* level, const char* script, const int obj_id, const uint time, const bool flush_now, const char* format, Args... args)
+    {
+        static_assert(sizeof...(Args) <= MAX_ARGS, "Too many arguments for a debug log record");
+
+        Record* record = begin(level, script, obj_id, time, format);
+        add_args(record, args...);
+        end(record, flush_now);
+    }
+
+
+    /** Format and print any messages waiting in the log. If the binary trace
+     *  is enabled, the messages are added to the trace instead.
+     */
+    static void flush(void);
+
+
+    /** Expand a record's format string and arguments into a buffer, in the
+     *  same way that printf would.
+     *
+     * @param record The record to format.
+     * @param buffer The buffer to store the formatted message in.
+     * @param size   The size of the buffer, including the space for the nul.
+     */
+    static void format(const Record& record, char* buffer, const size_t size);
+
+
+    /** Build a 'human readable' string containing the specified object's name
+     *  (or archetype name) and its ID number.
+     *
+     * @param buffer The buffer to store the name in.
+     * @param size   The size of the buffer, including the space for the nul.
+     * @param obj_id The ID of the object to obtain the name and number of.
+     */
+    static void object_name(char* buffer, const size_t size, const int obj_id);
+
+private:
+    /** Start a new record in the log, flushing the log first if it is full.
+     *
+     * @return A pointer to the new record.
+     */
+    static Record* begin(const char* level, const char* script, const int obj_id, const uint time, const char* format);
+
+
+    /** Mark the record as ready to be printed, and flush the log if needed.
+     */
+    static void end(Record* record, const bool flush_now);
+
+
+    /* Argument capture. The types here mirror the default argument promotions
+     * done for printf, so any argument that can be passed to printf can be
+     * passed to write().
+     */
+    static void add_arg(Record* record, const int value);
+    static void add_arg(Record* record, const long value);
+    static void add_arg(Record* record, const long long value);
+    static void add_arg(Record* record, const unsigned value);
+    static void add_arg(Record* record, const unsigned long value);
+    static void add_arg(Record* record, const unsigned long long value);
+    static void add_arg(Record* record, const double value);
+    static void add_arg(Record* record, const char* value);
+    static void add_arg(Record* record, const void* value);
+
+    static void add_args(Record* record)
+        { /* fnord */ }
+
+    template <typename T, typename... Args>
+    static void add_args(Record* record, T value, Args... args)
+    {
+        add_arg(record, value);
+        add_args(record, args...);
+    }
+};
+
+#endif // DEBUGLOG_H
@@ -0,0 +1,197 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#include <lg/interface.h>
+#include <cctype>
+#include <cstring>
+#include "DesignNote.h"
+#include "ScriptModule.h"
+#include "ScriptLib.h"
+
+namespace {
+    /** Skip any whitespace at the specified position in a string.
+     *
+     * @param str A pointer to the position to start skipping from.
+     * @return A pointer to the first non-whitespace character at or
+     *         after str.
+     */
+    char* skip_space(char* str)
+    {
+        while(*str && isspace(*str)) ++str;
+
+        return str;
+    }
+
+
+    /** Move the specified end pointer back over any whitespace, stopping
+     *  if the start of the string is reached.
+     *
+     * @param start A pointer to the start of the string.
+     * @param end   A pointer to the character after the end of the string.
+     * @return A pointer to the character after the last non-whitespace
+     *         character in the string.
+     */
+    char* trim_space(char* start, char* end)
+    {
+        while(end > start && isspace(*(end - 1))) --end;
+
+        return end;
+    }
+}
+
+
+/* ------------------------------------------------------------------------
+ *  DesignNote
+ */
+
+DesignNote::DesignNote(const int obj_id) :
+    buffer(GetObjectParams(obj_id)), params()
+{
+    if(buffer) build_index();
+}
+
+
+DesignNote::DesignNote(const char* note) :
+    buffer(NULL), params()
+{
+    if(note) parse(note, strlen(note));
+}
+
+
+DesignNote::DesignNote(const std::string& note) :
+    buffer(NULL), params()
+{
+    parse(note.c_str(), note.length());
+}
+
+
+DesignNote::~DesignNote()
+{
+    if(buffer) g_pMalloc -> Free(buffer);
+}
+
+
+const char* DesignNote::get(const std::string& name) const
+{
+    const Param* param = find(name.c_str(), name.length(), hash_name(name.c_str(), name.length()));
+
+    return param ? param -> value : NULL;
+}
+
+
+const char* DesignNote::get(const Name& name) const
+{
+    const Param* param = find(name.name.c_str(), name.name.length(), name.hash);
+
+    return param ? param -> value : NULL;
+}
+
+
+unsigned DesignNote::hash_name(const char* name, size_t len, unsigned hash)
+{
+    while(len--) {
+        hash ^= static_cast<unsigned char>(tolower(*name++));
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+
+const DesignNote::Param* DesignNote::find(const char* name, const size_t name_len, const unsigned hash) const
+{
+    std::vector<Param>::const_iterator it;
+    for(it = params.begin(); it != params.end(); ++it) {
+        if(it -> hash == hash && it -> name_len == name_len && !::_stricmp(it -> name, name))
+            return &(*it);
+    }
+
+    return NULL;
+}
+
+
+void DesignNote::parse(const char* note, size_t length)
+{
+    // Nothing to do for empty notes, and no need to allocate anything.
+    if(!length) return;
+
+    buffer = static_cast<char*>(g_pMalloc -> Alloc(length + 1));
+    memcpy(buffer, note, length);
+    buffer[length] = '\0';
+
+    build_index();
+}
+
+
+void DesignNote::build_index()
+{
+    // Every parameter bar the last ends with a ';', so this is enough room
+    // for all of them (more if any values contain quoted ';'s)
+    size_t count = 1;
+    for(const char* scan = buffer; *scan; ++scan) {
+        if(*scan == ';') ++count;
+    }
+    params.reserve(count);
+
+    char* pos = buffer;
+    while(*pos) {
+        // Skip leading whitespace and empty parameters
+        while(*pos && (isspace(*pos) || *pos == ';')) ++pos;
+        if(!*pos) break;
+
+        char* name_start = pos;
+        while(*pos && *pos != '=' && *pos != ';') ++pos;
+
+        // A parameter with no value can't be used, so skip to the next one
+        if(*pos != '=') continue;
+
+        char* name_end = trim_space(name_start, pos);
+        ++pos;
+
+        // Values may be quoted, in which case the ';' separator may appear in the value.
+        // Anything after the closing quote, up to the separator, is ignored.
+        char* value_start = skip_space(pos);
+        char* value_end;
+        if(*value_start == '"' || *value_start == '\'') {
+            const char quote = *value_start++;
+
+            pos = value_start;
+            while(*pos && *pos != quote) ++pos;
+            value_end = pos;
+
+            while(*pos && *pos != ';') ++pos;
+        } else {
+            pos = value_start;
+            while(*pos && *pos != ';') ++pos;
+
+            value_end = trim_space(value_start, pos);
+        }
+
+        // Step over the separator before terminating the value, as the value may
+        // end at the separator
+        if(*pos) ++pos;
+
+        *name_end  = '\0';
+        *value_end = '\0';
+
+        // Only the first setting for any given name is used.
+        size_t   name_len = name_end - name_start;
+        unsigned hash     = hash_name(name_start, name_len);
+        if(!find(name_start, name_len, hash)) {
+            Param param = { name_start, name_len, hash, value_start };
+            params.push_back(param);
+        }
+    }
+}
@@ -0,0 +1,194 @@
+/** @file
+ * This file contains the interface for the DesignNote class, which parses
+ * a design note into an index of its parameters.
+ *
+ * @author Chris Page &lt;chris@starforge.co.uk&gt;
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef DESIGNNOTE_H
+#define DESIGNNOTE_H
+
+#include <string>
+#include <vector>
+
+/** A parsed design note. The design note is split into its parameters in a
+ *  single pass when the DesignNote is created, following the design-note
+ *  rule in docs/design_note.abnf, and the name and value of each parameter
+ *  are recorded in an index. Looking up a parameter is then a search of the
+ *  index rather than another scan of the note, and the value returned points
+ *  into the DesignNote's own copy of the note, so nothing is copied.
+ *
+ *  Scripts create a DesignNote from their host object's design note once, when
+ *  they initialise, and pass it down the init() chain so that each class in the
+ *  script's hierarchy can initialise its parameters from it.
+ *
+ *  As with GetParamString(), names are matched case-insensitively, the first
+ *  parameter with a given name wins, whitespace around names and values is
+ *  ignored, and values may be enclosed in matching single or double quotes
+ *  (in which case they may contain ';').
+ *
+ * @note DesignNote can be constructed implicitly from a string, so code that
+ *       passes a raw design note to DesignParam init() functions will still
+ *       work, but it will parse the note for every parameter. Scripts should
+ *       create one DesignNote and pass it to each init() instead.
+ */
+class DesignNote
+{
+public:
+    /** A parameter name with its hash worked out in advance, so that it can
+     *  be looked up in any number of design notes without hashing it again.
+     */
+    struct Name {
+        std::string name; //!< The full name of the parameter
+        unsigned    hash; //!< The hash of the name, as calculated by hash_name()
+    };
+
+    /** The value hash_name() starts from when hashing a new name.
+     */
+    static const unsigned HASH_SEED = 2166136261u;
+
+    /** Create an empty DesignNote. Looking up any parameter in an empty
+     *  DesignNote will fail, so DesignParams initialised from it will
+     *  use their defaults.
+     */
+    DesignNote() : buffer(NULL), params()
+        { /* fnord */ }
+
+
+    /** Create a new DesignNote from the Editor -> Design Note property on the
+     *  specified object. The DesignNote takes ownership of the note returned by
+     *  GetObjectParams() and parses it in place, so the note is not copied.
+     *
+     * @param obj_id The ID of the object to fetch the design note from.
+     */
+    explicit DesignNote(const int obj_id);
+
+
+    /** Create a new DesignNote from the specified design note string.
+     *
+     * @param note A pointer to the design note to parse. This may be NULL,
+     *             in which case the DesignNote is empty.
+     */
+    DesignNote(const char* note);
+
+
+    /** Create a new DesignNote from the specified design note string.
+     *
+     * @param note A reference to a string containing the design note to parse.
+     */
+    DesignNote(const std::string& note);
+
+
+    ~DesignNote();
+
+
+    /** Fetch the value of the named parameter.
+     *
+     * @param name The full name of the parameter to fetch (the script name
+     *             followed by the parameter name).
+     * @return A pointer to the value of the parameter. This is owned by the
+     *         DesignNote and is only valid for as long as it is. If the
+     *         parameter is not set in the design note, this returns NULL.
+     */
+    const char* get(const std::string& name) const;
+
+
+    /** Fetch the value of the named parameter, using the name's precalculated
+     *  hash.
+     *
+     * @param name The full name of the parameter to fetch.
+     * @return A pointer to the value of the parameter, or NULL if it is not
+     *         set in the design note.
+     */
+    const char* get(const Name& name) const;
+
+
+    /** Calculate a case-insensitive hash of the specified name. This is
+     *  FNV-1a over the lowercased characters of the name, which is plenty
+     *  to make mismatches cheap to reject during lookup. A name held in
+     *  pieces may be hashed by passing the hash of each piece as the
+     *  starting value for the next.
+     *
+     * @param name A pointer to the start of the name to hash.
+     * @param len  The number of characters in the name.
+     * @param hash The value to start the hash from.
+     * @return The hash of the name.
+     */
+    static unsigned hash_name(const char* name, size_t len, unsigned hash = HASH_SEED);
+
+
+    /** Was there a design note to parse? Note that a DesignNote created from
+     *  an empty string is treated as having no design note.
+     *
+     * @return true if the DesignNote was created from a design note, false if
+     *         it is empty.
+     */
+    bool is_set() const
+        { return buffer != NULL; }
+
+
+    /** Determine how many parameters were found in the design note.
+     *
+     * @return The number of parameters in the index.
+     */
+    size_t size() const
+        { return params.size(); }
+
+private:
+    /** An entry in the parameter index. The name and value both point into
+     *  the buffer, and are nul terminated.
+     */
+    struct Param {
+        const char* name;     //!< The name of the parameter
+        size_t      name_len; //!< The length of the name
+        unsigned    hash;     //!< A case-insensitive hash of the name
+        const char* value;    //!< The value set for the parameter
+    };
+
+
+    /** Locate the index entry for the named parameter.
+     *
+     * @param name     A pointer to the nul terminated name to search for.
+     * @param name_len The length of the name.
+     * @param hash     The hash of the name, as calculated by hash_name().
+     * @return A pointer to the index entry, or NULL if the name is not in the index.
+     */
+    const Param* find(const char* name, const size_t name_len, const unsigned hash) const;
+
+
+    /** Copy the specified design note into the buffer and parse it.
+     *
+     * @param note   A pointer to the design note to parse.
+     * @param length The length of the design note, in characters.
+     */
+    void parse(const char* note, size_t length);
+
+
+    /** Build the parameter index from the design note in the buffer,
+     *  terminating each name and value in place.
+     */
+    void build_index();
+
+
+    // DesignNotes own their buffer, so they can not be copied.
+    DesignNote(const DesignNote&);
+    DesignNote& operator=(const DesignNote&);
+
+    char*              buffer; //!< The parsed design note, allocated via g_pMalloc
+    std::vector<Param> params; //!< The index of parameters in the buffer
+};
+
+#endif // DESIGNNOTE_H
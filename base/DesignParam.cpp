@@ -13,28 +13,115 @@
 #include <cstring>
 #include <cstdlib>
 #include <chrono>       // std::chrono::system_clock
-#include <algorithm>    // std::sort and std::shuffle
+#include <algorithm>    // std::sort, std::swap, std::lower_bound, and std::copy
 
 #include "QVarWrapper.h"
+#include "ArchetypeCache.h"
+#include "ArchetypeGrid.h"
+#include "MessageArena.h"
 #include "DesignParam.h"
 #include "ScriptLib.h"
 
+namespace {
+    // Note that this must not allocate until it is used, as it is constructed
+    // before the module's allocator is available.
+    std::vector<DesignNote::Name*> name_slots; //!< Open-addressed hash table of interned names, NULL marks empty slots
+    size_t                         name_count; //!< How many names have been interned
+
+
+    /** Does the interned name match the name made of the specified pieces?
+     *  As design note lookups are case-insensitive, so is this.
+     */
+    bool name_matches(const std::string& interned, const char* const pieces[], const size_t lengths[], const size_t total)
+    {
+        if(interned.length() != total) return false;
+
+        const char* pos = interned.c_str();
+        for(int piece = 0; piece < 3; ++piece) {
+            if(::_strnicmp(pos, pieces[piece], lengths[piece])) return false;
+            pos += lengths[piece];
+        }
+
+        return true;
+    }
+
+
+    /** Find the slot in the hash table that holds the name made of the
+     *  specified pieces, or the empty slot it would go in if it has not been
+     *  interned.
+     */
+    size_t find_name_slot(const char* const pieces[], const size_t lengths[], const size_t total, const unsigned hash)
+    {
+        size_t mask = name_slots.size() - 1;
+        size_t slot = hash & mask;
+
+        while(name_slots[slot]) {
+            const DesignNote::Name* name = name_slots[slot];
+            if(name -> hash == hash && name_matches(name -> name, pieces, lengths, total))
+                break;
+
+            slot = (slot + 1) & mask;
+        }
+
+        return slot;
+    }
+
+
+    /** Double the size of the hash table, and put all the names back into it.
+     */
+    void grow_name_slots()
+    {
+        std::vector<DesignNote::Name*> previous(name_slots.empty() ? 64 : name_slots.size() * 2, NULL);
+        previous.swap(name_slots);
+
+        size_t mask = name_slots.size() - 1;
+        for(std::vector<DesignNote::Name*>::const_iterator it = previous.begin(); it != previous.end(); ++it) {
+            if(!*it) continue;
+
+            size_t slot = (*it) -> hash & mask;
+            while(name_slots[slot]) slot = (slot + 1) & mask;
+
+            name_slots[slot] = *it;
+        }
+    }
+}
+
+
 /* ------------------------------------------------------------------------
  *  DesignParam
  */
 
-bool DesignParam::get_param_string(const std::string& design_note, std::string& parameter)
+const DesignNote::Name* DesignParam::intern_name(const char* script, const char* name, const char* suffix)
 {
-    // Use Telliamed's code to fetch the string. If it isn't set, just return false.
-    // FIXME: Can this be replaced with something cleaner?
-    char *value = GetParamString(design_note.c_str(), fullname.c_str(), NULL);
-    if(!value) return false;
+    const char* const pieces[3]  = { script, name, suffix ? suffix : "" };
+    size_t            lengths[3];
+    size_t            total = 0;
+    unsigned          hash  = DesignNote::HASH_SEED;
+
+    // Hash the pieces in turn, so the full name need not be built to find it
+    for(int piece = 0; piece < 3; ++piece) {
+        lengths[piece] = strlen(pieces[piece]);
+        total += lengths[piece];
+        hash   = DesignNote::hash_name(pieces[piece], lengths[piece], hash);
+    }
 
-    // Update the parameter value store; there's no need to retain the source string
-    parameter = value;
-    g_pMalloc -> Free(value);
+    // Keep the table no more than half full
+    if((name_count + 1) * 2 > name_slots.size())
+        grow_name_slots();
 
-    return true;
+    size_t slot = find_name_slot(pieces, lengths, total, hash);
+    if(!name_slots[slot]) {
+        DesignNote::Name* interned = new DesignNote::Name;
+        interned -> name.reserve(total);
+        for(int piece = 0; piece < 3; ++piece)
+            interned -> name.append(pieces[piece], lengths[piece]);
+        interned -> hash = hash;
+
+        name_slots[slot] = interned;
+        ++name_count;
+    }
+
+    return name_slots[slot];
 }
 
 
@@ -42,14 +129,19 @@ bool DesignParam::get_param_string(const std::string& design_note, std::string&
  *  DesignParamString
  */
 
-bool DesignParamString::init(const std::string& design_note, const std::string& default_value)
+bool DesignParamString::init(const DesignNote& design_note, const std::string& default_value)
 {
     // For string parameters, all we need to do is fetch the parameter as a string; no
     // validation or processing is needed beyond this.
-    bool valid = get_param_string(design_note, data);
+    const char* param = get_param(design_note);
+    bool valid = (param != NULL);
 
     // Allow for fallback if the parameter is not set in the design note
-    if(!valid) data = default_value;
+    if(valid) {
+        data = param;
+    } else {
+        data = default_value;
+    }
 
     is_set(valid);
 
@@ -62,11 +154,11 @@ bool DesignParamString::init(const std::string& design_note, const std::string&
  *  DesignParamFloat
  */
 
-bool DesignParamFloat::init(const std::string& design_note, const float default_value, const bool add_listeners)
+bool DesignParamFloat::init(const DesignNote& design_note, const float default_value, const bool add_listeners)
 {
-    std::string param;
+    const char* param = get_param(design_note);
 
-    bool valid = get_param_string(design_note, param);
+    bool valid = (param != NULL);
     if(valid) {
         // NOTE: In DesignParamFloat and all subclasses, `data` is a QVarCalculation!
         valid = data.init(param, default_value, add_listeners);
@@ -92,16 +184,15 @@ namespace {
      *  minutes). The value is converted to an int before placing
      *  it in the provided store variable.
      *
-     * @param param A string containing the time string to parse
+     * @param str   A pointer to the time string to parse
      * @param store A reference to an int to store the result in
      * @return true if the string contains a recognised time string,
      *         false if it appears not to (either it contains nothing
      *         the function can pars,e or it appears to contain more
      *         characters than a time string should).
      */
-    bool is_modified_time(const std::string& param, int& store)
+    bool is_modified_time(const char* str, int& store)
     {
-        const char* str = param.c_str();
         char* end;
 
         // Parse as a float, as '0.5s' or '2.5m' are valid times
@@ -131,35 +222,29 @@ namespace {
 }
 
 
-bool DesignParamTime::init(const std::string& design_note, int default_value, const bool add_listeners)
+bool DesignParamTime::init(const DesignNote& design_note, int default_value, const bool add_listeners)
 {
-    std::string param;
-
     // Fetch the raw string from the design note
-    bool valid = get_param_string(design_note, param);
-    is_set(valid);
+    const char* param = get_param(design_note);
+    is_set(param != NULL);
 
-    if(valid) {
+    if(param) {
         int store = default_value;
 
-        valid = is_modified_time(param, store);
-        if(valid) {
+        if(is_modified_time(param, store)) {
             // If we have a valid modified time value, we want to store it 'as is' in the
             // QVarEquation - we can do that by passing the equation an empty string and the
             // value to store as a default
-            return DesignParamInt::init("", store, add_listeners);
+            return data.init("", static_cast<float>(store));
         } else {
-            // Otherwise, this might be a qvar calc
-            return DesignParamInt::init(param, store, add_listeners);
+            // Otherwise, this might be a qvar calc. This must go straight to the
+            // calculation, as the value has already been fetched from the design note.
+            return data.init(param, static_cast<float>(store), add_listeners);
         }
-
-    // If fetch fails, fall back on the default
-    } else {
-        return DesignParamInt::init("", default_value);
     }
 
-
-    return false;
+    // If fetch fails, fall back on the default
+    return data.init("", static_cast<float>(default_value));
 }
 
 
@@ -172,14 +257,14 @@ namespace {
      *  A boolean is either 't', 'f', 'y', 'n', or either a
      *  number of a qvar string.
      *
-     * @param param A string containing the bool string to parse
+     * @param param A pointer to the bool string to parse
      * @param store A reference to a bool to store the result in
      * @return true if the string contains a recognised bool string,
      *         false if it appears not to (either it contains nothing
      *         the function can pars,e or it appears to contain more
      *         characters than a bool string should).
      */
-    bool is_boolean(const std::string& param, bool& store)
+    bool is_boolean(const char* param, bool& store)
     {
         const char first = tolower(param[0]);
 
@@ -196,34 +281,29 @@ namespace {
 }
 
 
-bool DesignParamBool::init(const std::string& design_note, bool default_value, const bool add_listeners)
+bool DesignParamBool::init(const DesignNote& design_note, bool default_value, const bool add_listeners)
 {
-    std::string param;
-
     // Fetch the raw string from the design note
-    bool valid = get_param_string(design_note, param);
-    is_set(valid);
+    const char* param = get_param(design_note);
+    is_set(param != NULL);
 
-    if(valid) {
+    if(param) {
         bool store = default_value;
 
-        valid = is_boolean(param, store);
-        if(valid) {
-            // If we have a valid modified time value, we want to store it 'as is' in the
+        if(is_boolean(param, store)) {
+            // If we have a valid boolean value, we want to store it 'as is' in the
             // QVarEquation - we can do that by passing the equation an empty string and the
             // value to store as a default
-            return DesignParamInt::init("", store ? 1 : 0, add_listeners);
+            return data.init("", store ? 1.0f : 0.0f);
         } else {
-            // Otherwise, this might be a qvar calc
-            return DesignParamInt::init(param, store ? 1 : 0, add_listeners);
+            // Otherwise, this might be a qvar calc. This must go straight to the
+            // calculation, as the value has already been fetched from the design note.
+            return data.init(param, store ? 1.0f : 0.0f, add_listeners);
         }
-
-    // If fetch fails, fall back on the default
-    } else {
-        return DesignParamInt::init("", static_cast<int>(default_value));
     }
 
-    return false;
+    // If fetch fails, fall back on the default
+    return data.init("", default_value ? 1.0f : 0.0f);
 }
 
 
@@ -232,14 +312,13 @@ bool DesignParamBool::init(const std::string& design_note, bool default_value, c
  */
 
 
-bool DesignParamCountMode::init(const std::string &design_note, CountMode default_value)
+bool DesignParamCountMode::init(const DesignNote& design_note, CountMode default_value)
 {
-    std::string param;
-
     // Fetch the raw string from the design note
-    bool valid = get_param_string(design_note, param);
+    const char* mstr = get_param(design_note);
+
+    bool valid = (mstr != NULL);
     if(valid) {
-        const char* mstr = param.c_str();
         char* end  = NULL;
 
         // First up, art thou an int?
@@ -276,20 +355,47 @@ bool DesignParamCountMode::init(const std::string &design_note, CountMode defaul
 
 
 /* ------------------------------------------------------------------------
- *  DesignParamTarget
+ *  TargetList
  */
 
-bool DesignParamTarget::init(const std::string& design_note, const std::string& default_value, const bool add_listeners)
+void TargetList::grow()
 {
-    std::string param;
+    TargetObj* grown = NULL;
+    if(transient)
+        grown = static_cast<TargetObj*>(MessageArena::allocate(capacity * 2 * sizeof(TargetObj)));
+
+    // Not handling a message, so the arena can't be used
+    bool heap = (grown == NULL);
+    if(heap)
+        grown = new TargetObj[capacity * 2];
 
+    std::copy(targets, targets + count, grown);
+
+    if(on_heap) delete[] targets;
+
+    targets   = grown;
+    capacity *= 2;
+    on_heap   = heap;
+}
+
+
+/* ------------------------------------------------------------------------
+ *  DesignParamTarget
+ */
+
+bool DesignParamTarget::init(const DesignNote& design_note, const std::string& default_value, const bool add_listeners)
+{
     // Fetch the raw string from the design note
-    bool valid = get_param_string(design_note, param);
-    if(!valid) {
-        param = default_value;
+    const char* value = get_param(design_note);
+
+    bool valid = (value != NULL);
+    if(valid) {
+        targetstr = value;
+    } else {
+        targetstr = default_value;
     }
 
-    targetstr = param;
+    const std::string& param = targetstr;
 
     // [me] is always going to be the host object ID
     if(param == "[me]") {
@@ -315,6 +421,22 @@ bool DesignParamTarget::init(const std::string& design_note, const std::string&
         mode = TARGET_INT;
     }
 
+    // Link definitions are parsed, and the flavour looked up, once here rather than
+    // every time the targets are needed
+    if(mode == TARGET_LINK) {
+        link_mode   = LM_BOTH;
+        link_random = link_weighted = link_all = false;
+        link_count  = 0;
+
+        const char* flavour = link_search_setup(targetstr.c_str(), &link_random, &link_weighted, &link_count, &link_all, &link_mode);
+        SService<ILinkToolsSrv> LinkToolsSrv(g_pScriptManager);
+        link_flavour = LinkToolsSrv -> LinkKindNamed(flavour);
+
+        link_cache.clear();
+        link_from  = 0;
+        link_total = 0;
+    }
+
     // Set up randomisation
     uint seed = std::chrono::system_clock::now().time_since_epoch().count();
     randomiser.seed(seed);
@@ -391,9 +513,9 @@ int DesignParamTarget::value(sScrMsg* msg)
 }
 
 
-std::vector<TargetObj>* DesignParamTarget::values(sScrMsg* msg)
+void DesignParamTarget::values(sScrMsg* msg, TargetList& matches)
 {
-    std::vector<TargetObj>* matches = new std::vector<TargetObj>;
+    matches.clear();
 
     float radius;
     bool  lessthan;
@@ -403,31 +525,31 @@ std::vector<TargetObj>* DesignParamTarget::values(sScrMsg* msg)
     switch(mode) {
         case TARGET_INT:
             newtarget.obj_id = objid_cache;
-            matches -> push_back(newtarget);
+            matches.push_back(newtarget);
 
             break;
 
         case TARGET_QVAR:
             newtarget.obj_id = static_cast<int>(qvar_calc.value());
-            matches -> push_back(newtarget);
+            matches.push_back(newtarget);
 
             break;
 
         case TARGET_SOURCE:
             newtarget.obj_id = msg -> from;
-            matches -> push_back(newtarget);
+            matches.push_back(newtarget);
 
             break;
 
         case TARGET_LINK:
-            link_search(matches, hostid(), targetstr.c_str());
+            link_search(&matches, hostid());
 
             break;
 
         case TARGET_ATYPE_DIRECT:
         case TARGET_ATYPE_INDIRECT:
             archname = targetstr.c_str();
-            archetype_search(matches, &archname[1], mode == TARGET_ATYPE_INDIRECT);
+            archetype_search(&matches, &archname[1], mode == TARGET_ATYPE_INDIRECT);
 
             break;
 
@@ -440,7 +562,7 @@ std::vector<TargetObj>* DesignParamTarget::values(sScrMsg* msg)
                 if(*archname == '*' || *archname == '@') ++realname;
 
                 // Default behaviour for radius search is to get all decendants unless * is specified.
-                archetype_search(matches, realname, *archname != '*', true, msg -> to, radius, lessthan);
+                archetype_search(&matches, realname, *archname != '*', true, msg -> to, radius, lessthan);
             }
 
             break;
@@ -448,8 +570,15 @@ std::vector<TargetObj>* DesignParamTarget::values(sScrMsg* msg)
         default: // Nothing here yet.
             break;
     }
+}
 
-    return matches;
+
+std::vector<TargetObj>* DesignParamTarget::values(sScrMsg* msg)
+{
+    TargetList matches(true);
+    values(msg, matches);
+
+    return new std::vector<TargetObj>(matches.begin(), matches.end());
 }
 
 
@@ -457,29 +586,24 @@ std::vector<TargetObj>* DesignParamTarget::values(sScrMsg* msg)
  *  Link Targetting
  */
 
-void DesignParamTarget::link_search(std::vector<TargetObj>* matches, const int from, const char* linkdef)
+void DesignParamTarget::link_search(TargetList* matches, const int from)
 {
-    std::vector<LinkScanWorker> links;
-    bool is_random = false, is_weighted = false, fetch_all = false;;
-    uint fetch_count = 0;
-    LinkMode mode = LM_BOTH;
-
-    // Parse the link definition, and fetch the list of possible matching links
-    const char* flavour = link_search_setup(linkdef, &is_random, &is_weighted, &fetch_count, &fetch_all, &mode);
-
-    uint count = link_scan(flavour, from, is_weighted, mode, links);
+    // Fetch the list of possible matching links
+    uint count = link_scan(from);
 
     if(count) {
+        uint fetch_count = link_count;
+
         // If no fetch count has been explicitly set, use the whole size, unless random is set
-        if(fetch_count < 1) fetch_count = is_random ? 1 : links.size();
+        if(fetch_count < 1) fetch_count = link_random ? 1 : link_cache.size();
 
         // if fetch_all has been set, set the count to the link count even in random mode
-        if(fetch_all) fetch_count = links.size();
+        if(link_all) fetch_count = link_cache.size();
 
-        if(is_random) {
-            select_random_links(matches, links, fetch_count, fetch_all, count, is_weighted);
+        if(link_random) {
+            select_random_links(matches, link_cache, fetch_count, link_all, count, link_weighted);
         } else {
-            select_links(matches, links, fetch_count);
+            select_links(matches, link_cache, fetch_count);
         }
     }
 }
@@ -574,72 +698,103 @@ const char* DesignParamTarget::parse_link_count(const char* linkdef, uint* fetch
 }
 
 
-uint DesignParamTarget::link_scan(const char* flavour, const int from, const bool weighted, LinkMode mode, std::vector<LinkScanWorker>& links)
+uint DesignParamTarget::link_scan(const int from)
 {
     // If there is no link flavour, do nothing
-    if(!flavour || !*flavour) return 0;
+    if(!link_flavour) return 0;
 
-    SService<ILinkToolsSrv> LinkToolsSrv(g_pScriptManager);
+    SService<ILinkSrv> LinkSrv(g_pScriptManager);
+    LinkScanWorker temp = { 0, 0, 0, 0 };
 
-    uint accumulator = 0;
-    long flavourid =  LinkToolsSrv -> LinkKindNamed(flavour);
-
-    if(flavourid) {
-        // At this point, we need to locate all the linked objects that match the flavour and mode
-        SService<ILinkSrv> LinkSrv(g_pScriptManager);
-        linkset matching_links;
-        LinkScanWorker temp = { 0, 0, 0, 0 };
-
-        // Traverse the list of links that match the selected flavour.
-        LinkSrv -> GetAll(matching_links, flavourid, from, 0);
-        while(matching_links.AnyLinksLeft()) {
-            // Get the common link information
-            temp.weight  = 1;
-            temp.link_id = matching_links.Link();
-            temp.dest_id = matching_links.Get().dest;
-
-            if(mode == LM_BOTH ||                            // If linkmode is both, let through any destination
-               (temp.dest_id < 0 && mode == LM_ARCHETYPE) || // Otherwisse, only let through archetypes or concrete if set
-               (temp.dest_id > 0 && mode == LM_CONCRETE)) {
-
-                // If weighting is enabled, fetch the weighting information from the link.
-                if(weighted) {
-                    const char* data = static_cast<const char* >(matching_links.Data());
-
-                    temp.weight = strtol(data, NULL, 10);
-                    if(temp.weight < 1) temp.weight = 1; // Force positive non-zero weights
-                    accumulator += temp.weight;
-                }
-
-                links.push_back(temp);
+    // Fetch the ID, destination, and weight of the current link, returning false if
+    // the destination is not one the link mode lets through.
+    auto read_link = [this](linkset& links, LinkScanWorker& entry) -> bool {
+        entry.weight  = 1;
+        entry.link_id = links.Link();
+        entry.dest_id = links.Get().dest;
+
+        if(link_mode == LM_BOTH ||                             // If linkmode is both, let through any destination
+           (entry.dest_id < 0 && link_mode == LM_ARCHETYPE) || // Otherwisse, only let through archetypes or concrete if set
+           (entry.dest_id > 0 && link_mode == LM_CONCRETE)) {
+
+            // If weighting is enabled, fetch the weighting information from the link.
+            if(link_weighted) {
+                const char* data = static_cast<const char* >(links.Data());
+
+                entry.weight = strtol(data, NULL, 10);
+                if(entry.weight < 1) entry.weight = 1; // Force positive non-zero weights
             }
 
-            matching_links.NextLink();
+            return true;
+        }
+
+        return false;
+    };
+
+    // The game can't tell the module when links change, so the links are always walked,
+    // but the cached list is only rebuilt when they differ from it. Link IDs are unique,
+    // so if every link is in the cache, and there are as many links as cached ones, the
+    // cache is still correct.
+    if(from == link_from) {
+        linkset current_links;
+        size_t  matched = 0;
+        bool    same    = true;
+
+        LinkSrv -> GetAll(current_links, link_flavour, from, 0);
+        for(; same && current_links.AnyLinksLeft(); current_links.NextLink()) {
+            if(!read_link(current_links, temp)) continue;
+
+            std::vector<LinkScanWorker>::const_iterator it = std::lower_bound(link_cache.begin(), link_cache.end(), temp);
+            same = (it != link_cache.end() && it -> link_id == temp.link_id && it -> dest_id == temp.dest_id && it -> weight == temp.weight);
+            ++matched;
+        }
+
+        if(same && matched == link_cache.size()) return link_total;
+    }
+
+    link_cache.clear();
+    link_from  = from;
+    link_total = 0;
+
+    // At this point, we need to locate all the linked objects that match the flavour and mode
+    linkset matching_links;
+
+    // Traverse the list of links that match the selected flavour.
+    LinkSrv -> GetAll(matching_links, link_flavour, from, 0);
+    for(; matching_links.AnyLinksLeft(); matching_links.NextLink()) {
+        if(read_link(matching_links, temp)) {
+            link_total += temp.weight;
+            link_cache.push_back(temp);
         }
     }
 
     // Ensure that the list is sorted by link IDs. In theory it already should be, but
     // this will guarantee it.
-    if(links.size() > 0)
-        std::sort(links.begin(), links.end());
+    if(link_cache.size() > 0)
+        std::sort(link_cache.begin(), link_cache.end());
 
-    if(weighted) {
-        return accumulator;
+    // Weighted selection searches the cumulative weights, which only need to be
+    // calculated when the list changes.
+    if(link_weighted) {
+        build_link_weightsums(link_cache);
     } else {
-        return links.size();
+        link_total = link_cache.size();
     }
+
+    return link_total;
 }
 
 
-bool DesignParamTarget::pick_weighted_link(std::vector<LinkScanWorker>& links, const uint target, TargetObj& store)
+bool DesignParamTarget::pick_weighted_link(const std::vector<LinkScanWorker>& links, const uint target, TargetObj& store)
 {
-    std::vector<LinkScanWorker>::iterator it;
+    // Cumulative weights only ever increase along the list, so the first link that
+    // reaches the target weight can be found with a binary search
+    std::vector<LinkScanWorker>::const_iterator it =
+        std::lower_bound(links.begin(), links.end(), target, [](const LinkScanWorker& link, const uint weight) { return link.cumulative < weight; });
 
-    for(it = links.begin(); it < links.end(); it++) {
-        if((*it).cumulative >= target) {
-            store = *it;
-            return true;
-        }
+    if(it != links.end()) {
+        store = *it;
+        return true;
     }
 
     return false;
@@ -660,23 +815,27 @@ uint DesignParamTarget::build_link_weightsums(std::vector<LinkScanWorker>& links
 }
 
 
-void DesignParamTarget::select_random_links(std::vector<TargetObj>* matches, std::vector<LinkScanWorker>& links, const uint fetch_count, const bool fetch_all, const uint total_weights, const bool is_weighted)
+void DesignParamTarget::select_random_links(TargetList* matches, std::vector<LinkScanWorker>& links, const uint fetch_count, const bool fetch_all, const uint total_weights, const bool is_weighted)
 {
-    // Yay for easy randomisation
-    std::shuffle(links.begin(), links.end(), randomiser);
-
     if(!is_weighted) {
         // Work out how many links to fetch, limiting it to the number available.
         uint count = fetch_all ? links.size() : fetch_count;
         if(count > links.size()) count = links.size();
 
+        // Only the links that will be returned need to be shuffled into place, which
+        // is the first `count` steps of a Fisher-Yates shuffle.
+        for(uint pos = 0; pos < count; ++pos) {
+            std::uniform_int_distribution<size_t> pick(pos, links.size() - 1);
+            std::swap(links[pos], links[pick(randomiser)]);
+        }
+
         select_links(matches, links, count);
 
     } else {
-        // Weighted selection needs cumulative weight information
-        if(is_weighted) build_link_weightsums(links);
-
-        TargetObj chosen;
+        // Weighted selection doesn't care about the order of the links, so there's
+        // no need to shuffle them, and the cumulative weights were calculated when
+        // the links were scanned.
+        TargetObj chosen = { 0, 0 };
 
         // Pick the requested number of links
         for(uint pass = 0; pass < fetch_count; ++pass) {
@@ -690,7 +849,7 @@ void DesignParamTarget::select_random_links(std::vector<TargetObj>* matches, std
 }
 
 
-void DesignParamTarget::select_links(std::vector<TargetObj>* matches, std::vector<LinkScanWorker>& links, const uint fetch_count)
+void DesignParamTarget::select_links(TargetList* matches, std::vector<LinkScanWorker>& links, const uint fetch_count)
 {
     uint copied = 0;
     TargetObj newtemp = { 0, 0 };
@@ -735,54 +894,32 @@ bool DesignParamTarget::radius_search(const char* target, float* radius, bool* l
 }
 
 
-void DesignParamTarget::archetype_search(std::vector<TargetObj>* matches, const char* archetype, bool do_full, bool do_radius, object from_obj, float radius, bool lessthan)
+void DesignParamTarget::archetype_search(TargetList* matches, const char* archetype, bool do_full, bool do_radius, object from_obj, float radius, bool lessthan)
 {
-    // Get handles to game interfaces here for convenience
-    SInterface<IObjectSystem> ObjectSys(g_pScriptManager);
-	SService<IObjectSrv>      ObjectSrv(g_pScriptManager);
-    SInterface<ITraitManager> TraitMgr(g_pScriptManager);
-
-    // These are only needed when doing radius searches
-    cScrVec from_pos, to_pos;
-    float   distance;
-    if(do_radius) ObjectSrv -> Position(from_pos, from_obj);
-
     // Find the archetype named if possible
-    object arch = ObjectSys -> GetObjectNamed(archetype);
+    object arch = ArchetypeCache::find(archetype);
     if(int(arch) <= 0) {
 
-        // Build the query flags
-        ulong flags = kTraitQueryChildren;
-        if(do_full) flags |= kTraitQueryFull; // If dofull is on, query direct and indirect descendants
-
-        // Ask for the list of matching objects
-        SInterface<IObjectQuery> query = TraitMgr -> Query(arch, flags);
-        if(query) {
-            TargetObj newtarget = { 0, 0 };
-
-            // Process each object, adding it to the match list if it's concrete.
-            for(; !query -> Done(); query -> Next()) {
-                newtarget.obj_id = query -> Object();
-                if(newtarget.obj_id > 0) {
-
-                    // Object is concrete, do we need to check it for distance?
-                    if(do_radius) {
-                        // Get the provisionally matched object's position, and work out how far it
-                        // is from the 'from' object.
-                        ObjectSrv -> Position(to_pos, newtarget.obj_id);
-                        distance = (float)from_pos.Distance(to_pos);
-
-                        // If the distance check passes, store the object.
-                        if((lessthan && (distance < radius)) || (!lessthan && (distance > radius))) {
-                            matches -> push_back(newtarget);
-                        }
-
-                    // No radius check needed, add straight to the list
-                    } else {
-                        matches -> push_back(newtarget);
-                    }
-                }
-            }
+        // Radius searches go through the archetype's grid, so that only objects
+        // near the 'from' object need to be checked
+        if(do_radius) {
+            SService<IObjectSrv> ObjectSrv(g_pScriptManager);
+
+            cScrVec from_pos;
+            ObjectSrv -> Position(from_pos, from_obj);
+
+            ArchetypeGrid::get(arch, do_full).search(matches, from_pos, radius, lessthan);
+            return;
+        }
+
+        // The concrete descendants are shared with every other script targetting this archetype
+        const std::vector<int>& objects = ArchetypeCache::descendants(arch, do_full);
+
+        TargetObj newtarget = { 0, 0 };
+        std::vector<int>::const_iterator it;
+        for(it = objects.begin(); it != objects.end(); ++it) {
+            newtarget.obj_id = *it;
+            matches -> push_back(newtarget);
         }
     }
 }
@@ -792,7 +929,7 @@ void DesignParamTarget::archetype_search(std::vector<TargetObj>* matches, const
  *  DesignParamCapacitor
  */
 
-bool DesignParamCapacitor::init(const std::string& design_note, int default_count, int default_falloff, bool default_limit)
+bool DesignParamCapacitor::init(const DesignNote& design_note, int default_count, int default_falloff, bool default_limit)
 {
     bool success = count.init(design_note, default_count);
 
@@ -809,20 +946,18 @@ bool DesignParamCapacitor::init(const std::string& design_note, int default_coun
 
 namespace {
 
-    void split_vec_string(const std::string &param, std::string &x, std::string &y, std::string &z)
+    void split_vec_string(const char* param, std::string &x, std::string &y, std::string &z)
     {
-        std::size_t from = 0;
-        std::size_t cpos = param.find(",");
+        const char* xend = strchr(param, ',');
 
-        if(cpos != std::string::npos) {
-            x = param.substr(from, cpos);
+        if(xend) {
+            x.assign(param, xend - param);
 
-            from = cpos + 1;
-            cpos = param.find(",", from);
+            const char* yend = strchr(xend + 1, ',');
 
-            if(cpos != std::string::npos) {
-                y = param.substr(from, cpos - from);
-                z = param.substr(cpos + 1);
+            if(yend) {
+                y.assign(xend + 1, yend - (xend + 1));
+                z = yend + 1;
             }
         }
     }
@@ -830,11 +965,11 @@ namespace {
 }
 
 
-bool DesignParamFloatVec::init(const std::string& design_note, const float def_x , const float def_y, const float def_z, const bool add_listeners)
+bool DesignParamFloatVec::init(const DesignNote& design_note, const float def_x , const float def_y, const float def_z, const bool add_listeners)
 {
-    std::string param;
+    const char* param = get_param(design_note);
 
-    bool valid = get_param_string(design_note, param);
+    bool valid = (param != NULL);
     if(valid) {
         std::string x, y, z;
 
@@ -93,6 +93,7 @@
 #include <string>
 #include <cmath>
 #include <random>
+#include "DesignNote.h"
 #include "QVarCalculation.h"
 
 /** A base class for design note parameters. This collects the common
@@ -109,9 +110,11 @@ public:
      * @param hostid The ID of the host object.
      * @param script The name of the script the parameter is attached to.
      * @param name   The name of the parameter.
+     * @param suffix An optional suffix for the name of the parameter, used by
+     *               compound parameters such as DesignParamCapacitor.
      */
-    DesignParam(const int hostid, const std::string& script, const std::string& name) :
-        host(hostid), script_name(script), param_name(name), fullname(script + name), set(false)
+    DesignParam(const int hostid, const char* script, const char* name, const char* suffix = NULL) :
+        host(hostid), fullname(intern_name(script, name, suffix)), set(false)
         { /* fnord */ }
 
 
@@ -148,23 +151,33 @@ protected:
         { return host; }
 
 
-    /** Fetch the value of the parameter as a string, and store the string in the
-     *  provided string reference. Note that this does not modify the 'set' value,
-     *  as subclasses may do additional validation on the string that determines
-     *  whether a valid value has be set.
+    /** Fetch the value of the parameter from the design note. Note that this does
+     *  not modify the 'set' value, as subclasses may do additional validation on
+     *  the string that determines whether a valid value has be set.
      *
-     * @param parameter A reference to a string to store the parameter in.
-     * @return true if the parameter was set in the design note, false if it was not
-     *         or could not be parsed from it.
+     * @param design_note A reference to the design note to fetch the parameter from.
+     * @return A pointer to the parameter value, which is owned by the design note,
+     *         or NULL if the parameter was not set in the design note.
      */
-    bool get_param_string(const std::string& design_note, std::string& parameter);
+    const char* get_param(const DesignNote& design_note) const
+        { return design_note.get(*fullname); }
 
 private:
-    int host;                //!< ID of the object this variable is attached to
-    std::string script_name; //!< The name of the script the parameter is for.
-    std::string param_name;  //!< The name of parameter this represents.
-    std::string fullname;    //!< The full name of the parameter (script_name + param_name)
-    bool        set;         //!< Was the value of this parameter set in the design note?
+    /** Obtain the shared record for the full name of a parameter. The names
+     *  used by a script class are the same for every instance of it, so
+     *  each distinct name is only stored once, and the records last for the
+     *  lifetime of the module.
+     *
+     * @param script The name of the script the parameter is attached to.
+     * @param name   The name of the parameter.
+     * @param suffix An optional suffix for the name of the parameter.
+     * @return A pointer to the record for script + name + suffix.
+     */
+    static const DesignNote::Name* intern_name(const char* script, const char* name, const char* suffix);
+
+    int                     host;     //!< ID of the object this variable is attached to
+    const DesignNote::Name* fullname; //!< The full name of the parameter (script name + parameter name), shared with other instances
+    bool                    set;      //!< Was the value of this parameter set in the design note?
 };
 
 
@@ -191,20 +204,20 @@ public:
      * @param script The name of the script the parameter is attached to.
      * @param name   The name of the parameter.
      */
-    DesignParamString(const int hostid, const std::string& script, const std::string& name) :
+    DesignParamString(const int hostid, const char* script, const char* name) :
         DesignParam(hostid, script, name), data("")
         { /* fnord */ }
 
 
     /** Initialise the DesignParamString based on the values specified.
      *
-     * @param design_note   A reference to a string containing the design note to parse
+     * @param design_note   A reference to the design note to fetch the parameter from
      * @param default_value The default value to set for the string. If not specified,
      *                      the empty string is used.
      * @return true on successful init (which may include when no parameter was set
      *         in the design note!), false if init failed.
      */
-    bool init(const std::string& design_note, const std::string& default_value = "");
+    bool init(const DesignNote& design_note, const std::string& default_value = "");
 
 
     /** Obtain the value of this design parameter. This will return the current
@@ -237,15 +250,17 @@ public:
      * @param hostid The ID of the host object.
      * @param script The name of the script the parameter is attached to.
      * @param name   The name of the parameter.
+     * @param suffix An optional suffix for the name of the parameter, used by
+     *               compound parameters such as DesignParamCapacitor.
      */
-    DesignParamFloat(const int hostid, const std::string& script, const std::string& name) :
-        DesignParam(hostid, script, name), data(hostid)
+    DesignParamFloat(const int hostid, const char* script, const char* name, const char* suffix = NULL) :
+        DesignParam(hostid, script, name, suffix), data(hostid)
         { /* fnord */ }
 
 
     /** Initialise the DesignParamFloat based on the values specified.
      *
-     * @param design_note   A reference to a string containing the design note to parse
+     * @param design_note   A reference to the design note to fetch the parameter from
      * @param default_value The default value to set for the float. If not specified,
      *                      0.0f is used.
      * @param add_listeners If true, request quest variable change messages for any quest
@@ -253,7 +268,7 @@ public:
      * @return true on successful init (which may include when no parameter was set
      *         in the design note!), false if init failed.
      */
-    bool init(const std::string& design_note, float default_value = 0.0f, const bool add_listeners = false);
+    bool init(const DesignNote& design_note, float default_value = 0.0f, const bool add_listeners = false);
 
 
     void unsubscribe()
@@ -286,15 +301,17 @@ public:
      * @param hostid The ID of the host object.
      * @param script The name of the script the parameter is attached to.
      * @param name   The name of the parameter.
+     * @param suffix An optional suffix for the name of the parameter, used by
+     *               compound parameters such as DesignParamCapacitor.
      */
-    DesignParamInt(const int hostid, const std::string& script, const std::string& name) :
-        DesignParamFloat(hostid, script, name)
+    DesignParamInt(const int hostid, const char* script, const char* name, const char* suffix = NULL) :
+        DesignParamFloat(hostid, script, name, suffix)
         { /* fnord */ }
 
 
     /** Initialise the DesignParamInt based on the values specified.
      *
-     * @param design_note   A reference to a string containing the design note to parse
+     * @param design_note   A reference to the design note to fetch the parameter from
      * @param default_value The default value to set for the int. If not specified,
      *                      0 is used.
      * @param add_listeners If true, request quest variable change messages for any quest
@@ -302,7 +319,7 @@ public:
      * @return true on successful init (which may include when no parameter was set
      *         in the design note!), false if init failed.
      */
-    bool init(const std::string& design_note, int default_value = 0, const bool add_listeners = false)
+    bool init(const DesignNote& design_note, int default_value = 0, const bool add_listeners = false)
         { return DesignParamFloat::init(design_note, static_cast<float>(default_value), add_listeners); }
 
 
@@ -329,15 +346,17 @@ public:
      * @param hostid The ID of the host object.
      * @param script The name of the script the parameter is attached to.
      * @param name   The name of the parameter.
+     * @param suffix An optional suffix for the name of the parameter, used by
+     *               compound parameters such as DesignParamCapacitor.
      */
-    DesignParamTime(const int hostid, const std::string& script, const std::string& name) :
-        DesignParamInt(hostid, script, name)
+    DesignParamTime(const int hostid, const char* script, const char* name, const char* suffix = NULL) :
+        DesignParamInt(hostid, script, name, suffix)
         { /* fnord */ }
 
 
     /** Initialise the DesignParamTime based on the values specified.
      *
-     * @param design_note   A reference to a string containing the design note to parse
+     * @param design_note   A reference to the design note to fetch the parameter from
      * @param default_value The default value to set for the time. If not specified,
      *                      0 is used.
      * @param add_listeners If true, request quest variable change messages for any quest
@@ -345,7 +364,7 @@ public:
      * @return true on successful init (which may include when no parameter was set
      *         in the design note!), false if init failed.
      */
-    bool init(const std::string& design_note, int default_value = 0, const bool add_listeners = false);
+    bool init(const DesignNote& design_note, int default_value = 0, const bool add_listeners = false);
 
 
     operator unsigned long() { return static_cast<unsigned long>(value()); }
@@ -362,15 +381,17 @@ public:
      * @param hostid The ID of the host object.
      * @param script The name of the script the parameter is attached to.
      * @param name   The name of the parameter.
+     * @param suffix An optional suffix for the name of the parameter, used by
+     *               compound parameters such as DesignParamCapacitor.
      */
-    DesignParamBool(const int hostid, const std::string& script, const std::string& name) :
-        DesignParamInt(hostid, script, name)
+    DesignParamBool(const int hostid, const char* script, const char* name, const char* suffix = NULL) :
+        DesignParamInt(hostid, script, name, suffix)
         { /* fnord */ }
 
 
     /** Initialise the DesignParamBool based on the values specified.
      *
-     * @param design_note   A reference to a string containing the design note to parse
+     * @param design_note   A reference to the design note to fetch the parameter from
      * @param default_value The default value to set for the time. If not specified,
      *                      0 is used.
      * @param add_listeners If true, request quest variable change messages for any quest
@@ -378,7 +399,7 @@ public:
      * @return true on successful init (which may include when no parameter was set
      *         in the design note!), false if init failed.
      */
-    bool init(const std::string& design_note, bool default_value = false, const bool add_listeners = false);
+    bool init(const DesignNote& design_note, bool default_value = false, const bool add_listeners = false);
 
 
     /** Obtain the value of this design parameter. This will return the current
@@ -412,20 +433,20 @@ public:
      * @param script The name of the script the parameter is attached to.
      * @param name   The name of the parameter.
      */
-    DesignParamCountMode(const int hostid, const std::string& script, const std::string& name) :
+    DesignParamCountMode(const int hostid, const char* script, const char* name) :
         DesignParamString(hostid, script, name), mode(CM_BOTH)
         { /* fnord */ }
 
 
     /** Initialise the DesignParamCountMode based on the values specified.
      *
-     * @param design_note   A reference to a string containing the design note to parse
+     * @param design_note   A reference to the design note to fetch the parameter from
      * @param default_value The default value to set for the mode. If not specified,
      *                      CM_BOTH is used.
      * @return true on successful init (which may include when no parameter was set
      *         in the design note!), false if init failed.
      */
-    bool init(const std::string& design_note, CountMode default_value = CM_BOTH);
+    bool init(const DesignNote& design_note, CountMode default_value = CM_BOTH);
 
 
     /** Obtain the value of this design parameter.
@@ -486,6 +507,101 @@ struct TargetObj {
 };
 
 
+/** A list of TargetObjs, used to hold the results of target searches. The
+ *  first INLINE_TARGETS targets are stored inside the list itself, so the
+ *  common case of a search matching a handful of objects needs no heap
+ *  allocation. Longer lists move to heap storage, which is kept for reuse
+ *  until the list is destroyed, so a list that is refilled repeatedly only
+ *  allocates when it needs to grow.
+ *
+ *  Transient lists, which are only used while handling a single message
+ *  (normally lists on the stack of a message handler), move to storage in
+ *  the MessageArena instead when it is available, so they never touch the
+ *  heap. Lists that are kept between messages must not be transient.
+ */
+class TargetList
+{
+public:
+    typedef TargetObj*       iterator;
+    typedef const TargetObj* const_iterator;
+
+    /** The number of targets that can be stored without allocating.
+     */
+    static const uint INLINE_TARGETS = 8;
+
+    /** Create an empty list.
+     *
+     * @param transient If true, the list will be destroyed before the message
+     *                  being handled is done with, so it may grow into the
+     *                  MessageArena.
+     */
+    explicit TargetList(const bool transient = false) : targets(inline_targets), count(0), capacity(INLINE_TARGETS), transient(transient), on_heap(false)
+        { /* fnord */ }
+
+    ~TargetList()
+        { if(on_heap) delete[] targets; }
+
+
+    /** Add a target to the end of the list.
+     *
+     * @param target A reference to the target to add.
+     */
+    void push_back(const TargetObj& target)
+    {
+        if(count == capacity) grow();
+        targets[count++] = target;
+    }
+
+
+    /** Remove all the targets from the list. This does not release any
+     *  storage the list has allocated.
+     */
+    void clear()
+        { count = 0; }
+
+    bool empty() const
+        { return !count; }
+
+    uint size() const
+        { return count; }
+
+    TargetObj& operator[](const uint pos)
+        { return targets[pos]; }
+
+    const TargetObj& operator[](const uint pos) const
+        { return targets[pos]; }
+
+    iterator begin()
+        { return targets; }
+
+    iterator end()
+        { return targets + count; }
+
+    const_iterator begin() const
+        { return targets; }
+
+    const_iterator end() const
+        { return targets + count; }
+
+private:
+    /** Double the capacity of the list, moving the targets to the arena or
+     *  the heap.
+     */
+    void grow();
+
+    // Copying would need to fix up the inline storage pointer, and nothing needs it.
+    TargetList(const TargetList&);
+    TargetList& operator=(const TargetList&);
+
+    TargetObj* targets;                        //!< The storage in use: inline_targets, an arena array, or a heap array
+    uint       count;                          //!< The number of targets in the list
+    uint       capacity;                       //!< The number of targets the storage can hold
+    bool       transient;                      //!< May the storage come from the MessageArena?
+    bool       on_heap;                        //!< Is the storage a heap array that must be freed?
+    TargetObj  inline_targets[INLINE_TARGETS]; //!< Storage for short lists
+};
+
+
 class DesignParamTarget : public DesignParam
 {
 public:
@@ -509,25 +625,34 @@ public:
      * @param script The name of the script the parameter is attached to.
      * @param name   The name of the parameter.
      */
-    DesignParamTarget(const int hostid, const std::string& script, const std::string& name) :
+    DesignParamTarget(const int hostid, const char* script, const char* name) :
         DesignParam(hostid, script, name),
         mode(TARGET_INVALID),
         objid_cache(0),
         qvar_calc(hostid),
         targetstr(""),
+        results(),
+        link_flavour(0),
+        link_mode(LM_BOTH),
+        link_random(false),
+        link_weighted(false),
+        link_all(false),
+        link_count(0),
+        link_from(0),
+        link_total(0),
         randomiser(0)
         { /* fnord */ }
 
 
     /** Initialise the DesignParamTarget based on the values specified.
      *
-     * @param design_note   A reference to a string containing the design note to parse
+     * @param design_note   A reference to the design note to fetch the parameter from
      * @param add_listeners If true, request quest variable change messages for any quest
      *                      variables in the design param.
      * @return true on successful init (which may include when no parameter was set
      *         in the design note!), false if init failed.
      */
-    bool init(const std::string& design_note, const std::string& default_value, const bool add_listeners = false);
+    bool init(const DesignNote& design_note, const std::string& default_value, const bool add_listeners = false);
 
 
     /** Obtain a single object ID from the target string. Note that this
@@ -540,6 +665,46 @@ public:
     int value(sScrMsg* msg = NULL);
 
 
+    /** Generate the list of objects the target parameter matches, storing them
+     *  in the specified list. Any targets already in the list are removed first.
+     *  This does not allocate unless the list needs to grow beyond its inline
+     *  storage, so callers should keep a TargetList on the stack or as a member
+     *  and reuse it.
+     *
+     * @param msg     A pointer to the message being handled. This is needed for
+     *                [source] targets and radius searches.
+     * @param matches A reference to the list to store the matched targets in.
+     */
+    void values(sScrMsg* msg, TargetList& matches);
+
+
+    /** Generate the list of objects the target parameter matches, storing them
+     *  in a list held by the parameter. This avoids the need for the caller to
+     *  provide a list, but the returned list is replaced the next time view()
+     *  is called, so it must not be used if the code processing the targets
+     *  could cause this parameter to be evaluated again (for example, by
+     *  sending messages to the targets).
+     *
+     * @param msg A pointer to the message being handled.
+     * @return A reference to the list of matched targets.
+     */
+    const TargetList& view(sScrMsg* msg)
+    {
+        values(msg, results);
+        return results;
+    }
+
+
+    /** Generate the list of objects the target parameter matches, in a newly
+     *  allocated vector.
+     *
+     * @deprecated Use values(sScrMsg*, TargetList&) or view() instead, as this
+     *             allocates the vector on every call.
+     *
+     * @param msg A pointer to the message being handled.
+     * @return A pointer to a vector of matched targets. The caller must delete
+     *         this when done with it.
+     */
     std::vector<TargetObj>* values(sScrMsg* msg);
 
 
@@ -626,11 +791,14 @@ protected:
      *
      *      #?!ControlDevice
      *
-     * @param matches A pointer to the vector to store object IDs in.
+     *  The link definition is parsed, and the flavour looked up, when the parameter
+     *  is initialised. The links found are cached, and only fetched again when
+     *  links of the flavour are added to or removed from the object.
+     *
+     * @param matches A pointer to the list to store object IDs in.
      * @param from    The ID of the object to search for links from.
-     * @param linkdef A pointer to a string describing the links to fetch.
      */
-    void link_search(std::vector<TargetObj>* matches, const int from, const char* linkdef);
+    void link_search(TargetList* matches, const int from);
 
 
     /* ------------------------------------------------------------------------
@@ -683,23 +851,21 @@ protected:
     const char* parse_link_count(const char* linkdef, uint* fetch_count);
 
 
-    /** Generate a list of current links of the specified flavour from this object, recording
-     *  the link ID and destination, and possibly weighting information if needed and
-     *  weighting is enabled.
+    /** Update the list of current links of the search flavour from the specified object,
+     *  recording the link ID and destination, and possibly weighting information if
+     *  weighting is enabled, in link_cache. The links are compared with the cached list,
+     *  which is only rebuilt if they have changed since it was last built.
      *
-     * @param flavour  The link flavour to include in the list.
-     * @param from     The ID of the object to fetch links from.
-     * @param weighted If true, weighting is enabled. `flavour` must be `ScriptParams` or `~ScriptParams`.
-     * @param mode     The link selection mode.
-     * @param links    A reference to a vector in which the list of links should be stored.
+     * @param from The ID of the object to fetch links from.
      * @return The accumulated weights if weighting is enabled, the number of links if it is
      *         not enabled, 0 indicates no matching links found.
      */
-    uint link_scan(const char* flavour, const int from, const bool weighted, LinkMode mode, std::vector<LinkScanWorker>& links);
+    uint link_scan(const int from);
 
 
     /** Select a link from the specified vector of links such that it has the target
-     *  cumulative weight, or is the closest greater weight.
+     *  cumulative weight, or is the closest greater weight. This is a binary search,
+     *  so it takes O(log n) time in the number of links.
      *
      * @param links  A reference to a list of LinkScanWorker structures containing weighted
      *               link information. This must be ordered by ascending cumulative weight.
@@ -707,7 +873,7 @@ protected:
      * @param store  A refrence to a TargetObj structure to store the link and object id in.
      * @return true if an item with the appropriate weight is located, false otherwise.
      */
-    bool pick_weighted_link(std::vector<LinkScanWorker>& links, const uint target, TargetObj& store);
+    bool pick_weighted_link(const std::vector<LinkScanWorker>& links, const uint target, TargetObj& store);
 
 
     /** Compute the cumulative weightings for the links in the supplied vector.
@@ -719,12 +885,14 @@ protected:
 
 
     /** Choose an appropriate number of links at random from the specified links list.
-     *  This will randomise the list, and then choose the requested number of links
-     *  from it. Note that if fetch_count > 1, this can produce duplicate entries in
-     *  the matches list. The links are chosen *at random*, with no exclusion of
-     *  already selected links!
+     *  Without weighting, this shuffles just enough of the list to bring the requested
+     *  number of links to its front, and then chooses them, so no link is chosen twice.
+     *  In weighted mode the list is not reordered, and must already contain cumulative
+     *  weights (see build_link_weightsums()). Note that in weighted mode, if fetch_count
+     *  > 1, this can produce duplicate entries in the matches list. The links are chosen
+     *  *at random*, with no exclusion of already selected links!
      *
-     * @param matches       A pointer to the vector to store object IDs in.
+     * @param matches       A pointer to the list to store object IDs in.
      * @param links         A reference to a vector of links.
      * @param fetch_count   The number of links to fetch.
      * @param fetch_all     Fetch all the links in a random order?
@@ -732,18 +900,18 @@ protected:
      * @param is_weighted   If true, do a weighted random selection, otherwise all links
      *                      can be selected equally.
      */
-    void select_random_links(std::vector<TargetObj>* matches, std::vector<LinkScanWorker>& links, const uint fetch_count, const bool fetch_all, const uint total_weights, const bool is_weighted);
+    void select_random_links(TargetList* matches, std::vector<LinkScanWorker>& links, const uint fetch_count, const bool fetch_all, const uint total_weights, const bool is_weighted);
 
 
     /** Copy the requested number of links from the link worker vector into the TargetObj
      *  list. Note that, as the links vector is sorted by link id, the chosen links will
      *  always be the same, given the same links list.
      *
-     * @param matches       A pointer to the vector to store object IDs in.
+     * @param matches       A pointer to the list to store object IDs in.
      * @param links         A reference to a vector of links.
      * @param fetch_count   The number of links to fetch.
      */
-    void select_links(std::vector<TargetObj>* matches, std::vector<LinkScanWorker>& links, const uint fetch_count);
+    void select_links(TargetList* matches, std::vector<LinkScanWorker>& links, const uint fetch_count);
 
 
     /* ------------------------------------------------------------------------
@@ -771,7 +939,7 @@ protected:
      *  can also filter the results based on the distance the concrete objects are
      *  from the specified object.
      *
-     * @param matches   A pointer to the vector to store object ids in.
+     * @param matches   A pointer to the list to store object ids in.
      * @param archetype The name of the archetype to search for. *Must not* include
      *                  and filtering (* or @) directives.
      * @param do_full   If false, only concrete objects that are direct descendants of
@@ -789,7 +957,7 @@ protected:
      * @param lessthan  If true, objects must fall within the sphere around from_obj,
      *                  if false they must be outside it.
      */
-    void archetype_search(std::vector<TargetObj>* matches, const char* archetype, bool do_full = false, bool do_radius = false, object from_obj = 0, float radius = 0.0f, bool lessthan = false);
+    void archetype_search(TargetList* matches, const char* archetype, bool do_full = false, bool do_radius = false, object from_obj = 0, float radius = 0.0f, bool lessthan = false);
 
 
 private:
@@ -799,6 +967,18 @@ private:
     int             objid_cache;  //!< Used by TARGET_INT to store the target object id
     QVarCalculation qvar_calc;    //!< In TARGET_QVAR, this stores the qvar/qvar calc
     std::string     targetstr;    //!< In TARGET_COMPLEX, this is the target string
+    TargetList      results;      //!< The list of targets returned by view()
+
+    long            link_flavour;    //!< In TARGET_LINK, the ID of the flavour to search for
+    LinkMode        link_mode;       //!< In TARGET_LINK, which link destinations to include
+    bool            link_random;     //!< In TARGET_LINK, should links be chosen at random?
+    bool            link_weighted;   //!< In TARGET_LINK, should random choices be weighted?
+    bool            link_all;        //!< In TARGET_LINK, should all links be returned?
+    uint            link_count;      //!< In TARGET_LINK, how many links to return, 0 for the default
+
+    std::vector<LinkScanWorker> link_cache; //!< In TARGET_LINK, the links found by the last scan
+    int             link_from;       //!< The object the cached links are from
+    uint            link_total;      //!< The number of cached links, or their total weight
 
     std::minstd_rand0 randomiser; //!< a random number generator for... random numbers.
 };
@@ -821,10 +1001,10 @@ public:
      * @param script The name of the script the parameter is attached to.
      * @param name   The name of the parameter.
      */
-    DesignParamCapacitor(const int hostid, const std::string& script, const std::string& name) :
+    DesignParamCapacitor(const int hostid, const char* script, const char* name) :
         count(hostid, script, name),
-        falloff(hostid, script, name + "Falloff"),
-        limit(hostid, script, name + "Limit")
+        falloff(hostid, script, name, "Falloff"),
+        limit(hostid, script, name, "Limit")
         { /* fnord */ }
 
 
@@ -834,12 +1014,12 @@ public:
      *  as we'd need to allow for readjustment after init and that's a cavern of
      *  woe and spiders.
      *
-     * @param design_note   A reference to a string containing the design note to parse
+     * @param design_note   A reference to the design note to fetch the parameter from
 
      * @return true on successful init (which may include when no parameter was set
      *         in the design note!), false if init failed.
      */
-    bool init(const std::string& design_note, int default_count = 0, int default_falloff = 0, bool default_limit = false);
+    bool init(const DesignNote& design_note, int default_count = 0, int default_falloff = 0, bool default_limit = false);
 
 
     /** Retrieve the value set for the capacitor count
@@ -875,7 +1055,7 @@ private:
 class DesignParamFloatVec : public DesignParam
 {
 public:
-    DesignParamFloatVec(const int hostid, const std::string& script, const std::string& name) :
+    DesignParamFloatVec(const int hostid, const char* script, const char* name) :
         DesignParam(hostid, script, name),
         x_calc(hostid), y_calc(hostid), z_calc(hostid),
         vect()
@@ -884,12 +1064,12 @@ public:
 
     /** Initialise the DesignParamFloatVec based on the values specified.
      *
-     * @param design_note   A reference to a string containing the design note to parse
+     * @param design_note   A reference to the design note to fetch the parameter from
 
      * @return true on successful init (which may include when no parameter was set
      *         in the design note!), false if init failed.
      */
-    bool init(const std::string& design_note, const float def_x = 0.0f, const float def_y = 0.0f, const float def_z = 0.0f, const bool add_listeners = false );
+    bool init(const DesignNote& design_note, const float def_x = 0.0f, const float def_y = 0.0f, const float def_z = 0.0f, const bool add_listeners = false );
 
 
     const cScrVec& value();
@@ -0,0 +1,83 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#include <vector>
+#include "MessageArena.h"
+
+unsigned MessageArena::depth = 0;
+
+namespace {
+    const size_t ALIGNMENT = 8; //!< Every allocation starts on a multiple of this
+
+    // Note that these must not allocate until they are used, as they are
+    // constructed before the module's allocator is available.
+    std::vector<char*> blocks; //!< The blocks normal allocations come from, kept between messages
+    std::vector<char*> large;  //!< Allocations too big for a block, freed when the arena is reset
+
+    size_t current = 0; //!< The index in blocks of the block being allocated from
+    size_t used    = 0; //!< How much of the current block has been allocated
+}
+
+
+/* ------------------------------------------------------------------------
+ *  Public interface
+ */
+
+void MessageArena::enter(void)
+{
+    ++depth;
+}
+
+
+void MessageArena::leave(void)
+{
+    if(!depth || --depth) return;
+
+    // The outermost message is done, so everything can go
+    current = 0;
+    used    = 0;
+
+    for(std::vector<char*>::iterator it = large.begin(); it != large.end(); ++it) {
+        delete[] *it;
+    }
+    large.clear();
+}
+
+
+void* MessageArena::allocate(const size_t size)
+{
+    if(!depth) return NULL;
+
+    size_t needed = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+
+    // Anything bigger than a quarter of a block would waste too much of it
+    if(needed > BLOCK_SIZE / 4) {
+        large.push_back(new char[needed]);
+        return large.back();
+    }
+
+    if(current < blocks.size() && used + needed > BLOCK_SIZE) {
+        ++current;
+        used = 0;
+    }
+
+    if(current == blocks.size())
+        blocks.push_back(new char[BLOCK_SIZE]);
+
+    char* storage = blocks[current] + used;
+    used += needed;
+
+    return storage;
+}
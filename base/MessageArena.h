@@ -0,0 +1,76 @@
+/** @file
+ * This file contains the interface for the MessageArena class, which provides
+ * storage that only needs to last while a message is being handled.
+ *
+ * @author Chris Page &lt;chris@starforge.co.uk&gt;
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef MESSAGEARENA_H
+#define MESSAGEARENA_H
+
+#include <cstddef>
+
+/** A module-wide bump allocator for transient storage. Allocations are
+ *  carved out of large blocks in turn and are never freed individually;
+ *  instead, everything is released at once when the outermost message being
+ *  handled has been dealt with. The blocks are kept for reuse, so once the
+ *  arena has grown to fit the busiest message, handling a message needs no
+ *  heap allocations at all.
+ *
+ *  Storage is only available while a message is being handled, as anything
+ *  allocated outside of a message could be released by any message sent
+ *  while it is still in use. Messages sent while handling another do not
+ *  release anything until the outer message is done with.
+ */
+class MessageArena
+{
+public:
+    static const size_t BLOCK_SIZE = 16384; //!< The size of the blocks the arena allocates from
+
+    /** Note that a message is being handled. Every call to this must be
+     *  matched by a call to leave().
+     */
+    static void enter(void);
+
+
+    /** Note that a message has been handled. If it was the outermost message,
+     *  everything allocated from the arena is released.
+     */
+    static void leave(void);
+
+
+    /** Is a message being handled, and hence is arena storage available?
+     *
+     * @return true if allocate() can be used, false otherwise.
+     */
+    static bool active(void)
+        { return depth != 0; }
+
+
+    /** Allocate storage from the arena. The storage is suitably aligned for
+     *  any of the module's types, and remains valid until the outermost message
+     *  being handled is done with.
+     *
+     * @param size The number of bytes to allocate.
+     * @return A pointer to the storage, or NULL if no message is being handled.
+     */
+    static void* allocate(const size_t size);
+
+private:
+    static unsigned depth; //!< How many messages are being handled
+};
+
+#endif // MESSAGEARENA_H
@@ -0,0 +1,136 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#include <lg/interface.h>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "DesignNote.h"
+#include "MessageAtom.h"
+#include "ScriptModule.h"
+
+namespace {
+    /** An interned message name.
+     */
+    struct AtomName {
+        std::string name; //!< The name, as it was first interned
+        unsigned    hash; //!< The case-insensitive hash of the name
+    };
+
+    // Note that these globals must not allocate until they are used, as they
+    // are constructed before the module's allocator is available.
+    std::vector<AtomName> names; //!< The interned names, indexed by atom
+    std::vector<MsgAtom>  slots; //!< Open-addressed hash table of atoms, MSG_NONE marks empty slots
+
+    /** The names of the standard atoms, in StandardMsgAtom order.
+     */
+    const char* const standard_names[MSG_STANDARD_COUNT] = {
+        "", "Sim", "Timer", "Null", "QuestChange", "EndScript", "ResetCount", "ResetTriggerCount", "DumpTrace",
+        "DarkGameModeChange", "DumpAllocStats"
+    };
+
+
+    /** Calculate a case-insensitive hash of the specified name, using the
+     *  same hash as design note parameter names.
+     */
+    unsigned name_hash(const char* name)
+    {
+        return DesignNote::hash_name(name, strlen(name));
+    }
+
+
+    /** Find the slot in the hash table that holds the specified name, or the
+     *  empty slot it would go in if it has not been interned.
+     */
+    size_t find_slot(const char* name, const unsigned hash)
+    {
+        size_t mask = slots.size() - 1;
+        size_t slot = hash & mask;
+
+        while(slots[slot] != MSG_NONE) {
+            const AtomName& atom = names[slots[slot]];
+            if(atom.hash == hash && !::_stricmp(atom.name.c_str(), name))
+                break;
+
+            slot = (slot + 1) & mask;
+        }
+
+        return slot;
+    }
+
+
+    /** Double the size of the hash table, and put all the atoms back into it.
+     */
+    void grow_slots()
+    {
+        slots.assign(slots.empty() ? 64 : slots.size() * 2, MSG_NONE);
+
+        for(MsgAtom atom = 1; atom < names.size(); ++atom)
+            slots[find_slot(names[atom].name.c_str(), names[atom].hash)] = atom;
+    }
+
+
+    /** Intern the specified name if it has not already been interned.
+     */
+    MsgAtom add_atom(const char* name, const unsigned hash)
+    {
+        // Keep the table no more than half full
+        if((names.size() + 1) * 2 > slots.size())
+            grow_slots();
+
+        size_t slot = find_slot(name, hash);
+        if(slots[slot] == MSG_NONE) {
+            AtomName atom = { name, hash };
+
+            slots[slot] = names.size();
+            names.push_back(atom);
+        }
+
+        return slots[slot];
+    }
+
+
+    /** Make sure the standard atoms have been interned. This is done the first
+     *  time any atom is needed, rather than at startup.
+     */
+    void add_standard_atoms()
+    {
+        if(!names.empty()) return;
+
+        AtomName none = { "", 0 };
+        names.push_back(none);
+
+        for(int atom = 1; atom < MSG_STANDARD_COUNT; ++atom)
+            add_atom(standard_names[atom], name_hash(standard_names[atom]));
+    }
+}
+
+
+/* ------------------------------------------------------------------------
+ *  Public interface
+ */
+
+MsgAtom intern_message(const char* name)
+{
+    if(!name) return MSG_NONE;
+
+    add_standard_atoms();
+
+    unsigned hash = name_hash(name);
+    size_t   slot = find_slot(name, hash);
+    if(slots[slot] != MSG_NONE) return slots[slot];
+
+    return add_atom(name, hash);
+}
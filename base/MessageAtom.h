@@ -0,0 +1,60 @@
+/** @file
+ * This file contains the interface for the message name interning functions.
+ * Message names are mapped to small integer atoms once, when a message
+ * arrives, so that scripts can decide how to handle it by comparing or
+ * indexing with the atom rather than by comparing strings.
+ *
+ * @author Chris Page &lt;chris@starforge.co.uk&gt;
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef MESSAGEATOM_H
+#define MESSAGEATOM_H
+
+/** An interned message name. Atoms are allocated in order from 1 as names are
+ *  interned, so they are suitable for use as indices into small tables.
+ */
+typedef unsigned MsgAtom;
+
+/** The atoms of the messages handled by the base script classes. These names
+ *  are always interned first, in this order, so their atoms are fixed.
+ */
+enum StandardMsgAtom {
+    MSG_NONE = 0,           //!< Not a message atom
+    MSG_SIM,                //!< "Sim"
+    MSG_TIMER,              //!< "Timer"
+    MSG_NULL,               //!< "Null"
+    MSG_QUESTCHANGE,        //!< "QuestChange"
+    MSG_ENDSCRIPT,          //!< "EndScript"
+    MSG_RESETCOUNT,         //!< "ResetCount"
+    MSG_RESETTRIGGERCOUNT,  //!< "ResetTriggerCount"
+    MSG_DUMPTRACE,          //!< "DumpTrace"
+    MSG_DARKGAMEMODECHANGE, //!< "DarkGameModeChange"
+    MSG_DUMPALLOCSTATS,     //!< "DumpAllocStats"
+    MSG_STANDARD_COUNT      //!< The number of standard atoms, including MSG_NONE
+};
+
+
+/** Obtain the atom for the specified message name, interning the name if it
+ *  has not been seen before. Names are matched case-insensitively, as the
+ *  game does not care about the case of message names. Atoms remain valid
+ *  for as long as the module is loaded.
+ *
+ * @param name The name of the message to obtain the atom for.
+ * @return The atom for the message name, or MSG_NONE if name is NULL.
+ */
+MsgAtom intern_message(const char* name);
+
+#endif // MESSAGEATOM_H
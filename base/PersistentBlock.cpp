@@ -0,0 +1,111 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#include <lg/interface.h>
+#include <lg/scrmanagers.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "PersistentBlock.h"
+#include "ScriptModule.h"
+
+namespace {
+    const char HEX_DIGITS[] = "0123456789abcdef";
+
+
+    /** Convert a hex digit to its value, or -1 if the character is not a hex digit.
+     */
+    int hex_value(const char digit)
+    {
+        if(digit >= '0' && digit <= '9') return digit - '0';
+        if(digit >= 'a' && digit <= 'f') return digit - 'a' + 10;
+        return -1;
+    }
+
+
+    /** Encode a block as its version number, a colon, and then the bytes of
+     *  the block in hex. The buffer must have space for 12 + size * 2 chars.
+     */
+    void encode(char* buffer, const uint version, const unsigned char* data, const size_t size)
+    {
+        char* pos = buffer + sprintf(buffer, "%u:", version);
+
+        for(size_t byte = 0; byte < size; ++byte) {
+            *pos++ = HEX_DIGITS[data[byte] >> 4];
+            *pos++ = HEX_DIGITS[data[byte] & 0x0F];
+        }
+        *pos = '\0';
+    }
+
+
+    /** Decode a block encoded by encode(), checking that it has the expected
+     *  version and size. The contents of data are undefined if this fails.
+     */
+    bool decode(const char* encoded, const uint version, unsigned char* data, const size_t size)
+    {
+        char* pos;
+        if(strtoul(encoded, &pos, 10) != version || *pos != ':') return false;
+        ++pos;
+
+        if(strlen(pos) != size * 2) return false;
+
+        for(size_t byte = 0; byte < size; ++byte) {
+            int high = hex_value(*pos++);
+            int low  = hex_value(*pos++);
+            if(high < 0 || low < 0) return false;
+
+            data[byte] = static_cast<unsigned char>((high << 4) | low);
+        }
+
+        return true;
+    }
+}
+
+
+PersistentData::PersistentData(const char* script_name, const int obj_id, const char* name, const uint version) :
+    dirty(false),
+    version(version)
+{
+    tag.objId    = obj_id;
+    tag.pszClass = script_name;
+    tag.pszName  = name;
+}
+
+
+bool PersistentData::load_data(void* data, const size_t size)
+{
+    sMultiParm param;
+    param.type = kMT_Undef;
+    g_pScriptManager -> GetScriptData(&tag, &param);
+
+    if(param.type != kMT_String) return false;
+
+    bool loaded = param.psz && decode(param.psz, version, static_cast<unsigned char*>(data), size);
+    g_pMalloc -> Free(param.psz);
+
+    return loaded;
+}
+
+
+void PersistentData::save_data(const void* data, const size_t size)
+{
+    char buffer[12 + MAX_BLOCK * 2];
+    encode(buffer, version, static_cast<const unsigned char*>(data), size);
+
+    sMultiParm param;
+    param.type = kMT_String;
+    param.psz  = buffer;
+    g_pScriptManager -> SetScriptData(&tag, &param);
+}
@@ -0,0 +1,182 @@
+/** @file
+ * This file contains the interface for the PersistentBlock class, which
+ * stores a structure of persistent script variables in a single script
+ * data entry.
+ *
+ * @author Chris Page &lt;chris@starforge.co.uk&gt;
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef PERSISTENTBLOCK_H
+#define PERSISTENTBLOCK_H
+
+#include <lg/config.h>
+#include <lg/scrmanagers.h>
+#include <cstddef>
+#include <type_traits>
+
+/** The untyped part of a PersistentBlock. This handles reading and writing
+ *  the block's contents to and from the script data, where it is stored as
+ *  a single string holding the block's version and its encoded contents.
+ */
+class PersistentData
+{
+public:
+    /** Note that the block's contents have changed, and need to be written
+     *  to the script data by the next save().
+     */
+    void touch(void)
+        { dirty = true; }
+
+
+    /** Determine whether the block's contents have changed since they were
+     *  loaded or last saved.
+     */
+    bool is_dirty(void) const
+        { return dirty; }
+
+    static const size_t MAX_BLOCK = 1024; //!< The largest block that can be stored, in bytes
+
+protected:
+    /** Create a new PersistentData object.
+     *
+     * @param script_name The name of the script that owns the data.
+     * @param obj_id      The ID of the object the script is attached to.
+     * @param name        The name of the script data entry to use. This is
+     *                    not copied, so it should be a string literal.
+     * @param version     The version of the layout of the data. Data stored
+     *                    with a different version is ignored.
+     */
+    PersistentData(const char* script_name, const int obj_id, const char* name, const uint version);
+
+
+    /** Read the block's contents from the script data.
+     *
+     * @param data A pointer to the buffer to store the contents in.
+     * @param size The size of the block's contents, at most MAX_BLOCK.
+     * @return true if the contents were read, false if there is no stored
+     *         data, or it has the wrong version or size.
+     */
+    bool load_data(void* data, const size_t size);
+
+
+    /** Write the block's contents to the script data.
+     *
+     * @param data A pointer to the block's contents.
+     * @param size The size of the block's contents, at most MAX_BLOCK.
+     */
+    void save_data(const void* data, const size_t size);
+
+    bool dirty; //!< Do the contents need to be written to the script data?
+
+private:
+    sScrDatumTag tag;     //!< The tag identifying the script data entry
+    uint         version; //!< The version of the data layout
+};
+
+
+/** A structure of persistent variables stored in one script data entry. This
+ *  replaces the separate script_int, script_float, etc variables a script
+ *  would otherwise use, so the savegame holds a single entry for the script
+ *  rather than one per variable, and the variables are read from the script
+ *  data once, when init() is called. Changes are kept in memory until save()
+ *  is called, which should be done from the owning script's save_state().
+ *
+ *  The structure must be plain old data, no larger than MAX_BLOCK bytes. If
+ *  its layout changes, the version should be increased, so that data saved
+ *  with the old layout is ignored.
+ */
+template <class T>
+class PersistentBlock : public PersistentData
+{
+    static_assert(std::is_pod<T>::value, "PersistentBlock can only store plain old data");
+    static_assert(sizeof(T) <= MAX_BLOCK, "PersistentBlock contents are larger than MAX_BLOCK");
+
+public:
+    /** Create a new PersistentBlock. init() must be called before the block's
+     *  contents are used.
+     *
+     * @param script_name The name of the script that owns the block.
+     * @param obj_id      The ID of the object the script is attached to.
+     * @param name        The name of the script data entry to store the block
+     *                    in. This should be a string literal.
+     * @param version     The version of the layout of T.
+     */
+    PersistentBlock(const char* script_name, const int obj_id, const char* name, const uint version = 1) :
+        PersistentData(script_name, obj_id, name, version),
+        data()
+        { /* fnord */ }
+
+
+    /** Load the block's contents from the script data. If there is no usable
+     *  data stored, the contents are set to the defaults and the block is
+     *  marked as needing to be saved.
+     *
+     * @param defaults The contents to use if no data has been stored yet.
+     * @return true if the contents were loaded from the script data, false if
+     *         the defaults were used.
+     */
+    bool init(const T& defaults)
+    {
+        if(load_data(&data, sizeof(T))) {
+            dirty = false;
+            return true;
+        }
+
+        data  = defaults;
+        dirty = true;
+        return false;
+    }
+
+
+    /** Obtain read-only access to the block's contents.
+     */
+    const T& get(void) const
+        { return data; }
+
+
+    /** Obtain access to the block's contents in order to change them. This
+     *  marks the block as needing to be saved.
+     */
+    T& modify(void)
+    {
+        dirty = true;
+        return data;
+    }
+
+
+    /** Obtain access to the block's contents for objects, like SavedCounter,
+     *  that call touch() themselves when they change them.
+     */
+    T& shared(void)
+        { return data; }
+
+
+    /** Write the block's contents to the script data if they have changed
+     *  since the block was loaded or last saved.
+     */
+    void save(void)
+    {
+        if(dirty) {
+            save_data(&data, sizeof(T));
+            dirty = false;
+        }
+    }
+
+private:
+    T data; //!< The block's contents
+};
+
+#endif // PERSISTENTBLOCK_H
@@ -15,8 +15,7 @@
  */
 
 #include <lg/interface.h>
-#include <lg/scrmanagers.h>
-#include <lg/scrservices.h>
+#include <algorithm>
 #include <cctype>
 #include <cstring>
 #include <cstdlib>
@@ -34,150 +33,396 @@
  * worry about making it less of an offering to Nyarlathotep later.
  */
 namespace {
-    /** Copy from a source string into a destination, discarding any
-     *  whitespace in the source. This is guaranteed to include the
-     *  nul at the end of the destination.
+    typedef QVarCalculation::CalcType CalcType;
+    typedef QVarCalculation::CalcStep CalcStep;
+
+    /** The deepest parentheses or unary minus nesting the compiler will accept.
+     *  This stops silly design notes from recursing the compiler off the end of
+     *  the stack.
+     */
+    const unsigned MAX_NESTING = 32;
+
+
+    /** Apply a binary operator to the specified values.
      *
-     * @param src A pointer to the start of the source string.
-     * @param dst A pointer to the start of the destination. This must
-     *            be at least `len` characters long.
-     * @param len The length of the destination string. If the source
-     *            string minus any whitespace is longer than this
-     *            length, the copy in the destination will be truncated.
-     * @return A pointer to the end of the destination string (the
-     *         nul at the end of the string).
+     * @param op  The operator to apply.
+     * @param lhs The value on the left side of the operator.
+     * @param rhs The value on the right side of the operator.
+     * @return The result of the operation. Division by zero produces 0.
      */
-    char* remove_whitespace(const char* src, char* dst, size_t len)
+    inline float apply_op(const CalcType op, const float lhs, const float rhs)
     {
-        --len; // account for nul terminator
-        while(*src && len) {
-            if(!isspace(*src)) {
-                *dst = *src;
-                ++dst;
-                --len;
-            }
-            ++src;
+        switch(op) {
+            case(QVarCalculation::CALCOP_ADD):  return (lhs + rhs); break;
+            case(QVarCalculation::CALCOP_SUB):  return (lhs - rhs); break;
+            case(QVarCalculation::CALCOP_MULT): return (lhs * rhs); break;
+            case(QVarCalculation::CALCOP_DIV):  if(rhs == 0.0f) return 0.0f; // prevent divide by zero
+                                                return (lhs / rhs);
+                break;
+            default: return lhs;
         }
-        *dst = '\0';
-
-        return dst;
     }
 
 
-    /** Obtain the character at an offset from a position in a string.
-     *  This does a bouinded character loopup on a string, applying an
-     *  offset to a pointer into the string, and ensuring that it can
-     *  not go out of bounds. Essentially, this is a lookaround function
-     *  needed by find_operator to do lookahead/behind.
+    /** Work out how deep the stack needs to be to evaluate the specified program.
      *
-     * @param sstart  A pointer to the start of the string.
-     * @param send    A pointer to the end of the string.
-     * @param current A pointer to a location within the string.
-     * @param offset  An offset relative to the current position to fetch
-     *                the character at.
-     * @return The character at the offset from the specified current
-     *         location, if it is within the bounds of the string. 0
-     *         if it falls outside the string.
+     * @param program A reference to the compiled calculation.
+     * @return The maximum stack depth reached while evaluating the program.
      */
-    char char_at(const char* sstart, const char* send, const char* current, int offset)
+    unsigned stack_depth(const std::vector<CalcStep>& program)
     {
-        current += offset;
-
-        if(current < sstart || current > send) {
-            return 0;
-        } else {
-            return *current;
+        unsigned depth = 0, deepest = 0;
+
+        std::vector<CalcStep>::const_iterator it;
+        for(it = program.begin(); it != program.end(); ++it) {
+            switch(it -> op) {
+                case(QVarCalculation::CALCOP_VALUE):
+                case(QVarCalculation::CALCOP_QVAR):   if(++depth > deepest) deepest = depth;
+                    break;
+                case(QVarCalculation::CALCOP_NEGATE): // Negation leaves the depth unchanged
+                    break;
+                default: --depth;
+                    break;
+            }
         }
+
+        return deepest;
     }
 
 
-    /** Determine whether the specified character is an operation character.
-     *  This will inspect the character provided and if it represents a
-     *  known calculation this will return the CalcType of the calculation.
+    /** Determine whether a calculation is a lone qvar name under the rules used
+     *  before calculations were compiled. Those rules ignored whitespace, and
+     *  only treated +, -, * or / as an operator if it came after a digit or a
+     *  letter, and before a '$', a digit, or a '-' and a digit. Names like
+     *  "$Q+foo" or "$Q(bar)" were therefore accepted, and designers may still
+     *  be relying on them, so calculations the compiler rejects are checked
+     *  with this before being given up on.
      *
-     * @param ch The character to check for operationhood.
-     * @return A CalcType for the character; if the character is not an
-     *         operation character, this returns CALCOP_NONE.
+     * @param calculation A pointer to the calculation to check.
+     * @param name        A reference to a string to store the qvar name in.
+     * @return true if the calculation is a lone qvar name, false otherwise.
      */
-    QVarCalculation::CalcType is_operator(const char ch)
+    bool legacy_qvar_name(const char* calculation, std::string& name)
     {
-        switch(ch) {
-            case('+'): return QVarCalculation::CALCOP_ADD;  break;
-            case('-'): return QVarCalculation::CALCOP_SUB;  break;
-            case('*'): return QVarCalculation::CALCOP_MULT; break;
-            case('/'): return QVarCalculation::CALCOP_DIV;  break;
+        name.clear();
+        for(; *calculation; ++calculation) {
+            if(!isspace(*calculation)) name += *calculation;
+        }
+
+        if(name.size() < 2 || name[0] != '$' || !isalpha(name[1])) return false;
+
+        for(size_t ch = 2; ch < name.size(); ++ch) {
+            if(!strchr("+-*/", name[ch])) continue;
+
+            const char prev  = name[ch - 1];
+            const char next  = (ch + 1 < name.size()) ? name[ch + 1] : '\0';
+            const char after = (ch + 2 < name.size()) ? name[ch + 2] : '\0';
+
+            if((next == '$' || isdigit(next) || (next == '-' && isdigit(after))) &&
+               (isdigit(prev) || isalpha(prev))) {
+                return false;
+            }
         }
 
-        return QVarCalculation::CALCOP_NONE;
+        name.erase(0, 1);
+        return true;
     }
 
 
-    /** Attempt to locate an operator within the specified buffer. This
-     *  will scan the buffer for a character that appears to be an
-     *  operator, and then checks that it meets the rules of operatorness.
-     *  If it does, a pointer to the operator is returned.
+    /** A recursive descent compiler for qvar calculations. This parses a
+     *  calculation using the grammar
      *
-     * @param buffer The buffer to scan for an operator
-     * @param endptr A pointer to the end of the buffer.
-     * @return A pointer to the operator on success, NULL if no valid
-     *         operator is found in the string.
+     *      expression = term *(("+" / "-") term)
+     *      term       = unary *(("*" / "/") unary)
+     *      unary      = "-" unary / primary
+     *      primary    = number / qvar / "(" expression ")"
+     *
+     *  with whitespace allowed between any of the tokens, and appends the
+     *  program needed to calculate it to a vector of CalcSteps in reverse
+     *  polish order. Operations on literal values are done as soon as they
+     *  are parsed, as are some on literals in chains of operations, as
+     *  described in emit_binary().
+     *
+     *  Quest variable names are a special case: the dark engine doesn't seem
+     *  to have *any restrictions* on quest variable names, so a name starts
+     *  with a letter after the '$', and runs until whitespace, a parenthesis,
+     *  or an operator. A '-' followed by a letter is treated as part of the
+     *  name, so "$Q-foobar" is a single qvar, but "$Qfoobar-1" is a
+     *  subtraction. Calculations that are a single qvar are
+     *  also accepted under the older, looser rules in legacy_qvar_name().
      */
-    char* find_operator(char* buffer, const char* endptr)
+    class CalcCompiler
     {
-        char* current = buffer;
-
-        // Starting at the end and working backwards may not may any real
-        // difference in practice,
-        while(current < endptr) {
-
-            // Does the current character look like an operator?
-            if(is_operator(*current) != QVarCalculation::CALCOP_NONE) {
-
-                // It can only really be an op if it's followed by '$', a digit,
-                // or '-' and a digit and preceeded by a digit, or a letter and
-                // the first char is $
-                if((char_at(buffer, endptr, current, 1) == '$' ||
-                    isdigit(char_at(buffer, endptr, current, 1)) ||
-                    (char_at(buffer, endptr, current, 1) == '-' && isdigit(char_at(buffer, endptr, current, 2))))
-                   &&
-                   (isdigit(char_at(buffer, endptr, current, -1)) ||
-                    (isalpha(char_at(buffer, endptr, current, -1)) && *buffer == '$'))) {
-                    return current;
+    public:
+        /** Create a compiler to compile the specified calculation.
+         *
+         * @param calculation A pointer to the calculation to compile.
+         * @param prog        A reference to the vector to store the program in.
+         * @param handles     A reference to the vector to store qvar handles in.
+         */
+        CalcCompiler(const char* calculation, std::vector<CalcStep>& prog, std::vector<QVarHandle>& handles) :
+            pos(calculation), nesting(0), program(prog), qvars(handles)
+            { /* fnord */ }
+
+
+        /** Compile the calculation.
+         *
+         * @return true if the whole calculation was compiled, false if the
+         *         calculation is not valid.
+         */
+        bool compile()
+        {
+            if(!parse_expression()) return false;
+
+            // Anything left over means the calculation is not valid.
+            skip_space();
+            return !*pos;
+        }
+
+    private:
+        void skip_space()
+        {
+            while(*pos && isspace(*pos)) ++pos;
+        }
+
+
+        bool parse_expression()
+        {
+            const size_t start = program.size();
+            if(!parse_term()) return false;
+
+            skip_space();
+            while(*pos == '+' || *pos == '-') {
+                const CalcType op = static_cast<CalcType>(*pos++);
+
+                const size_t rhs = program.size();
+                if(!parse_term()) return false;
+
+                emit_binary(op, start, rhs);
+                skip_space();
+            }
+
+            return true;
+        }
+
+
+        bool parse_term()
+        {
+            const size_t start = program.size();
+            if(!parse_unary()) return false;
+
+            skip_space();
+            while(*pos == '*' || *pos == '/') {
+                const CalcType op = static_cast<CalcType>(*pos++);
+
+                const size_t rhs = program.size();
+                if(!parse_unary()) return false;
+
+                emit_binary(op, start, rhs);
+                skip_space();
+            }
+
+            return true;
+        }
+
+
+        bool parse_unary()
+        {
+            skip_space();
+            if(*pos != '-') return parse_primary();
+
+            ++pos;
+            if(++nesting > MAX_NESTING) return false;
+
+            const size_t start = program.size();
+            if(!parse_unary()) return false;
+
+            emit_negate(start);
+            --nesting;
+
+            return true;
+        }
+
+
+        bool parse_primary()
+        {
+            skip_space();
+
+            if(*pos == '(') {
+                ++pos;
+                if(++nesting > MAX_NESTING) return false;
+
+                if(!parse_expression()) return false;
+
+                skip_space();
+                if(*pos != ')') return false;
+                ++pos;
+                --nesting;
+
+                return true;
+
+            } else if(*pos == '$') {
+                return parse_qvar();
+
+            // Numbers must start with a digit or a decimal point followed by one, so
+            // that strtof doesn't get a chance to accept things like "nan" or "inf"
+            } else if(isdigit(*pos) || (*pos == '.' && isdigit(*(pos + 1)))) {
+                return parse_number();
+            }
+
+            return false;
+        }
+
+
+        bool parse_number()
+        {
+            char* end = NULL;
+            CalcStep step = { QVarCalculation::CALCOP_VALUE, strtof(pos, &end), 0 };
+
+            if(end == pos) return false;
+            pos = end;
+
+            program.push_back(step);
+            return true;
+        }
+
+
+        bool parse_qvar()
+        {
+            ++pos; // skip the $
+
+            // qvar names must start with a letter
+            if(!isalpha(*pos)) return false;
+
+            const char* start = pos;
+            while(*pos && !isspace(*pos) && *pos != '(' && *pos != ')' && *pos != '+' && *pos != '*' && *pos != '/' &&
+                  (*pos != '-' || isalpha(*(pos + 1)))) {
+                ++pos;
+            }
+
+            // Qvars used more than once in a calculation only appear once in the handle list
+            CalcStep step = { QVarCalculation::CALCOP_QVAR, 0.0f, intern_qvar(std::string(start, pos - start)) };
+            if(std::find(qvars.begin(), qvars.end(), step.qvar) == qvars.end())
+                qvars.push_back(step.qvar);
+
+            program.push_back(step);
+            return true;
+        }
+
+
+        /** Add a binary operation to the program. If both sides of the operation
+         *  are literal values, the operation is done now, and the result replaces
+         *  them in the program. If only the right side is a literal, and the left
+         *  side is itself an operation of the same precedence with a literal on one
+         *  side, the two literals are combined, so `$a + 1 + 2` compiles to
+         *  `$a + 3`, and `2 * $a * 3` to `6 * $a`. Only the literal nearest the end
+         *  of the chain is combined, so `$a + 1 + $b + 2` is not folded.
+         *
+         * @param op    The operation to add.
+         * @param lhs   The index of the start of the program for the left side.
+         * @param rhs   The index of the start of the program for the right side.
+         */
+        void emit_binary(const CalcType op, const size_t lhs, const size_t rhs)
+        {
+            if(program.size() == rhs + 1 && program[rhs].op == QVarCalculation::CALCOP_VALUE) {
+                const float literal = program[rhs].value;
+
+                if(rhs == lhs + 1 && program[lhs].op == QVarCalculation::CALCOP_VALUE) {
+                    program[lhs].value = apply_op(op, program[lhs].value, literal);
+                    program.pop_back();
+                    return;
+                }
+
+                // The left side's last step is its outermost operation
+                const CalcType inner = program[rhs - 1].op;
+                if(rhs >= lhs + 3 && same_precedence(op, inner)) {
+                    const CalcType same    = is_additive(op) ? QVarCalculation::CALCOP_ADD : QVarCalculation::CALCOP_MULT;
+                    const CalcType inverse = is_additive(op) ? QVarCalculation::CALCOP_SUB : QVarCalculation::CALCOP_DIV;
+
+                    // x inner c op d is x inner (c same d) if op and inner match,
+                    // otherwise x inner (c inverse d)
+                    if(program[rhs - 2].op == QVarCalculation::CALCOP_VALUE) {
+                        program[rhs - 2].value = apply_op(op == inner ? same : inverse, program[rhs - 2].value, literal);
+                        program.pop_back();
+                        return;
+
+                    // c inner x op d is (c op d) inner x
+                    } else if(program[lhs].op == QVarCalculation::CALCOP_VALUE && is_operand(lhs + 1, rhs - 1)) {
+                        program[lhs].value = apply_op(op, program[lhs].value, literal);
+                        program.pop_back();
+                        return;
+                    }
                 }
             }
 
-            ++current;
+            CalcStep step = { op, 0.0f, 0 };
+            program.push_back(step);
         }
 
-        return NULL;
-    }
 
+        /** Determine whether an operation is an addition or subtraction.
+         */
+        static bool is_additive(const CalcType op)
+        {
+            return (op == QVarCalculation::CALCOP_ADD || op == QVarCalculation::CALCOP_SUB);
+        }
 
-    /** Attempt to parse the value in the specified string, and store it in
-     *  the provided variable.
-     *
-     * @param str   A pointer to a string containing the value to parse.
-     * @param store A reference to a float to store the parsed value in.
-     *              This will not be updated if the function returns false.
-     * @return true if the store has been updated with a parsed value, false
-     *         if it has not. Note that this will return true for partial
-     *         success (some part of `str` is not a valid number, but a value
-     *         was parsed from it).
-     */
-    bool parse_value(const char* str, float& store)
-    {
-        char* end = NULL;
 
-        float parsed = strtof(str, &end);
-        // Only update the store if something was parsed.
-        if(end != str) {
-            store = parsed;
+        /** Determine whether two steps are binary operations of the same precedence.
+         */
+        static bool same_precedence(const CalcType left, const CalcType right)
+        {
+            if(is_additive(left)) return is_additive(right);
+
+            return (right == QVarCalculation::CALCOP_MULT || right == QVarCalculation::CALCOP_DIV);
         }
 
-        // All we can really do is tell if /something/ has been parsed. We could
-        // required that *end == '\0' too, but that may be excessive
-        return (end != str);
-    }
+
+        /** Determine whether the steps from start up to, but not including, end
+         *  calculate a single value, rather than being part of a larger operation.
+         */
+        bool is_operand(const size_t start, const size_t end) const
+        {
+            int depth = 0;
+
+            for(size_t step = start; step < end; ++step) {
+                switch(program[step].op) {
+                    case(QVarCalculation::CALCOP_VALUE):
+                    case(QVarCalculation::CALCOP_QVAR):   ++depth;
+                        break;
+                    case(QVarCalculation::CALCOP_NEGATE):
+                        break;
+                    default: if(--depth < 1) return false;
+                        break;
+                }
+            }
+
+            return (depth == 1);
+        }
+
+
+        /** Add a negation to the program. Literal values are negated in place,
+         *  and a negation of a negation cancels out.
+         *
+         * @param operand The index of the start of the program for the operand.
+         */
+        void emit_negate(const size_t operand)
+        {
+            if(program.size() == operand + 1 && program[operand].op == QVarCalculation::CALCOP_VALUE) {
+                program[operand].value = -program[operand].value;
+            } else if(program.back().op == QVarCalculation::CALCOP_NEGATE) {
+                program.pop_back();
+            } else {
+                CalcStep step = { QVarCalculation::CALCOP_NEGATE, 0.0f, 0 };
+                program.push_back(step);
+            }
+        }
+
+        const char*              pos;     //!< The current position in the calculation
+        unsigned                 nesting; //!< How deeply nested the current parse is
+        std::vector<CalcStep>&   program; //!< The program being built
+        std::vector<QVarHandle>& qvars;   //!< The handles of the qvars used in the program
+    };
 }
 
 
@@ -185,62 +430,64 @@ namespace {
  *  Public interface functions
  */
 
-bool QVarCalculation::init(const std::string& calculation, const float default_value, const bool add_listeners)
+bool QVarCalculation::init(const char* calculation, const float default_value, const bool add_listeners)
 {
+    // Any listeners added by a previous init are no longer needed
+    unsubscribe();
+
     bool parsed = parse_calculation(calculation, default_value);
 
     // If listeners need to be added, sort that now
-    if(parsed && add_listeners) {
-        SService<IQuestSrv> quest_srv(g_pScriptManager);
-
-        if(!lhs_qvar.empty()) {
-            quest_srv -> SubscribeMsg(host, lhs_qvar.c_str(), kQuestDataAny);
-        }
-
-        if(!rhs_qvar.empty()) {
-            quest_srv -> SubscribeMsg(host, rhs_qvar.c_str(), kQuestDataAny);
+    if(parsed && add_listeners && !qvars.empty()) {
+        std::vector<QVarHandle>::const_iterator it;
+        for(it = qvars.begin(); it != qvars.end(); ++it) {
+            subscribe_qvar(host, *it);
         }
+        listening = true;
     }
 
     return parsed;
 }
 
 
-void QVarCalculation::unsubscribe() const
+void QVarCalculation::unsubscribe()
 {
-    SService<IQuestSrv> quest_srv(g_pScriptManager);
-
-    if(!lhs_qvar.empty()) {
-        quest_srv -> UnsubscribeMsg(host, lhs_qvar.c_str());
-    }
+    if(!listening) return;
 
-    if(!rhs_qvar.empty()) {
-        quest_srv -> UnsubscribeMsg(host, rhs_qvar.c_str());
+    std::vector<QVarHandle>::const_iterator it;
+    for(it = qvars.begin(); it != qvars.end(); ++it) {
+        unsubscribe_qvar(host, *it);
     }
+    listening = false;
 }
 
 
 float QVarCalculation::value()
 {
-    // Update the values from the qvars
-    if(!lhs_qvar.empty()) {
-        lhs_val = get_qvar(lhs_qvar, 0.0f);
+    // Calculations that use no qvars are always folded down to a single value
+    if(qvars.empty()) {
+        return program.empty() ? 0.0f : program.front().value;
     }
 
-    if(!rhs_qvar.empty()) {
-        rhs_val = get_qvar(rhs_qvar, 0.0f);
+    float    stack[MAX_STACK_DEPTH];
+    unsigned top = 0;
+
+    std::vector<CalcStep>::const_iterator it;
+    for(it = program.begin(); it != program.end(); ++it) {
+        switch(it -> op) {
+            case(CALCOP_VALUE):  stack[top++] = it -> value;
+                break;
+            case(CALCOP_QVAR):   stack[top++] = get_qvar(it -> qvar, 0.0f, host);
+                break;
+            case(CALCOP_NEGATE): stack[top - 1] = -stack[top - 1];
+                break;
+            default: --top;
+                     stack[top - 1] = apply_op(it -> op, stack[top - 1], stack[top]);
+                break;
+        }
     }
 
-    // Apply calculation, if any
-    switch(calc_op) {
-        case(CALCOP_ADD):  return (lhs_val + rhs_val); break;
-        case(CALCOP_SUB):  return (lhs_val - rhs_val); break;
-        case(CALCOP_MULT): return (lhs_val * rhs_val); break;
-        case(CALCOP_DIV):  if(rhs_val == 0.0f) return 0.0f; // prevent divide by zero
-                           return (lhs_val / rhs_val);
-            break;
-        default: return lhs_val;
-    }
+    return stack[0];
 }
 
 
@@ -248,116 +495,40 @@ float QVarCalculation::value()
  *  Calculation parser
  */
 
-bool QVarCalculation::parse_calculation(const std::string& calculation, const float default_value)
+bool QVarCalculation::parse_calculation(const char* calculation, const float default_value)
 {
-    // If there is no calculation, set the default and bug out
-    if(calculation.length() == 0) {
-        lhs_val = default_value;
-        calc_op = CALCOP_NONE;
-        return true;
-    }
-
-    char* buffer = new char[calculation.length() + 1];
-    if(!buffer) return false;
-
-    // working pointers for left and right sides of the calculation
-    char* leftside  = buffer;
-    char* rightside = NULL;
-
-    // Copy the calculation over, and get a pointer to the end of the string
-    char* endptr = remove_whitespace(calculation.c_str(), leftside, calculation.length() + 1);
+    program.clear();
+    qvars.clear();
 
-    /* So, what we have now is one of the following:
-     *
-     * 0. the empty string, endptr == leftside, no calculation, nothing to do
-     *
-     * 1. a number (potentially with sign and fractional part)
-     * 2. a qvar name (string of characters starting with $)
-     *
-     * 3. a number, an operator, a number (which we can always simplify to 1)
-     * 4. a number, an operator, a qvar
-     * 5. a qvar, an operator, a number
-     * 6. a qvar, an operator, a qvar
-     *
-     * Ignoring 0 - because it's boring - we need to establish some rules to
-     * prevent this becoming a cavern of woe and sorrow spiders. In particular,
-     * as far as qvars go, we have a problem: the dark engine doesn't seem to
-     * have *any restrictions* on quest variable names: literally ANY
-     * NUL-terminated ascii character string appears to be usable as a qvar
-     * name. In the pathological case, somthing like '$foobar-4.5*bob-3'
-     * /IS A VALID QUEST VAR NAME/. Needless to say, allowing such names would
-     * involve  of code to support calculations. So, rules:
-     *
-     * - for numbers:
-     *   - numbers must be fully specified; so .5 is not valid while 0.5 is.
-     *   - a leading - indicates a negative number.
-     *   - a leading + as an explicit positive is not supported.
-     *
-     * - for qvars:
-     *   - qvars must always be introduced with '$'
-     *   - if an operator appears in a qvar name, it MUST be followed by a
-     *     alphabet character (upper or lower case). So "Q-foobar" is valid,
-     *     but "Qfoobar-1" is not.
-     *
-     * From this we can state that operator is always:
-     *   - preceeded by either a digit, or an alphabet character if a '$'
-     *     has introduced a qvar.
-     *   - followed by either '$' (a qvar), a - and a digit, or a digit.
-     *
-     */
+    bool parsed = true;
 
-    bool parsed = false;
+    // An empty calculation is valid, and just produces the default. Anything else
+    // needs to be compiled, and must fit on the evaluation stack.
+    if(calculation && *calculation) {
+        CalcCompiler compiler(calculation, program, qvars);
 
-    // So, that situation 0 above....
-    if(leftside != endptr) {
+        parsed = compiler.compile() && stack_depth(program) <= MAX_STACK_DEPTH;
 
-        // Search for an operator
-        char* op = find_operator(leftside, endptr);
+        std::string name;
+        if(!parsed && legacy_qvar_name(calculation, name)) {
+            program.clear();
+            qvars.clear();
 
-        // If we have an operator, store and replace it with nul - that gives us a
-        // LHS at leftside, and a RHS at op + 1
-        if(op) {
-            calc_op = is_operator(*op);
-            *op = '\0';
-            rightside = op + 1;
-        }
+            CalcStep step = { CALCOP_QVAR, 0.0f, intern_qvar(name) };
+            program.push_back(step);
+            qvars.push_back(step.qvar);
 
-        // If we get here, regardless of whether the above found an operator, we
-        // have a LHS. This may be either a qvar (so, leading '$' followed by
-        // a letter), or a number. Note that malformed qvars will be treated
-        // as numbers, which should inevitably fail the parse_value() call
-        // and result in false from this function.
-        if(*leftside == '$' && strlen(leftside) > 1 && isalpha(*(leftside + 1))) {
-            lhs_qvar = ++leftside;
             parsed = true;
-        } else {
-            parsed = parse_value(leftside, lhs_val);
-        }
-
-        // rightside only does anything if there is one
-        if(rightside) {
-            if(*rightside == '$' && strlen(rightside) > 1 && isalpha(*(rightside + 1))) {
-                rhs_qvar = ++rightside;
-                parsed = true;
-            } else {
-                parsed = parse_value(rightside, rhs_val);
-            }
-        }
-
-        // optimise the situation where both sides are constants: we can
-        // do the calculation once, store it on the lhs, and kill the op
-        if(lhs_qvar.empty() && rhs_qvar.empty() && calc_op != CALCOP_NONE) {
-            lhs_val = value();
-            calc_op = CALCOP_NONE;
         }
     }
 
-    // No need to retain the temporary buffer anymore
-    delete buffer;
-
     // Handle default
-    if(!parsed) {
-        lhs_val = default_value;
+    if(!parsed || program.empty()) {
+        program.clear();
+        qvars.clear();
+
+        CalcStep step = { CALCOP_VALUE, default_value, 0 };
+        program.push_back(step);
     }
 
     return parsed;
@@ -22,44 +22,68 @@
 #define QVARCALCULATION_H
 
 #include <string>
+#include <vector>
+#include "QVarWrapper.h"
 
 /** This class provides a way to encapsulate quest variable calculations
- *  as given in the design note specification.
+ *  as given in the design note specification. Calculations are compiled
+ *  into a short program in reverse polish notation when the calculation
+ *  is initialised, with operations on literal values worked out then and
+ *  there, so that value() only needs to fetch the quest variables and run
+ *  through the program.
  */
 class QVarCalculation
 {
 
 public:
-    /** The supported calculation types
+    /** The operations that may appear in a compiled calculation.
      */
     enum CalcType {
-        CALCOP_NONE = '\0', //!< No operation, only LHS set
-        CALCOP_ADD  = '+',  //!< Add LHS and RHS
-        CALCOP_SUB  = '-',  //!< Subtract RHS from LHS
-        CALCOP_MULT = '*',  //!< Multiply the LHS and RHS
-        CALCOP_DIV  = '/'   //!< Divide the LHS by the RHS.
+        CALCOP_NONE   = '\0', //!< No operation
+        CALCOP_VALUE  = '#',  //!< Push a literal value onto the stack
+        CALCOP_QVAR   = '$',  //!< Push the value of a qvar onto the stack
+        CALCOP_NEGATE = '~',  //!< Negate the value on the top of the stack
+        CALCOP_ADD    = '+',  //!< Add LHS and RHS
+        CALCOP_SUB    = '-',  //!< Subtract RHS from LHS
+        CALCOP_MULT   = '*',  //!< Multiply the LHS and RHS
+        CALCOP_DIV    = '/'   //!< Divide the LHS by the RHS.
     };
 
 
+    /** A single step in a compiled calculation.
+     */
+    struct CalcStep {
+        CalcType   op;    //!< The operation to perform
+        float      value; //!< For CALCOP_VALUE, the value to push
+        QVarHandle qvar;  //!< For CALCOP_QVAR, the handle of the qvar to push
+    };
+
+
+    /** The maximum depth of the stack needed to evaluate a calculation.
+     *  Calculations that need more than this are rejected by init(), so
+     *  value() can always evaluate on a fixed size stack.
+     */
+    static const unsigned MAX_STACK_DEPTH = 16;
+
+
     /** Create a new QVarCalculation. This creates an empty, uninitialised
      *  calculation that must be initialised before it can produce useful
      *  values.
      *
      * @param hostid The ID of the object this calculation is attached to.
      */
-    QVarCalculation(int hostid) : host(hostid),
-                                  lhs_qvar("") , rhs_qvar(""),
-                                  lhs_val(0.0f), rhs_val(0.0f),
-                                  calc_op(CALCOP_NONE)
+    QVarCalculation(int hostid) : host(hostid), listening(false), program(), qvars()
         { /* fnord */ }
 
 
-    /** Initialise the QVarCalculation. This will attempt to parse the specified
-     *  calculation string into a left hand side, with possibly an operator and
-     *  a right-hand sidde. This implements the qvar-eq rule in the design
-     *  note specification.
+    /** Initialise the QVarCalculation. This will attempt to compile the
+     *  specified calculation. This implements the qvar-calc rule in the
+     *  design note specification: calculations may contain any number of
+     *  numbers and qvars, combined with +, -, * and /, using the usual
+     *  precedence rules. Parentheses may be used to group parts of the
+     *  calculation, and - may be used to negate a value.
      *
-     * @param calculation A reference to a string containing the qvar calculation
+     * @param calculation A pointer to a string containing the qvar calculation
      *                 to parse.
      * @param default_value The default value to fall back on if init fails.
      * @param add_listeners If true, add qvar change listeners for any qvars
@@ -69,46 +93,52 @@ public:
      * @return true if the QVarCalculation has been initialised successfully,
      *         false if it has not.
      */
-    bool init(const std::string& calculation, const float default_value = 0.0f, const bool add_listeners = false);
+    bool init(const char* calculation, const float default_value = 0.0f, const bool add_listeners = false);
+
+
+    /** Initialise the QVarCalculation. This is a convenience wrapper around
+     *  init(const char*, ...) for calculations held in strings.
+     */
+    bool init(const std::string& calculation, const float default_value = 0.0f, const bool add_listeners = false)
+        { return init(calculation.c_str(), default_value, add_listeners); }
 
 
     /** Remove any subscriptions created during init. If no subscriptions
-     *  were created, this does not need to be called, but it should be
-     *  safe to call regardless.
+     *  were created, this does not need to be called, but it is safe to
+     *  call regardless.
      */
-    void unsubscribe() const;
+    void unsubscribe();
 
 
     /** Retrieve the current value of the QVarCalculation. This will fetch the
      *  current value of any qvars used in the calculation, apply the
      *  calculation to the value, and return the result.
      *
-     * @return The result of the calculation. If init() has not been called, or
-     *         the right side of a calculation using the divide operator is
-     *         zero, this returns 0.
+     * @return The result of the calculation. If init() has not been called,
+     *         this returns 0. Any division by zero in the calculation also
+     *         produces 0.
      */
     float value(); // can't be const, as qvars may update values
 
 
 protected:
-    /** Given a parameter string, attempt to parse it as a qvar_eq.
+    /** Given a parameter string, attempt to compile it as a qvar-calc.
      *  This attempts to parse the specified string based on the rules
-     *  defined for the qvar_eq rule in the design_note.abnf file.
+     *  defined for the qvar-calc rule in the design_note.abnf file, and
+     *  replaces the current program with the compiled calculation.
      *
-     * @param parameter     A reference to a string containing the qvar_eq to parse.
+     * @param calculation   A pointer to a string containing the qvar-calc to parse.
      * @param default_value The default value to fall back on.
      * @return true if parsing completed successfully, false on error.
      */
-    bool parse_calculation(const std::string& calculation, const float default_value);
+    bool parse_calculation(const char* calculation, const float default_value);
 
 
 private:
-    int         host;     //!< The ID of the host object this calculation is attached to
-    std::string lhs_qvar; //!< The name of the qvar on the left side of any calculation, if any
-    std::string rhs_qvar; //!< The name of the qvar on the right side of any calculation
-    float       lhs_val;  //!< The literal value on the left side if no qvar specified
-    float       rhs_val;  //!< The literal value on the right side if no qvar specified
-    CalcType    calc_op;  //!< The operation to apply. If this is CALCOP_NONE, only the LHS is considered.
+    int                      host;      //!< The ID of the host object this calculation is attached to
+    bool                     listening; //!< Has the host been subscribed to changes in the qvars?
+    std::vector<CalcStep>    program;   //!< The compiled calculation, in reverse polish order
+    std::vector<QVarHandle>  qvars;     //!< The handles of the qvars used in the calculation, each listed once
 };
 
 #endif // QVARCALCULATION_H
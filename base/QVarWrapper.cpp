@@ -17,29 +17,268 @@
 #include <lg/interface.h>
 #include <lg/scrmanagers.h>
 #include <lg/scrservices.h>
+#include <lg/scrmsgs.h>
+#include <map>
 #include <string>
+#include <utility>
+#include <vector>
 #include <ScriptLib.h>
 #include "QVarWrapper.h"
 
+namespace {
+    /** Case-insensitive ordering for qvar names, as the game does not care
+     *  about the case of qvar names.
+     */
+    struct QVarNameLess {
+        bool operator()(const char* left, const char* right) const
+            { return ::_stricmp(left, right) < 0; }
+    };
+
+
+    /** An interned qvar name, and the cached value of the qvar. The cached
+     *  value is only used while the slot has a watcher, as nothing else will
+     *  tell the cache when the qvar changes.
+     */
+    struct QVarSlot {
+        const std::string* name;    //!< The name of the qvar, which is never freed
+        int                value;   //!< The value of the qvar when it was last read or changed
+        bool               exists;  //!< Did the qvar exist when it was last read or changed?
+        int                watcher; //!< The object whose subscription keeps the value up to date, 0 if none
+        uint               checked; //!< The frame in which the game was last asked whether the qvar exists
+    };
+
+
+    /** The subscriptions an object holds on a qvar. The object is subscribed
+     *  with the game while it has listeners or is watching the qvar for the
+     *  cache, so that it only gets one QuestChange message per change.
+     */
+    struct QVarSubscription {
+        int  listeners; //!< The number of subscribe_qvar() calls for the qvar
+        bool watching;  //!< Is the subscription keeping a cache slot up to date?
+    };
+
+
+    typedef std::map<const char*, QVarHandle, QVarNameLess>        QVarNames;
+    typedef std::map<std::pair<int, QVarHandle>, QVarSubscription> QVarSubscriptions;
+
+    // These must not allocate until they are used, as they are constructed before
+    // the module's allocator is available. The keys of qvar_names point into the
+    // names held by the slots, which are allocated separately so that they never
+    // move, and so that QuestChange messages can be looked up without copying
+    // the name.
+    std::vector<QVarSlot> qvar_slots;
+    QVarNames             qvar_names;
+    QVarSubscriptions     qvar_subscriptions;
+
+    uint frame_time; //!< The sim time of the message being handled
+    uint frame = 1;  //!< Counts the distinct sim times messages have been handled at
+
+
+    /** Fetch the subscription record for the specified object and qvar,
+     *  subscribing the object with the game if it has no subscription yet.
+     */
+    QVarSubscription& add_subscription(const int obj_id, const QVarHandle qvar)
+    {
+        std::pair<QVarSubscriptions::iterator, bool> added =
+            qvar_subscriptions.insert(std::make_pair(std::make_pair(obj_id, qvar), QVarSubscription()));
+
+        if(added.second) {
+            added.first -> second.listeners = 0;
+            added.first -> second.watching  = false;
+
+            SService<IQuestSrv> quest_srv(g_pScriptManager);
+            quest_srv -> SubscribeMsg(obj_id, qvar_slots[qvar].name -> c_str(), kQuestDataAny);
+        }
+
+        return added.first -> second;
+    }
+
+
+    /** Unsubscribe the object with the game if nothing is using the
+     *  specified subscription any more.
+     */
+    void drop_subscription(QVarSubscriptions::iterator sub)
+    {
+        if(sub -> second.listeners || sub -> second.watching) return;
+
+        SService<IQuestSrv> quest_srv(g_pScriptManager);
+        quest_srv -> UnsubscribeMsg(sub -> first.first, qvar_slots[sub -> first.second].name -> c_str());
+
+        qvar_subscriptions.erase(sub);
+    }
+
+
+    /** Fetch the value of the specified qvar, from the cache if it is being
+     *  watched, otherwise from the game.
+     *
+     * @param qvar    The handle of the qvar to fetch.
+     * @param value   A reference to an int to store the value in.
+     * @param watcher The object to watch the qvar with, or 0 to not watch it.
+     * @return true if the qvar exists, false if it does not.
+     */
+    bool read_qvar(const QVarHandle qvar, int& value, const int watcher)
+    {
+        QVarSlot& slot = qvar_slots[qvar];
+
+        // Deleting a qvar does not send a QuestChange, so the game is asked
+        // whether a cached qvar still exists, but only once per frame. Once it
+        // has gone, the value stays unset until a QuestChange recreates it.
+        if(slot.watcher) {
+            if(slot.exists && slot.checked != frame) {
+                SService<IQuestSrv> quest_srv(g_pScriptManager);
+                slot.exists  = quest_srv -> Exists(slot.name -> c_str());
+                slot.checked = frame;
+            }
+
+            value = slot.exists ? slot.value : 0;
+            return slot.exists;
+        }
+
+        SService<IQuestSrv> quest_srv(g_pScriptManager);
+        bool exists = quest_srv -> Exists(slot.name -> c_str());
+        value = exists ? quest_srv -> Get(slot.name -> c_str()) : 0;
+
+        if(watcher) {
+            add_subscription(watcher, qvar).watching = true;
+
+            slot.value   = value;
+            slot.exists  = exists;
+            slot.watcher = watcher;
+            slot.checked = frame;
+        }
+
+        return exists;
+    }
+}
+
+
+/* ------------------------------------------------------------------------
+ *  QVar name interning
+ */
+
+QVarHandle intern_qvar(const std::string& qvar)
+{
+    QVarNames::iterator found = qvar_names.lower_bound(qvar.c_str());
+    if(found != qvar_names.end() && !qvar_names.key_comp()(qvar.c_str(), found -> first))
+        return found -> second;
+
+    QVarHandle handle = static_cast<QVarHandle>(qvar_slots.size());
+
+    // Interned names last as long as the module does
+    QVarSlot slot = { new std::string(qvar), 0, false, 0, 0 };
+    qvar_slots.push_back(slot);
+    qvar_names.insert(found, std::make_pair(slot.name -> c_str(), handle));
+
+    return handle;
+}
+
+
+const std::string& qvar_name(const QVarHandle qvar)
+{
+    return *qvar_slots[qvar].name;
+}
+
+
 /* ------------------------------------------------------------------------
  *  QVar convenience functions
  */
 
-float get_qvar(const std::string& qvar, float def_val)
+float get_qvar(const QVarHandle qvar, float def_val, int watcher)
 {
-    SService<IQuestSrv> quest_srv(g_pScriptManager);
-    if(quest_srv -> Exists(qvar.c_str()))
-        return static_cast<float>(quest_srv -> Get(qvar.c_str()));
+    int value;
+    if(read_qvar(qvar, value, watcher))
+        return static_cast<float>(value);
 
     return def_val;
 }
 
 
-int get_qvar(const std::string& qvar, int def_val)
+int get_qvar(const QVarHandle qvar, int def_val, int watcher)
 {
-    SService<IQuestSrv> quest_srv(g_pScriptManager);
-    if(quest_srv -> Exists(qvar.c_str()))
-        return quest_srv -> Get(qvar.c_str());
+    int value;
+    if(read_qvar(qvar, value, watcher))
+        return value;
 
     return def_val;
 }
+
+
+void set_qvar(const QVarHandle qvar, const int value)
+{
+    SService<IQuestSrv> quest_srv(g_pScriptManager);
+    quest_srv -> Set(qvar_slots[qvar].name -> c_str(), value, kQuestDataMission);
+
+    // Update the cache now, rather than relying on the QuestChange arriving
+    // before the next read. Set() may deliver messages that intern more names,
+    // so the slot can only be looked up once it returns.
+    QVarSlot& slot = qvar_slots[qvar];
+    if(slot.watcher) {
+        slot.value  = value;
+        slot.exists = true;
+    }
+}
+
+
+/* ------------------------------------------------------------------------
+ *  QVar cache maintenance
+ */
+
+void subscribe_qvar(const int obj_id, const QVarHandle qvar)
+{
+    ++add_subscription(obj_id, qvar).listeners;
+}
+
+
+void unsubscribe_qvar(const int obj_id, const QVarHandle qvar)
+{
+    QVarSubscriptions::iterator sub = qvar_subscriptions.find(std::make_pair(obj_id, qvar));
+    if(sub == qvar_subscriptions.end() || !sub -> second.listeners) return;
+
+    --sub -> second.listeners;
+    drop_subscription(sub);
+}
+
+
+bool qvar_changed(const int obj_id, const sQuestMsg* msg)
+{
+    // Qvars that have never been interned can't be cached or subscribed to here
+    QVarNames::const_iterator found = qvar_names.find(msg -> m_pName);
+    if(found == qvar_names.end()) return true;
+
+    QVarSlot& slot = qvar_slots[found -> second];
+    if(slot.watcher) {
+        slot.value  = msg -> m_newValue;
+        slot.exists = true;
+    }
+
+    // Messages for subscriptions made outside subscribe_qvar() always go through
+    QVarSubscriptions::const_iterator sub = qvar_subscriptions.find(std::make_pair(obj_id, found -> second));
+    return (sub == qvar_subscriptions.end() || sub -> second.listeners);
+}
+
+
+void begin_qvar_frame(const uint time)
+{
+    if(time != frame_time) {
+        frame_time = time;
+        ++frame;
+    }
+}
+
+
+void release_qvar_watches(const int obj_id)
+{
+    QVarSubscriptions::iterator sub = qvar_subscriptions.lower_bound(std::make_pair(obj_id, QVarHandle(0)));
+
+    while(sub != qvar_subscriptions.end() && sub -> first.first == obj_id) {
+        QVarSubscriptions::iterator current = sub++;
+        if(!current -> second.watching) continue;
+
+        QVarSlot& slot = qvar_slots[current -> first.second];
+        if(slot.watcher == obj_id)
+            slot.watcher = 0;
+
+        current -> second.watching = false;
+        drop_subscription(current);
+    }
+}
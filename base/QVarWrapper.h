@@ -1,17 +1,88 @@
-
 #ifndef QVARWRAPPER_H
 #define QVARWRAPPER_H
 
 #include <string>
 
+struct sQuestMsg;
+
+/** A handle for an interned qvar name. Every use of a qvar name in the module
+ *  shares one copy of the name and one slot in the qvar cache, and looking
+ *  up the slot for a handle is an array index rather than a string search.
+ */
+typedef unsigned QVarHandle;
+
+/* QVar values are cached module-wide. Reading a qvar with a watcher object
+ * subscribes that object to changes in the qvar, and from then on the value
+ * is served from the cache, which is updated when the watcher receives a
+ * QuestChange message for the qvar. TWBaseScript passes every QuestChange
+ * its scripts receive to qvar_changed(), and releases the watches held by
+ * its object on EndScript via release_qvar_watches(). Deleting a qvar does
+ * not send a QuestChange, so cached reads check that the qvar still exists
+ * the first time it is read in each frame, as marked by begin_qvar_frame().
+ *
+ * The functions that take qvar names as strings intern the name on each
+ * call; code that uses a qvar repeatedly should intern the name once and
+ * keep the handle.
+ */
+
+/** Obtain the handle for the specified qvar name, adding the name to the
+ *  table of interned names if it is not already there. Names are matched
+ *  case-insensitively, as the game does not care about the case of qvar
+ *  names. Handles remain valid for as long as the module is loaded.
+ *
+ * @param qvar The name of the QVar to obtain a handle for.
+ * @return The handle for the QVar name.
+ */
+QVarHandle intern_qvar(const std::string& qvar);
+
+
+/** Obtain the name of the qvar with the specified handle.
+ *
+ * @param qvar The handle of the QVar to fetch the name of.
+ * @return A reference to the name of the QVar.
+ */
+const std::string& qvar_name(const QVarHandle qvar);
+
+
+/** Fetch the value in the specified QVar if it exists, return the default
+ *  if it does not.
+ *
+ * @param qvar    The handle of the QVar to return the value of.
+ * @param def_val The default value to return if the qvar does not exist.
+ * @param watcher If this is not zero, and the qvar is not already being
+ *                watched, the object with this ID is subscribed to changes
+ *                in the qvar so that later reads can use the cached value.
+ *                The object must be running a TWBaseScript-derived script.
+ * @return The QVar value, or the default specified.
+ */
+float get_qvar(const QVarHandle qvar, float def_val, int watcher = 0);
+
+
+/** Fetch the value in the specified QVar if it exists, return the default
+ *  if it does not.
+ *
+ * @param qvar    The handle of the QVar to return the value of.
+ * @param def_val The default value to return if the qvar does not exist.
+ * @param watcher If this is not zero, and the qvar is not already being
+ *                watched, the object with this ID is subscribed to changes
+ *                in the qvar so that later reads can use the cached value.
+ *                The object must be running a TWBaseScript-derived script.
+ * @return The QVar value, or the default specified.
+ */
+int get_qvar(const QVarHandle qvar, int def_val, int watcher = 0);
+
+
 /** Fetch the value in the specified QVar if it exists, return the default
  *  if it does not.
  *
  * @param qvar    The name of the QVar to return the value of.
  * @param def_val The default value to return if the qvar does not exist.
+ * @param watcher The object to watch the qvar with, or 0, as for the
+ *                QVarHandle version.
  * @return The QVar value, or the default specified.
  */
-float get_qvar(const std::string& qvar, float def_val);
+inline float get_qvar(const std::string& qvar, float def_val, int watcher = 0)
+    { return get_qvar(intern_qvar(qvar), def_val, watcher); }
 
 
 /** Fetch the value in the specified QVar if it exists, return the default
@@ -19,9 +90,77 @@ float get_qvar(const std::string& qvar, float def_val);
  *
  * @param qvar    The name of the QVar to return the value of.
  * @param def_val The default value to return if the qvar does not exist.
+ * @param watcher The object to watch the qvar with, or 0, as for the
+ *                QVarHandle version.
  * @return The QVar value, or the default specified.
  */
-int get_qvar(const std::string& qvar, int def_val);
+inline int get_qvar(const std::string& qvar, int def_val, int watcher = 0)
+    { return get_qvar(intern_qvar(qvar), def_val, watcher); }
+
+
+/** Set the value of the specified QVar, updating the cached value if the
+ *  qvar is being watched.
+ *
+ * @param qvar  The handle of the QVar to set.
+ * @param value The value to set for the QVar.
+ */
+void set_qvar(const QVarHandle qvar, const int value);
+
+
+/** Set the value of the specified QVar, updating the cached value if the
+ *  qvar is being watched.
+ *
+ * @param qvar  The name of the QVar to set.
+ * @param value The value to set for the QVar.
+ */
+inline void set_qvar(const std::string& qvar, const int value)
+    { set_qvar(intern_qvar(qvar), value); }
+
+
+/** Subscribe the specified object to QuestChange messages for a qvar. Unlike
+ *  calling SubscribeMsg() directly, this shares the engine subscription with
+ *  the qvar cache, so the object only receives one message per change.
+ *  Every call must be matched by a call to unsubscribe_qvar().
+ *
+ * @param obj_id The ID of the object that should receive QuestChange messages.
+ * @param qvar   The handle of the QVar to subscribe to.
+ */
+void subscribe_qvar(const int obj_id, const QVarHandle qvar);
+
 
+/** Remove a subscription added by subscribe_qvar().
+ *
+ * @param obj_id The ID of the object to unsubscribe.
+ * @param qvar   The handle of the QVar to unsubscribe from.
+ */
+void unsubscribe_qvar(const int obj_id, const QVarHandle qvar);
+
+
+/** Update the qvar cache in response to a QuestChange message.
+ *
+ * @param obj_id The ID of the object that received the message.
+ * @param msg    A pointer to the QuestChange message.
+ * @return true if the message should be passed on to the object's scripts,
+ *         false if the object only received it to keep the cache up to date.
+ */
+bool qvar_changed(const int obj_id, const sQuestMsg* msg);
+
+
+/** Note the sim time of the message about to be handled. Cached qvars are
+ *  checked with the game again the first time they are read after the sim
+ *  time changes, in case they have been deleted.
+ *
+ * @param time The sim time of the message.
+ */
+void begin_qvar_frame(const uint time);
+
+
+/** Release any qvar watches held by the specified object. The cached values
+ *  of the qvars it was watching are discarded, and will be fetched from the
+ *  game again the next time they are read.
+ *
+ * @param obj_id The ID of the object to release the watches of.
+ */
+void release_qvar_watches(const int obj_id);
 
 #endif // QVARWRAPPER_H
@@ -3,11 +3,27 @@
 #include "ScriptModule.h"
 #include "ScriptLib.h"
 
-void SavedCounter::init(int curr_time, int min_count, int max_count, int falloff_ms, bool cap_mode, bool limit_mode)
+void SavedCounter::init(PersistentData* owner, State* saved, bool restored, int curr_time, int min_count, int max_count, int falloff_ms, bool cap_mode, bool limit_mode)
 {
-    // Get the persistent variables initialised if needed
-    count.Init(0);
-    last_time.Init(curr_time);
+    block = owner;
+    state = saved;
+
+    // If there is no saved block yet, the state may still be in the separate
+    // variables used by older versions; carry it over, and drop the old data.
+    if(!restored) {
+        if(count.Valid()) {
+            state -> count = count;
+            state -> last_time = last_time.Valid() ? static_cast<int>(last_time) : curr_time;
+
+            count.Clear();
+            last_time.Clear();
+        } else {
+            state -> count = 0;
+            state -> last_time = curr_time;
+        }
+
+        block -> touch();
+    }
 
     // Negative values for min, max, or falloff make no sense, so zero them
     if(min_count  < 0) min_count  = 0;
@@ -34,7 +50,7 @@ void SavedCounter::init(int curr_time, int min_count, int max_count, int falloff
 
 bool SavedCounter::increment(int time, uint amount)
 {
-    int oldcount = static_cast<int>(count);
+    int oldcount = state -> count;
 
     // Let apply_falloff work out what the count should be before incrementing
     int newcount = apply_falloff(time, oldcount) + amount;
@@ -53,8 +69,9 @@ bool SavedCounter::increment(int time, uint amount)
         }
 
         // Update the stored variables as they shouldn't need fiddling with now
-        count = newcount;
-        last_time = time;
+        state -> count = newcount;
+        state -> last_time = time;
+        block -> touch();
     }
 
     return validcount;
@@ -63,21 +80,21 @@ bool SavedCounter::increment(int time, uint amount)
 
 int SavedCounter::apply_falloff(int time, int oldcount)
 {
-    int last = last_time; // Cache the script var to reduce read overhead...
-
     // Only bother working out the falloff if one is set, there is a count to reduce,
     // and a previous update time is available.
-    if(falloff && last && oldcount) {
-        int removed = (time - last) / falloff;
+    if(falloff && state -> last_time && oldcount) {
+        int removed = (time - state -> last_time) / falloff;
 
         // If one or more ticks have timed out, update the counter
         if(removed) {
             oldcount -= removed;
             if(oldcount < 0) oldcount = 0; // Negative use counts would be be bad!
 
-            last_time = time; // Made a change, so record that.
+            state -> last_time = time; // Made a change, so record that.
+            block -> touch();
         }
     }
 
     return oldcount;
 }
+
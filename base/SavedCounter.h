@@ -23,6 +23,7 @@
 
 #include <string>
 #include "scriptvars.h"
+#include "PersistentBlock.h"
 
 /** A class providing persistent use count and limiting facilities. This
  *  class simplifies the process of maintaining use counters, limiters,
@@ -31,10 +32,24 @@
  *  function **must** be called before any other member function,
  *  otherwise the behaviour of the counter is undefined (and probably
  *  exceptionally broken).
+ *
+ *  The count and update time are stored in a State structure inside a
+ *  PersistentBlock owned by the script, so that all of a script's counters
+ *  are loaded and saved together as a single script data entry. The counter
+ *  marks the block as changed whenever it updates its state, and the owning
+ *  script saves the block from save_state() shortly afterwards.
  */
 class SavedCounter
 {
 public:
+    /** The persistent state of a counter. Scripts should include one of these
+     *  in their PersistentBlock for each counter they use.
+     */
+    struct State {
+        int count;     //!< The current count
+        int last_time; //!< The sim time at which the count was last updated
+    };
+
     /** Create a new SavedCounter object, and initialise it. Note that the
      *  SavedCounter is not actually usable until init() has been called,
      *  as this can not safely finish setting up the count and last_time
@@ -42,6 +57,9 @@ public:
      *
      * @param script_name A pointer to a string containing the script's name.
      * @param obj_id      The ID of the object the script is attached to.
+     * @param name        The name of the counter, used to find the separate
+     *                    script data the counter was stored in by older
+     *                    versions of the module.
      * @return A new SavedCounter object. init() must be called before it is
      *         used!
      */
@@ -54,15 +72,20 @@ public:
         count_name(name + "name"),
         time_name(name + "time"),
         count(script_name, count_name.c_str(), obj_id),
-        last_time(script_name, time_name.c_str(), obj_id)
+        last_time(script_name, time_name.c_str(), obj_id),
+        block(NULL), state(NULL)
         { /* fnord */ }
 
 
     /** Initialise the variables in the SavedCounter object. This sets up the
-     *  variables in the object so that it can actually be used. The counter
-     *  is initialised to zero if it has not already been set in a previous
-     *  session.
+     *  variables in the object so that it can actually be used. If the
+     *  block holding the counter's state was not restored from the script
+     *  data, the state is taken from the counter's old script data if that
+     *  has been set in a previous session, and is set to zero otherwise.
      *
+     * @param owner      The block containing the counter's state.
+     * @param saved      The counter's state, inside the owner block.
+     * @param restored   true if the owner block was loaded from the script data.
      * @param curr_time  The current sim time.
      * @param min_count  The number of times the counter must be incremented before
      *                   increase_count() will return true. If this is 0, there is no
@@ -77,7 +100,7 @@ public:
      *                   the counter beyond max_count + 1 will be ignored. If cap_mode is
      *                   set, this is ignored.
      */
-    void init(int curr_time, int min_count = 0, int max_count = 0, int falloff_ms = 0, bool cap_mode = false, bool limit_mode = false);
+    void init(PersistentData* owner, State* saved, bool restored, int curr_time, int min_count = 0, int max_count = 0, int falloff_ms = 0, bool cap_mode = false, bool limit_mode = false);
 
 
     /** This will increment the counter and return true if the count - after the
@@ -98,7 +121,13 @@ public:
      * @param time The current sim time.
      */
     void reset(int time)
-        { count = 0; last_time = time; }
+        {
+            if(state) {
+                state -> count = 0;
+                state -> last_time = time;
+                block -> touch();
+            }
+        }
 
 
     /** Change the minimum number of times the counter must be incremented before
@@ -143,7 +172,7 @@ public:
         {
             if(minval) *minval = min;
             if(maxval) *maxval = max;
-            return count;
+            return state ? state -> count : 0;
         }
 
     bool enabled() const
@@ -151,9 +180,9 @@ public:
 
 private:
     /** Apply the falloff to the current count (if it is set) and return the updated
-     *  counter value. Note that this does not update the `count` member variable: it
-     *  is up to the caller to save the value back into `count` after any further
-     *  changes have been made to it.
+     *  counter value. Note that this does not update the `count_value` member variable:
+     *  it is up to the caller to store the value back into the state after any
+     *  further changes have been made to it.
      *
      * @param time     The current sim time.
      * @param oldcount The count value to apply falloff to.
@@ -168,10 +197,12 @@ private:
     bool capacitor;         //!< If true, and min is set, the counter works in capacitor mode.
     bool limit;             //!< If true, capacitor is off, and max is set, the counter works in limit mode.
     int  falloff;           //!< The time in milliseconds it takes for the count to decrease by 1.
-    std::string count_name; //!< Count variable name, needed as script_var doesn't copy name
-    std::string time_name;  //!< Time variable name
-    script_int count;       //!< The current count
-    script_int last_time;   //!< The sim time at which the count was last updated
+    std::string count_name; //!< Old count variable name, needed as script_var doesn't copy name
+    std::string time_name;  //!< Old time variable name
+    script_int count;       //!< The count as saved by older versions of the module
+    script_int last_time;   //!< The update time as saved by older versions of the module
+    PersistentData* block;  //!< The block containing the counter's state
+    State* state;           //!< The counter's state
 };
 
 #endif // SAVED_COUNTER_H
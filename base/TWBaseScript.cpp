@@ -13,20 +13,33 @@
 #include <cstring>
 #include <cstdlib>
 #include <cstdio>
-#include <cstdarg>
 
 #include "Version.h"
 #include "TWBaseScript.h"
 #include "ScriptModule.h"
 #include "ScriptLib.h"
+#include "QVarWrapper.h"
+#include "TraceLog.h"
+#include "AllocStats.h"
+#include "MessageArena.h"
 
 const char* const TWBaseScript::debug_levels[] = {"DEBUG", "WARNING", "ERROR"};
 const uint TWBaseScript::NAME_BUFFER_SIZE = 256;
+const char* const TWBaseScript::SAVE_TIMER = "TWSaveState";
+const uint TWBaseScript::SAVE_DELAY = 100;
 
 /* ------------------------------------------------------------------------
  *  Public interface exposed to the rest of the game
  */
 
+TWBaseScript::~TWBaseScript()
+{
+    // The game may be shutting every script down, so there is no point in
+    // moving the wheel's engine timer to another script.
+    TimerWheel::release(this, message_time, false);
+}
+
+
 STDMETHODIMP TWBaseScript::ReceiveMessage(sScrMsg* msg, sMultiParm* reply, eScrTraceAction trace)
 {
     long result = 0;
@@ -36,12 +49,21 @@ STDMETHODIMP TWBaseScript::ReceiveMessage(sScrMsg* msg, sMultiParm* reply, eScrT
     if(trace == kSpew)
         debug_printf(DL_DEBUG, "Got message '%s' at '%d'", msg -> message, msg -> time);
 
+    // Scripts may send messages to themselves while handling this one, so
+    // the previous atom needs to be put back afterwards.
+    MsgAtom previous_atom = current_atom;
+    current_atom = intern_message(msg -> message);
+
     message_time = msg -> time;
-    if(!::_stricmp(msg -> message, "Sim"))
+    begin_qvar_frame(msg -> time);
+    if(current_atom == MSG_SIM)
     {
         sim_running = static_cast<sSimMsg*>(msg) -> fStarting;
     }
 
+    AllocStats::enter(Name(), msg -> time);
+    MessageArena::enter();
+
     try {
         // Ensure that reply is always available, even if ReceiveMessage was called with it NULL
         sMultiParm fallback;
@@ -49,6 +71,19 @@ STDMETHODIMP TWBaseScript::ReceiveMessage(sScrMsg* msg, sMultiParm* reply, eScrT
             reply = &fallback;
 
         result = dispatch_message(msg, reply);
+
+        // Scripts are not told when the game is about to be saved, so changes
+        // are written out by a wheel timer shortly after they are made, letting
+        // a burst of messages share one write. They are written straight away
+        // if the sim or game mode changes, as the player may be about to save,
+        // or if the script is ending.
+        if(current_atom == MSG_SIM || current_atom == MSG_DARKGAMEMODECHANGE || current_atom == MSG_ENDSCRIPT) {
+            cancel_wheel_timer(save_timer);
+            save_timer = 0;
+            save_state();
+        } else if(!save_timer && state_changed()) {
+            save_timer = set_wheel_timer(SAVE_TIMER, SAVE_DELAY);
+        }
     }
     // Prevent exceptions from getting out into the rest of the game
     catch (std::exception& err) {
@@ -60,6 +95,15 @@ STDMETHODIMP TWBaseScript::ReceiveMessage(sScrMsg* msg, sMultiParm* reply, eScrT
         result = S_FALSE;
     }
 
+    // Anything allocated while handling the message is no longer needed
+    MessageArena::leave();
+    AllocStats::leave();
+    current_atom = previous_atom;
+
+    // Anything logged while handling the message can be printed now that the
+    // script has finished with it
+    DebugLog::flush();
+
     return result;
 }
 
@@ -72,7 +116,9 @@ TWBaseScript::MsgStatus TWBaseScript::on_message(sScrMsg* msg, cMultiParm& reply
 {
     // Handle setting up the script from the design note
     if(!done_init) {
-        init(msg -> time);
+        DesignNote design_note(ObjId());
+
+        init(msg -> time, design_note);
         done_init = true;
     }
 
@@ -151,59 +197,11 @@ bool TWBaseScript::clear_script_data(const char* name, cMultiParm& data)
  *  Debugging support
  */
 
-void TWBaseScript::debug_printf(TWBaseScript::DebugLevel level, const char* format, ...)
-{
-    va_list args;
-    std::string name;
-    char buffer[900]; // Temporary buffer, 900 is the limit imposed by MPrint. This is really nasty and needs fixing.
-
-    // Need the name of the current object
-    get_object_namestr(name);
-
-    // build the string the caller requested
-    va_start(args, format);
-    _vsnprintf(buffer, 899, format, args);
-    va_end(args);
-
-    // And spit out the result to monolog
-	g_pfnMPrintf("%s[%s(%s)]: %s\n", debug_levels[level], Name(), name.c_str(), buffer);
-}
-
-
 void TWBaseScript::get_object_namestr(std::string& name, object obj_id)
 {
     char namebuffer[NAME_BUFFER_SIZE];
 
-    // NOTE: obj_name isn't freed when GetName sets it to non-NULL. As near
-    // as I can tell, it doesn't need to, it only needs to be freed when
-    // using the version of GetName in ObjectSrv... Probably. Maybe. >.<
-    // The docs for this are pretty shit, so this is mostly guesswork.
-
-    SInterface<IObjectSystem> ObjSys(g_pScriptManager);
-    const char* obj_name = ObjSys -> GetName(obj_id);
-
-    // If the object system has returned a name here, the concrete object
-    // has been given a name, so use it
-    if(obj_name) {
-        snprintf(namebuffer, NAME_BUFFER_SIZE, "%s (%d)", obj_name, int(obj_id));
-
-    // Otherwise, the concrete object has no name, get its archetype name
-    // if possible and use that instead.
-    } else {
-        SInterface<ITraitManager> TraitMan(g_pScriptManager);
-        object archetype_id = TraitMan -> GetArchetype(obj_id);
-        const char* archetype_name = ObjSys -> GetName(archetype_id);
-
-        // Archetype name found, use it in the string
-        if(archetype_name) {
-            snprintf(namebuffer, NAME_BUFFER_SIZE, "A %s (%d)", archetype_name, int(obj_id));
-
-        // Can't find a name or archetype name (!), so just use the ID
-        } else {
-            snprintf(namebuffer, NAME_BUFFER_SIZE, "%d", int(obj_id));
-        }
-    }
-
+    DebugLog::object_name(namebuffer, NAME_BUFFER_SIZE, obj_id);
     name = namebuffer;
 }
 
@@ -214,6 +212,19 @@ void TWBaseScript::get_object_namestr(std::string& name)
 }
 
 
+const char* TWBaseScript::object_name(object obj_id)
+{
+    static char fallback[NAME_BUFFER_SIZE];
+
+    char* namebuffer = static_cast<char*>(MessageArena::allocate(NAME_BUFFER_SIZE));
+    if(!namebuffer) namebuffer = fallback;
+
+    DebugLog::object_name(namebuffer, NAME_BUFFER_SIZE, obj_id);
+
+    return namebuffer;
+}
+
+
 /* ------------------------------------------------------------------------
  *  Link inspection
  */
@@ -293,17 +304,9 @@ int TWBaseScript::get_linked_object(const int from, const std::string& obj_name,
  *  Initialisation related
  */
 
-void TWBaseScript::init(int time)
+void TWBaseScript::init(int time, const DesignNote& design_note)
 {
-    char* design_note = GetObjectParams(ObjId());
-
-    if(design_note) {
-        debug.init(design_note);
-
-        g_pMalloc -> Free(design_note);
-    } else {
-        debug.init("");
-    }
+    debug.init(design_note);
 
     if(debug_enabled()) {
         debug_printf(DL_DEBUG, "Attached %s version %s", Name(), SCRIPT_VERSTRING);
@@ -321,11 +324,11 @@ long TWBaseScript::dispatch_message(sScrMsg* msg, sMultiParm* reply)
     // Only bother checking for fixup stuff if it hasn't been done.
     if(need_fixup) {
         // On starting sim, fix any links if possible
-        if(!::_stricmp(msg -> message, "Sim") && static_cast<sSimMsg*>(msg) -> fStarting) {
+        if(current_atom == MSG_SIM && static_cast<sSimMsg*>(msg) -> fStarting) {
             fixup_player_links();
 
         // Catch and handle the deferred player link fixup if needed
-        } else if(!::_stricmp(msg -> message, "Timer") &&
+        } else if(current_atom == MSG_TIMER &&
                   !::_stricmp(static_cast<sScrTimerMsg*>(msg) -> name, "DelayInit") &&
                   static_cast<sScrTimerMsg*>(msg) -> data == "FixupPlayerLinks") { // Note: data is a cMultiParm, so == does a strcmp internally
             fixup_player_links();
@@ -334,7 +337,50 @@ long TWBaseScript::dispatch_message(sScrMsg* msg, sMultiParm* reply)
 
     // Capture and bin Null messages (to prevent TornOn/TurnOff triggering in
     // subclasses when the TirnOn/TurnOff message has been set to Null)
-    if(!::_stricmp(msg -> message, "Null")) {
+    if(current_atom == MSG_NULL) {
+        return S_OK;
+
+    // Keep the qvar cache up to date, and drop any changes this object only
+    // received because it is watching the qvar for the cache
+    } else if(current_atom == MSG_QUESTCHANGE) {
+        if(!qvar_changed(ObjId(), static_cast<sQuestMsg*>(msg)))
+            return S_OK;
+
+    // Watches and wheel timers can't outlive the script
+    } else if(current_atom == MSG_ENDSCRIPT) {
+        release_qvar_watches(ObjId());
+        TimerWheel::release(this, message_time);
+
+    // The timer wheel's engine timer is handled here, and is never passed on
+    } else if(current_atom == MSG_TIMER && !::_stricmp(static_cast<sScrTimerMsg*>(msg) -> name, TimerWheel::TICK_MESSAGE)) {
+        if(TimerWheel::is_driver(this))
+            TimerWheel::tick(msg -> time);
+
+        return S_OK;
+
+    // Write out the changes made since the last save, as scheduled above
+    } else if(current_atom == MSG_TIMER && !::_stricmp(static_cast<sScrTimerMsg*>(msg) -> name, SAVE_TIMER)) {
+        save_timer = 0;
+        save_state();
+
+        return S_OK;
+
+    // Write out the binary trace on request. Only one script on the object
+    // needs to do this, but there's no harm in the others doing it too.
+    } else if(current_atom == MSG_DUMPTRACE) {
+        if(TraceLog::enabled())
+            TraceLog::dump();
+
+        return S_OK;
+
+    // Report the module's memory use on request. As with the trace, every
+    // script on the object will do this, so the message should go to an
+    // object with only one script on it.
+    } else if(current_atom == MSG_DUMPALLOCSTATS) {
+        const char* filename = (msg -> data.type == kMT_String) ? static_cast<const char*>(msg -> data) : NULL;
+        if(!AllocStats::dump(filename))
+            debug_printf(DL_WARNING, "Unable to write allocation stats to %s", filename);
+
         return S_OK;
     }
 
@@ -351,8 +397,13 @@ long TWBaseScript::dispatch_message(sScrMsg* msg, sMultiParm* reply)
 
 void TWBaseScript::set_qvar(const std::string &qvar, const int value)
 {
-    SService<IQuestSrv> QuestSrv(g_pScriptManager);
-    QuestSrv -> Set(qvar.c_str(), value, kQuestDataMission);
+    ::set_qvar(intern_qvar(qvar), value);
+}
+
+
+void TWBaseScript::set_qvar(const QVarHandle qvar, const int value)
+{
+    ::set_qvar(qvar, value);
 }
 
 
@@ -28,6 +28,24 @@
 #include <string>
 #include "Script.h"
 #include "DesignParam.h"
+#include "DebugLog.h"
+#include "MessageAtom.h"
+#include "TimerWheel.h"
+
+
+/** Print out a debugging message to the monolog from a member function of a
+ *  TWBaseScript subclass. See TWBaseScript::debug_write() for details. This
+ *  is a macro so that messages below TW_DEBUG_LEVEL are compiled out along
+ *  with their arguments, which are never evaluated.
+ */
+#define debug_printf(level, ...) TW_DEBUG_PRINTF(this, level, __VA_ARGS__)
+
+/** Print out a debugging message to the monolog on behalf of the specified
+ *  script, for use outside its member functions (in link iteration callbacks,
+ *  for example).
+ */
+#define TW_DEBUG_PRINTF(script, level, ...) \
+    do { if(static_cast<int>(level) >= TW_DEBUG_LEVEL) (script) -> debug_write(level, __VA_ARGS__); } while(0)
 
 
 /** A replacement for cBaseScript from Public Scripts. This class is a replacement
@@ -49,10 +67,16 @@ public:
      * @param object The ID of the client object to add the script to.
      * @return A new TWBaseScript object.
      */
-    TWBaseScript(const char* name, int object) : cScript(name, object), debug(object, name, "Debug"), need_fixup(true), sim_running(false), message_time(0), done_init(false)
+    TWBaseScript(const char* name, int object) : cScript(name, object), debug(object, name, "Debug"), need_fixup(true), sim_running(false), message_time(0), current_atom(MSG_NONE), save_timer(0), done_init(false)
         { /* fnord */ }
 
 
+    /** Destroy the TWBaseScript object, dropping any timers it still has in
+     *  the module's timer wheel.
+     */
+    virtual ~TWBaseScript();
+
+
     /** Entrypoint for messages recieved from the game. All messages sent to
      *  the object a script is placed on get sent to this function for handling.
      *  This internally provides debugging and exception handling to prevent
@@ -81,9 +105,35 @@ protected:
      *  the constructor. This should be called as part of processing BeginScript,
      *  before any attempt to use the class' features is made.
      *
-     * @param time The current sim time.
+     * @param time        The current sim time.
+     * @param design_note A reference to the host object's design note. This is
+     *                    fetched once, before init() is called, and subclasses
+     *                    should pass it on to their parent's init().
+     */
+    virtual void init(int time, const DesignNote& design_note);
+
+
+    /** Write any state the script keeps in memory out to its script data, so
+     *  that it is included if the game is saved. Scripts are not told when the
+     *  game is about to be saved, so this is called SAVE_DELAY ms after a
+     *  message leaves state_changed() returning true, and straight away when
+     *  the sim starts or stops, the game mode changes, or the script ends.
+     *  Implementations should only write state that has changed. Subclasses
+     *  that override this must call their parent's save_state().
      */
-    virtual void init(int time);
+    virtual void save_state(void)
+        { /* fnord */ }
+
+
+    /** Determine whether the script has changed any state that save_state()
+     *  needs to write. This is checked at the end of every message, so it
+     *  should be cheap. Subclasses that override save_state() must override
+     *  this too, and call their parent's state_changed().
+     *
+     * @return true if save_state() has anything to write, false otherwise.
+     */
+    virtual bool state_changed(void)
+        { return false; }
 
 
     /* ------------------------------------------------------------------------
@@ -115,6 +165,102 @@ protected:
      virtual MsgStatus on_message(sScrMsg* msg, cMultiParm& reply);
 
 
+    /** Obtain the atom for the name of the message currently being handled.
+     *  This is interned once when the message arrives, so comparing it with
+     *  another atom is much cheaper than comparing the message name.
+     *
+     * @return The atom for the current message's name.
+     */
+    MsgAtom message_atom(void) const { return current_atom; }
+
+
+    /** A table of message handlers for a script class, indexed by message atom.
+     *  Each class that handles messages keeps one static table, and registers
+     *  its handlers in it the first time it is used, so that on_message()
+     *  does one table lookup instead of comparing the message name against
+     *  each message the class handles. For example:
+     *
+     *      TWBaseScript::MessageTable<MyScript> MyScript::handlers(&MyScript::register_handlers);
+     *
+     *      void MyScript::register_handlers(MessageTable<MyScript>& table)
+     *      {
+     *          table.add<sScrTimerMsg, &MyScript::on_timer>("Timer");
+     *      }
+     *
+     *      TWBaseScript::MsgStatus MyScript::on_message(sScrMsg* msg, cMultiParm& reply)
+     *      {
+     *          MsgStatus result = TWBaseScript::on_message(msg, reply);
+     *          if(result != MS_CONTINUE) return result;
+     *
+     *          return handlers.dispatch(this, msg, reply);
+     *      }
+     */
+    template <class T>
+    class MessageTable
+    {
+    public:
+        typedef void (*Setup)(MessageTable<T>&);
+
+        /** Create a new table. This does not allocate anything, so tables can
+         *  be static members; the setup function is called, to register the
+         *  handlers, when the table is first used.
+         *
+         * @param setup_func A function that registers the class' handlers.
+         */
+        MessageTable(Setup setup_func) : setup(setup_func)
+            { /* fnord */ }
+
+
+        /** Register a handler for the named message. The handler is called with
+         *  the message cast to the type M.
+         *
+         * @param message The name of the message to handle.
+         */
+        template <class M, MsgStatus (T::*handler)(M*, cMultiParm&)>
+        void add(const char* message)
+        {
+            MsgAtom atom = intern_message(message);
+            if(atom >= thunks.size()) thunks.resize(atom + 1, NULL);
+
+            thunks[atom] = &call<M, handler>;
+        }
+
+
+        /** Pass the current message to the handler registered for it, if any.
+         *
+         * @param script The script that received the message.
+         * @param msg    A pointer to the message.
+         * @param reply  A reference to the reply variable.
+         * @return The status returned by the handler, or MS_CONTINUE if there
+         *         is no handler for the message.
+         */
+        MsgStatus dispatch(T* script, sScrMsg* msg, cMultiParm& reply)
+        {
+            if(setup) {
+                Setup func = setup;
+                setup = NULL;
+                func(*this);
+            }
+
+            MsgAtom atom = script -> message_atom();
+            if(atom < thunks.size() && thunks[atom])
+                return thunks[atom](script, msg, reply);
+
+            return MS_CONTINUE;
+        }
+
+    private:
+        typedef MsgStatus (*Thunk)(T*, sScrMsg*, cMultiParm&);
+
+        template <class M, MsgStatus (T::*handler)(M*, cMultiParm&)>
+        static MsgStatus call(T* script, sScrMsg* msg, cMultiParm& reply)
+            { return (script ->* handler)(static_cast<M*>(msg), reply); }
+
+        Setup              setup;  //!< The function to register handlers with, NULL once it has been called
+        std::vector<Thunk> thunks; //!< The handler for each message atom, NULL if there isn't one
+    };
+
+
     /* ------------------------------------------------------------------------
      *  Sim checking functions
      */
@@ -198,6 +344,32 @@ protected:
     void cancel_timed_message(tScrTimer timer);
 
 
+    /** Create a one-shot timer in the module's timer wheel. When it fires, the
+     *  script receives a Timer message with the specified name, just as if it
+     *  had been created by set_timed_message(). Scripts that poll the game
+     *  regularly should use this rather than set_timed_message(), as it does
+     *  not need an engine timer for each script. Unlike engine timers, wheel
+     *  timers are not saved with the game, so scripts must set them again in
+     *  init().
+     *
+     * @param name The name of the timer. This is not copied, so it should be
+     *             a string literal.
+     * @param time How many milliseconds to wait before sending the message.
+     * @return A handle for the timer, which will never be 0.
+     */
+    TimerWheel::Timer set_wheel_timer(const char* name, uint time)
+        { return TimerWheel::schedule(this, ObjId(), name, message_time, time); }
+
+
+    /** Cancel a timer created by set_wheel_timer(). It is safe to call this for
+     *  timers that have already fired.
+     *
+     * @param timer The handle of the timer to cancel.
+     */
+    void cancel_wheel_timer(TimerWheel::Timer timer)
+        { TimerWheel::cancel(timer); }
+
+
     /* ------------------------------------------------------------------------
      *  Script data handling
      */
@@ -279,11 +451,22 @@ protected:
      *  of the object the script is attached to - the caller does not need to
      *  include this information explicitly.
      *
+     *  The message is recorded in the DebugLog, and is only formatted and
+     *  printed once the script has finished handling the current message
+     *  (errors are printed immediately). The format should therefore be a
+     *  string literal. This should be called via the debug_printf() or
+     *  TW_DEBUG_PRINTF() macros, which drop messages below TW_DEBUG_LEVEL
+     *  without evaluating their arguments.
+     *
      * @param level  The debug message level
      * @param format A sprintf compatible format string.
-     * @param ...    Optional additional arguments for the format.
+     * @param args   Optional additional arguments for the format.
      */
-    void debug_printf(DebugLevel level, const char* format, ...);
+    template <typename... Args>
+    inline void debug_write(DebugLevel level, const char* format, Args... args)
+    {
+        DebugLog::write(debug_levels[level], Name(), ObjId(), message_time, level == DL_ERROR, format, args...);
+    }
 
 
     /** Obtain a string containing the specified object's name (or archetype name),
@@ -306,6 +489,18 @@ protected:
     void get_object_namestr(std::string& name);
 
 
+    /** Obtain the 'human readable' name and ID number of the specified object,
+     *  as get_object_namestr() does, without allocating. The name is stored in
+     *  the MessageArena, so it remains valid until the message being handled
+     *  is done with; if called outside of a message, the name is only valid
+     *  until the next call.
+     *
+     * @param obj_id The ID of the object to obtain the name and number of.
+     * @return A pointer to the name.
+     */
+    const char* object_name(object obj_id);
+
+
     /* ------------------------------------------------------------------------
      *  QVar convenience functions
      */
@@ -320,42 +515,15 @@ protected:
     void set_qvar(const std::string &qvar, const int value);
 
 
-    /** Fetch the value stored in a qvar, potentially applying a simple calculation
-     *  to the value set in the QVar. This takes a string of the form
-     *  qvarname([*+/](value|$qvarname)) and parses out the name, and operation
-     *  and value or qvar name if they are present, and returns the value in the
-     *  left hand side qvar, potentially modified by the operator and value or
-     *  the value in the right hand qvar. For example, if the qvar variable
-     *  contains 'foo/100' this will take the value in foo and divide it by 100.
-     *  If the quest variable does not exist, this returns the default value
-     *  specified *without applying any calculations to it*. The value may
-     *  optionally be another QVar by placing $ before its name, eg: foo/$bar will
-     *  divide the value in foo by the value in bar.
+    /** Update the value stored in the specified QVar. This is the same as
+     *  set_qvar(const std::string&, const int), but takes the handle for an
+     *  interned qvar name, as returned by intern_qvar(), so it avoids looking
+     *  up the name on every call.
      *
-     * @param qvar    The name of the QVar to return the value of, possibly including simple maths.
-     * @param def_val The default value to return if the qvar does not exist.
-     * @return The QVar value, or the default specified.
-     */
-    int get_qvar_value(std::string& qvar, int def_val);
-
-
-    /** Fetch the value stored in a qvar, potentially applying a simple calculation
-     *  to the value set in the QVar. This takes a string of the form
-     *  qvarname([*+/](value|$qvarname)) and parses out the name, and operation
-     *  and value or qvar name if they are present, and returns the value in the
-     *  left hand side qvar, potentially modified by the operator and value or
-     *  the value in the right hand qvar. For example, if the qvar variable
-     *  contains 'foo/2.5' this will take the value in foo and divide it by 2.5.
-     *  If the quest variable does not exist, this returns the default value
-     *  specified *without applying any calculations to it*. The value may
-     *  optionally be another QVar by placing $ before its name, eg: foo/$bar will
-     *  divide the value in foo by the value in bar.
-     *
-     * @param qvar    The name of the QVar to return the value of, possibly including simple maths.
-     * @param def_val The default value to return if the qvar does not exist.
-     * @return The QVar value, or the default specified.
+     * @param qvar   The handle of the qvar to store the value in.
+     * @param value  The value to store in the qvar.
      */
-    float get_qvar_value(std::string& qvar, float def_val);
+    void set_qvar(const QVarHandle qvar, const int value);
 
 
     /* ------------------------------------------------------------------------
@@ -409,10 +577,14 @@ private:
     bool need_fixup;       //!< Does the script need to fix links to the player?
     bool sim_running;      //!< Is the sim currently running?
     uint message_time;     //!< The sim time stored in the last recieved message
+    MsgAtom current_atom;  //!< The atom for the name of the message being handled
+    TimerWheel::Timer save_timer; //!< The wheel timer for the next save_state(), 0 if none is pending
 
     bool done_init;        //!< Has the script run its init?
 
     static const uint NAME_BUFFER_SIZE;
+    static const char* const SAVE_TIMER; //!< The name of the wheel timer that calls save_state()
+    static const uint SAVE_DELAY;        //!< How long to wait after a change before calling save_state(), in milliseconds
 };
 
 #else // SCR_GENSCRIPTS
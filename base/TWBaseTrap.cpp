@@ -13,7 +13,8 @@ TWBaseScript::MsgStatus TWBaseTrap::on_message(sScrMsg* msg, cMultiParm& reply)
     MsgStatus result = TWBaseScript::on_message(msg, reply);
     if(result != MS_CONTINUE) return result;
 
-    if(!::_stricmp(msg -> message, turnon_msg.c_str())) {
+    MsgAtom atom = message_atom();
+    if(atom == turnon_atom) {
         if(debug_enabled())
             debug_printf(DL_DEBUG, "Received TurnOn");
 
@@ -46,7 +47,7 @@ TWBaseScript::MsgStatus TWBaseTrap::on_message(sScrMsg* msg, cMultiParm& reply)
         // Get here and one of the counters returned false, so halt further processing.
         return MS_HALT;
 
-    } else if(!::_stricmp(msg -> message, turnoff_msg.c_str())) {
+    } else if(atom == turnoff_atom) {
 
         if(debug_enabled())
             debug_printf(DL_DEBUG, "Received TurnOff");
@@ -78,7 +79,7 @@ TWBaseScript::MsgStatus TWBaseTrap::on_message(sScrMsg* msg, cMultiParm& reply)
         // Get here and one of the counters returned false, so halt further processing.
         return MS_HALT;
 
-    } else if(!::_stricmp(msg -> message, "ResetCount")) {
+    } else if(atom == MSG_RESETCOUNT) {
         count.reset(msg -> time);
 
         if(debug_enabled())
@@ -93,33 +94,48 @@ TWBaseScript::MsgStatus TWBaseTrap::on_message(sScrMsg* msg, cMultiParm& reply)
  *  Initialisation related
  */
 
-void TWBaseTrap::init(int time)
+void TWBaseTrap::init(int time, const DesignNote& design_note)
 {
-    TWBaseScript::init(time);
-    char *design_note = GetObjectParams(ObjId());
-
-    if(design_note) {
-        process_designnote(design_note, time);
-        g_pMalloc -> Free(design_note);
-    } else {
-        process_designnote("", time);
-    }
+    TWBaseScript::init(time, design_note);
+
+    process_designnote(design_note, time);
+}
+
+
+void TWBaseTrap::save_state(void)
+{
+    saved.save();
+
+    TWBaseScript::save_state();
+}
+
+
+bool TWBaseTrap::state_changed(void)
+{
+    return saved.is_dirty() || TWBaseScript::state_changed();
 }
 
 
-void TWBaseTrap::process_designnote(const std::string& design_note, const int time)
+void TWBaseTrap::process_designnote(const DesignNote& design_note, const int time)
 {
     // Work out what the turnon and turnoff messages should be
     turnon_msg.init(design_note, "TurnOn");
     turnoff_msg.init(design_note, "TurnOff");
+    turnon_atom  = intern_message(turnon_msg.c_str());
+    turnoff_atom = intern_message(turnoff_msg.c_str());
 
     if(debug_enabled())
         debug_printf(DL_DEBUG, "Trap initialised with on = '%s', off = '%s'", turnon_msg.c_str(), turnoff_msg.c_str());
 
+    // Load the saved counter states. Counters that are enabled below will set
+    // up their own state if it was not restored.
+    bool restored = saved.init(SavedState());
+    SavedState& state = saved.shared();
+
     // Now for use limiting.
     limit_dp.init(design_note);
     if(limit_dp.is_set()) {
-        count.init(time, 0, limit_dp.get_count(), limit_dp.get_falloff(), false, limit_dp.get_limit());
+        count.init(&saved, &state.count, restored, time, 0, limit_dp.get_count(), limit_dp.get_falloff(), false, limit_dp.get_limit());
 
         // Handle modes
         count_mode.init(design_note);
@@ -135,7 +151,7 @@ void TWBaseTrap::process_designnote(const std::string& design_note, const int ti
     // Now deal with capacitors
     cap_dp.init(design_note);
     if(cap_dp.is_set()) {
-        capacitor.init(time, cap_dp.get_count(), 0, cap_dp.get_falloff(), true);
+        capacitor.init(&saved, &state.capacitor, restored, time, cap_dp.get_count(), 0, cap_dp.get_falloff(), true);
 
         if(debug_enabled())
             debug_printf(DL_DEBUG, "Capacitor is %d%s with a falloff of %d milliseconds",
@@ -146,7 +162,7 @@ void TWBaseTrap::process_designnote(const std::string& design_note, const int ti
 
     on_cap_dp.init(design_note);
     if(on_cap_dp.is_set()) {
-        on_capacitor.init(time, on_cap_dp.get_count(), 0, on_cap_dp.get_falloff(), true);
+        on_capacitor.init(&saved, &state.on_capacitor, restored, time, on_cap_dp.get_count(), 0, on_cap_dp.get_falloff(), true);
 
         if(debug_enabled())
             debug_printf(DL_DEBUG, "OnCapacitor is %d%s with a falloff of %d milliseconds",
@@ -157,7 +173,7 @@ void TWBaseTrap::process_designnote(const std::string& design_note, const int ti
 
     off_cap_dp.init(design_note);
     if(off_cap_dp.is_set()) {
-        off_capacitor.init(time, off_cap_dp.get_count(), 0, off_cap_dp.get_falloff(), true);
+        off_capacitor.init(&saved, &state.off_capacitor, restored, time, off_cap_dp.get_count(), 0, off_cap_dp.get_falloff(), true);
 
         if(debug_enabled())
             debug_printf(DL_DEBUG, "OffCapacitor is %d%s with a falloff of %d milliseconds",
@@ -47,6 +47,8 @@ public:
     TWBaseTrap(const char* name, int object) : TWBaseScript(name, object),
                                                turnon_msg (object, name, "TurnOn"),
                                                turnoff_msg(object, name, "TurnOff"),
+                                               turnon_atom(MSG_NONE),
+                                               turnoff_atom(MSG_NONE),
                                                limit_dp(object, name, "Count"),
                                                count(name, object, "count"),
                                                count_mode(object, name, "CountOnly"),
@@ -55,7 +57,8 @@ public:
                                                off_cap_dp(object, name, "OffCapacitor"),
                                                capacitor(name, object, "capacitor"),
                                                on_capacitor(name, object, "on_cap"),
-                                               off_capacitor(name, object, "off_cap")
+                                               off_capacitor(name, object, "off_cap"),
+                                               saved(name, object, "trapstate")
         { /* fnord */ }
 
 protected:
@@ -68,9 +71,20 @@ protected:
      *  should be called as part of processing BeginScript, before any
      *  attempt to use the class' features is made.
      *
-     * @param time The current sim time.
+     * @param time        The current sim time.
+     * @param design_note A reference to the host object's design note.
      */
-    virtual void init(int time);
+    virtual void init(int time, const DesignNote& design_note);
+
+
+    /** Write the trap's counters and capacitors out to its script data.
+     */
+    virtual void save_state(void);
+
+
+    /** Determine whether the trap's counters and capacitors need to be written out.
+     */
+    virtual bool state_changed(void);
 
 
     /* ------------------------------------------------------------------------
@@ -119,7 +133,7 @@ protected:
 
 private:
 
-    void process_designnote(const std::string& design_note, const int time);
+    void process_designnote(const DesignNote& design_note, const int time);
 
     /* ------------------------------------------------------------------------
      *  Variables
@@ -128,6 +142,8 @@ private:
     // Message names
     DesignParamString turnon_msg;    //!< The name of the message that should tigger the 'TurnOn' action
     DesignParamString turnoff_msg;   //!< The name of the message that should tigger the 'TurnOff' action
+    MsgAtom turnon_atom;             //!< The atom for the 'TurnOn' message name
+    MsgAtom turnoff_atom;            //!< The atom for the 'TurnOff' message name
 
     // Count handling
     DesignParamCapacitor limit_dp;
@@ -141,6 +157,16 @@ private:
     SavedCounter capacitor;      //!< Control how frequently anything works
     SavedCounter on_capacitor;   //!< Control how frequently TurnOn actions work
     SavedCounter off_capacitor;  //!< Control how frequently TurnOff actions work
+
+    /** The persistent state of the trap's counters, saved as a single block.
+     */
+    struct SavedState {
+        SavedCounter::State count;
+        SavedCounter::State capacitor;
+        SavedCounter::State on_capacitor;
+        SavedCounter::State off_capacitor;
+    };
+    PersistentBlock<SavedState> saved; //!< The saved counter states
 };
 
 #else // SCR_GENSCRIPTS
@@ -16,7 +16,7 @@ TWBaseScript::MsgStatus TWBaseTrigger::on_message(sScrMsg* msg, cMultiParm& repl
     MsgStatus result = TWBaseScript::on_message(msg, reply);
     if(result != MS_CONTINUE) return result;
 
-    if(!::_stricmp(msg -> message, "ResetTriggerCount")) {
+    if(message_atom() == MSG_RESETTRIGGERCOUNT) {
         count.reset(msg -> time);
 
         if(debug_enabled())
@@ -31,19 +31,11 @@ TWBaseScript::MsgStatus TWBaseTrigger::on_message(sScrMsg* msg, cMultiParm& repl
  *  Initialisation related
  */
 
-void TWBaseTrigger::init(int time)
+void TWBaseTrigger::init(int time, const DesignNote& design_note)
 {
-    TWBaseScript::init(time);
+    TWBaseScript::init(time, design_note);
 
-    char *design_note = GetObjectParams(ObjId());
-
-    if(design_note) {
-        process_designnote(design_note, time);
-        g_pMalloc -> Free(design_note);
-
-    } else {
-        process_designnote("", time);
-    }
+    process_designnote(design_note, time);
 
     uint seed = std::chrono::system_clock::now().time_since_epoch().count();
     generator.seed(seed);
@@ -77,11 +69,25 @@ void TWBaseTrigger::init(int time)
 }
 
 
+void TWBaseTrigger::save_state(void)
+{
+    saved.save();
+
+    TWBaseScript::save_state();
+}
+
+
+bool TWBaseTrigger::state_changed(void)
+{
+    return saved.is_dirty() || TWBaseScript::state_changed();
+}
+
+
 /* ------------------------------------------------------------------------
  *  Miscellaneous - private functions
  */
 
-void TWBaseTrigger::process_designnote(const std::string& design_note, const int time)
+void TWBaseTrigger::process_designnote(const DesignNote& design_note, const int time)
 {
     // Work out what the turnon and turnoff messages should be
     turnon_msg.init(design_note, "TurnOn");
@@ -105,7 +111,8 @@ void TWBaseTrigger::process_designnote(const std::string& design_note, const int
 
     // Now for use limiting.
     count_dp.init(design_note);
-    count.init(time, 0, count_dp.get_count(), count_dp.get_falloff(), false, count_dp.get_limit());
+    bool restored = saved.init(SavedCounter::State());
+    count.init(&saved, &saved.shared(), restored, time, 0, count_dp.get_count(), count_dp.get_falloff(), false, count_dp.get_limit());
 
     // Handle modes
     count_mode.init(design_note);
@@ -187,8 +194,6 @@ float TWBaseTrigger::make_intensity(float min, float max)
 
 bool TWBaseTrigger::send_trigger_message(bool send_on, sScrMsg* msg)
 {
-    std::vector<TargetObj>* targets = NULL;
-
     if(debug_enabled())
         debug_printf(DL_DEBUG, "Doing %s trigger", (send_on ? "On" : "Off"));
 
@@ -211,27 +216,25 @@ bool TWBaseTrigger::send_trigger_message(bool send_on, sScrMsg* msg)
             debug_printf(DL_WARNING, "Count passed (%d of %d), doing trigger", counted, max);
         }
 
-        targets = dest.values(msg);
+        // Stimulating targets may cause this trigger to fire again, so the
+        // targets need their own list rather than dest.view()
+        TargetList targets(true);
+        dest.values(msg, targets);
 
-        if(!targets -> empty()) {
-            std::vector<TargetObj>::iterator it;
+        if(!targets.empty()) {
+            TargetList::iterator it;
             SService<IActReactSrv> ar_srv(g_pScriptManager);
 
             // Convert the bool to an index into the various arrays
             int send = (send_on ? SEND_ON : SEND_OFF);
 
-            for(it = targets -> begin(); it != targets -> end(); it++) {
+            for(it = targets.begin(); it != targets.end(); it++) {
                 // If sending a stim instead of a message, do that...
                 if(isstim[send]) {
                     float intensity = make_intensity(intensity_min[send], intensity_max[send]);
 
-                    if(debug_enabled()) {
-                        std::string objname, stimname;
-                        get_object_namestr(objname, it -> obj_id);
-                        get_object_namestr(stimname, stimob[send]);
-
-                        debug_printf(DL_DEBUG, "Stimulating %s with %s, intensity %.3f", objname.c_str(), stimname.c_str(), intensity);
-                    }
+                    if(debug_enabled())
+                        debug_printf(DL_DEBUG, "Stimulating %s with %s, intensity %.3f", object_name(it -> obj_id), object_name(stimob[send]), intensity);
 
                     ar_srv -> Stimulate(it -> obj_id, stimob[send], intensity, ObjId());
 
@@ -247,12 +250,8 @@ bool TWBaseTrigger::send_trigger_message(bool send_on, sScrMsg* msg)
                     }
 
                     // Report it if needed
-                    if(debug_enabled()) {
-                        std::string objname;
-                        get_object_namestr(objname, it -> obj_id);
-
-                        debug_printf(DL_DEBUG, "Sending %s to %s", message -> c_str(), objname.c_str());
-                    }
+                    if(debug_enabled())
+                        debug_printf(DL_DEBUG, "Sending %s to %s", message -> c_str(), object_name(it -> obj_id));
 
                     // And send it
                     post_message(it -> obj_id, message -> c_str());
@@ -264,9 +263,6 @@ bool TWBaseTrigger::send_trigger_message(bool send_on, sScrMsg* msg)
             debug_printf(DL_WARNING, "No targets found for trigger");
         }
 
-        // No longer need the target list
-        delete targets;
-
         // Indicate messages have been sent
         return true;
     } else if(debug_enabled()) {
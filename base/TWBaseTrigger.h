@@ -61,6 +61,7 @@ public:
                                                   count_dp(object, name, "TCount"),
                                                   count(name, object, "count"),
                                                   count_mode(object, name, "TCountOnly"),
+                                                  saved(name, object, "triggerstate"),
 
                                                   generator(0),
                                                   uni_dist(0, 100)
@@ -81,9 +82,20 @@ protected:
      *  should be called as part of processing BeginScript, before any
      *  attempt to use the class' features is made.
      *
-     * @param time The current sim time.
+     * @param time        The current sim time.
+     * @param design_note A reference to the host object's design note.
      */
-    virtual void init(int time);
+    virtual void init(int time, const DesignNote& design_note);
+
+
+    /** Write the trigger's counter out to its script data.
+     */
+    virtual void save_state(void);
+
+
+    /** Determine whether the trigger's counter need to be written out.
+     */
+    virtual bool state_changed(void);
 
 
     /* ------------------------------------------------------------------------
@@ -139,7 +151,7 @@ private:
      *  Miscellaneous
      */
 
-    void process_designnote(const std::string& design_note, const int time);
+    void process_designnote(const DesignNote& design_note, const int time);
 
 
     /** Determine whether the specified message is actually a stimulus request, and
@@ -180,6 +192,8 @@ private:
 
     DesignParamCountMode count_mode; //!< What counts as 'working'?
 
+    PersistentBlock<SavedCounter::State> saved; //!< The saved counter state
+
     // Randomness
     std::mt19937 generator;
     std::uniform_int_distribution<int> uni_dist;   //!< a uniform distribution for fail checking.
@@ -0,0 +1,384 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#include <lg/interface.h>
+#include <lg/scrmanagers.h>
+#include <lg/scrmsgs.h>
+#include <vector>
+#include "TimerWheel.h"
+#include "TWBaseScript.h"
+#include "ScriptModule.h"
+
+const char* const TimerWheel::TICK_MESSAGE = "TWTimerWheel";
+const uint        TimerWheel::RESOLUTION   = 16;
+
+namespace {
+    const uint SLOT_BITS  = 6;
+    const uint SLOTS      = 1 << SLOT_BITS;  //!< The number of slots in each level
+    const uint SLOT_MASK  = SLOTS - 1;
+    const uint LEVELS     = 3;               //!< Note that tick() assumes there are three levels
+    const uint MAX_DELTA  = 1 << (SLOT_BITS * LEVELS); //!< How many ticks ahead the wheel can hold a timer
+
+    const int  NONE       = 0;               //!< The 'null' entry index; entry 0 is never used
+    const int  PENDING    = SLOTS * LEVELS;  //!< The list holding timers being sent out by tick()
+    const int  FREE       = -1;              //!< The list value for unused entries
+
+    /** A timer in the wheel. Entries are kept in a vector and linked into
+     *  the slot lists by index, so they can be reused without allocating.
+     */
+    struct Entry {
+        TWBaseScript* script;     //!< The script to send the timer to
+        int           obj_id;     //!< The object the script is attached to
+        const char*   name;       //!< The name of the timer message
+        uint          due;        //!< The sim time the timer is due at
+        int           prev;       //!< The previous entry in the list
+        int           next;       //!< The next entry in the list, or in the free list
+        int           list;       //!< The list the entry is in, or FREE
+        uint          generation; //!< Incremented whenever the entry is freed, to spot stale handles
+    };
+
+    // Note that this must not allocate until it is used, as it is constructed
+    // before the module's allocator is available.
+    std::vector<Entry> entries;
+
+    int  heads[PENDING + 1];     //!< The first entry in each slot, plus the pending list
+    int  free_entries = NONE;    //!< The first unused entry
+    uint active       = 0;       //!< How many timers are scheduled
+
+    uint wheel_tick   = 0;       //!< The tick the wheel has been turned to
+    bool ticking      = false;   //!< Is tick() sending out timers?
+
+    TWBaseScript* driver = NULL; //!< The script whose object gets the engine timer
+    int  driver_obj   = 0;       //!< The object the driver is attached to
+    bool armed        = false;   //!< Is there an engine timer set for armed_time?
+    uint armed_time   = 0;       //!< The sim time the engine timer is set for
+
+
+    /** Add an entry to the front of the specified list.
+     */
+    void link(const int index, const int list)
+    {
+        Entry& entry = entries[index];
+
+        entry.list = list;
+        entry.prev = NONE;
+        entry.next = heads[list];
+        if(heads[list] != NONE) entries[heads[list]].prev = index;
+        heads[list] = index;
+    }
+
+
+    /** Remove an entry from the list it is in.
+     */
+    void unlink(const int index)
+    {
+        Entry& entry = entries[index];
+
+        if(entry.prev != NONE) {
+            entries[entry.prev].next = entry.next;
+        } else {
+            heads[entry.list] = entry.next;
+        }
+
+        if(entry.next != NONE) entries[entry.next].prev = entry.prev;
+    }
+
+
+    /** Put an entry into the slot it belongs in, given how far ahead of the
+     *  wheel it is due. Entries that are due in the current tick, or before
+     *  it, go in the current slot.
+     */
+    void place(const int index)
+    {
+        uint tick  = entries[index].due / TimerWheel::RESOLUTION;
+        uint delta = (tick > wheel_tick) ? tick - wheel_tick : 0;
+
+        // Park timers that are too far away for the wheel in its last slot
+        if(delta >= MAX_DELTA) {
+            delta = MAX_DELTA - 1;
+            tick  = wheel_tick + delta;
+        } else if(!delta) {
+            tick = wheel_tick;
+        }
+
+        uint level = 0;
+        while(delta >= SLOTS && level < LEVELS - 1) {
+            delta >>= SLOT_BITS;
+            ++level;
+        }
+
+        link(index, level * SLOTS + ((tick >> (SLOT_BITS * level)) & SLOT_MASK));
+    }
+
+
+    /** Move the entries in the current slot of an upper level down to the
+     *  levels below.
+     */
+    void cascade(const uint level)
+    {
+        int list  = level * SLOTS + ((wheel_tick >> (SLOT_BITS * level)) & SLOT_MASK);
+        int index = heads[list];
+        heads[list] = NONE;
+
+        while(index != NONE) {
+            int next = entries[index].next;
+            place(index);
+            index = next;
+        }
+    }
+
+
+    /** Release an entry, adding it to the free list.
+     */
+    void release_entry(const int index)
+    {
+        Entry& entry = entries[index];
+
+        unlink(index);
+        entry.script = NULL;
+        entry.list   = FREE;
+        entry.next   = free_entries;
+        ++entry.generation;
+
+        free_entries = index;
+        --active;
+    }
+
+
+    /** Send out the timers in the current slot that are due at or before the
+     *  specified time. Timers due later in the slot's tick are left in it.
+     */
+    void fire_slot(const uint now)
+    {
+        int slot = wheel_tick & SLOT_MASK;
+        if(heads[slot] == NONE) return;
+
+        // Move the slot aside, so that timers scheduled while these are being
+        // sent go into the wheel properly.
+        heads[PENDING] = heads[slot];
+        heads[slot]    = NONE;
+        for(int index = heads[PENDING]; index != NONE; index = entries[index].next)
+            entries[index].list = PENDING;
+
+        while(heads[PENDING] != NONE) {
+            int index = heads[PENDING];
+            Entry& entry = entries[index];
+
+            if(entry.due > now) {
+                unlink(index);
+                link(index, slot);
+                continue;
+            }
+
+            TWBaseScript* script = entry.script;
+            sScrTimerMsg  msg;
+            cMultiParm    reply;
+
+            // The game's message structures do not initialise themselves, so
+            // everything a script might look at needs to be filled in here.
+            msg.from    = msg.to = entry.obj_id;
+            msg.message = "Timer";
+            msg.time    = now;
+            msg.flags   = 0;
+            msg.data    = cMultiParm();
+            msg.data2   = cMultiParm();
+            msg.data3   = cMultiParm();
+            msg.name    = entry.name;
+
+            // Free the entry first, so the script can schedule its next timer
+            release_entry(index);
+            script -> ReceiveMessage(&msg, &reply, kNoAction);
+        }
+    }
+
+
+    /** Obtain the sim time at which the wheel next needs turning, either to
+     *  send a timer or to move timers down from an upper level.
+     *
+     * @return true if there are timers in the wheel, false otherwise.
+     */
+    bool next_time(uint& time)
+    {
+        if(!active) return false;
+
+        // The first timer in the first level is found exactly...
+        time = ~0U;
+        for(uint step = 0; step < SLOTS; ++step) {
+            int index = heads[(wheel_tick + step) & SLOT_MASK];
+            if(index == NONE) continue;
+
+            for(; index != NONE; index = entries[index].next) {
+                if(entries[index].due < time) time = entries[index].due;
+            }
+            break;
+        }
+
+        // ... while the upper levels only need the time they next cascade
+        for(uint level = 1; level < LEVELS; ++level) {
+            uint shift = SLOT_BITS * level;
+
+            for(uint step = 1; step <= SLOTS; ++step) {
+                uint slot_tick = ((wheel_tick >> shift) + step) << shift;
+                if(slot_tick * TimerWheel::RESOLUTION >= time) break;
+
+                if(heads[level * SLOTS + ((slot_tick >> shift) & SLOT_MASK)] != NONE) {
+                    time = slot_tick * TimerWheel::RESOLUTION;
+                    break;
+                }
+            }
+        }
+
+        return true;
+    }
+
+
+    /** Make sure there is an engine timer set for the next time the wheel
+     *  needs turning.
+     */
+    void arm(const uint now)
+    {
+        uint time;
+        if(ticking || !driver || !next_time(time)) return;
+
+        if(armed && armed_time <= time) return;
+
+        uint delay = (time > now) ? time - now : 1;
+
+        g_pScriptManager -> SetTimedMessage2(driver_obj, TimerWheel::TICK_MESSAGE, delay, kSTM_OneShot, cMultiParm::Undef);
+        armed      = true;
+        armed_time = now + delay;
+    }
+}
+
+
+/* ------------------------------------------------------------------------
+ *  Public interface
+ */
+
+TimerWheel::Timer TimerWheel::schedule(TWBaseScript* script, const int obj_id, const char* name, const uint now, const uint delay)
+{
+    if(entries.empty()) {
+        // Entry 0 stands in for 'no entry' in the lists
+        entries.push_back(Entry());
+        entries[NONE].list = FREE;
+    }
+
+    // An empty wheel can jump straight to the current time
+    if(!active && !ticking) wheel_tick = now / RESOLUTION;
+
+    int index = free_entries;
+    if(index != NONE) {
+        free_entries = entries[index].next;
+    } else {
+        index = static_cast<int>(entries.size());
+        entries.push_back(Entry());
+        entries[index].generation = 0;
+    }
+
+    Entry& entry = entries[index];
+    entry.script = script;
+    entry.obj_id = obj_id;
+    entry.name   = name;
+    entry.due    = now + delay;
+
+    place(index);
+    ++active;
+
+    if(!driver) {
+        driver     = script;
+        driver_obj = obj_id;
+        armed      = false;
+    }
+    arm(now);
+
+    return ((entry.generation & 0xFFFF) << 16) | static_cast<uint>(index);
+}
+
+
+void TimerWheel::cancel(const Timer timer)
+{
+    int index = timer & 0xFFFF;
+
+    if(index != NONE && index < static_cast<int>(entries.size()) &&
+       entries[index].list != FREE && (entries[index].generation & 0xFFFF) == (timer >> 16)) {
+        release_entry(index);
+    }
+}
+
+
+void TimerWheel::release(TWBaseScript* script, const uint now, const bool rearm)
+{
+    for(size_t index = 1; index < entries.size(); ++index) {
+        if(entries[index].list != FREE && entries[index].script == script)
+            release_entry(static_cast<int>(index));
+    }
+
+    // If the driver has gone, hand the engine timer to any remaining script.
+    // The old timer is left to fire on its own, as that does no harm.
+    if(driver == script) {
+        driver = NULL;
+        armed  = false;
+
+        if(rearm && active) {
+            for(size_t index = 1; index < entries.size(); ++index) {
+                if(entries[index].list != FREE) {
+                    driver     = entries[index].script;
+                    driver_obj = entries[index].obj_id;
+                    break;
+                }
+            }
+
+            arm(now);
+        }
+    }
+}
+
+
+bool TimerWheel::is_driver(const TWBaseScript* script)
+{
+    return script == driver;
+}
+
+
+void TimerWheel::tick(const uint now)
+{
+    // Nested ticks can't happen normally, but don't let them mangle the lists
+    if(ticking) return;
+
+    if(armed && now >= armed_time) armed = false;
+
+    ticking = true;
+
+    // The current slot may hold timers that were not due when it was last
+    // looked at, so check it before moving on.
+    uint target = now / RESOLUTION;
+    fire_slot(now);
+
+    while(wheel_tick < target) {
+        ++wheel_tick;
+
+        // When a level finishes a turn, bring down the next slot from above
+        if(!(wheel_tick & SLOT_MASK)) {
+            cascade(1);
+            if(!((wheel_tick >> SLOT_BITS) & SLOT_MASK)) cascade(2);
+        }
+
+        fire_slot(now);
+    }
+
+    ticking = false;
+
+    arm(now);
+}
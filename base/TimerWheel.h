@@ -0,0 +1,107 @@
+/** @file
+ * This file contains the interface for the TimerWheel class, which runs the
+ * periodic timers for all the scripts in the module from a single engine
+ * timer.
+ *
+ * @author Chris Page &lt;chris@starforge.co.uk&gt;
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <lg/config.h>
+
+class TWBaseScript;
+
+/** A module-wide hierarchical timer wheel. Scripts that poll the game every
+ *  so often schedule their timers here rather than with the engine; the wheel
+ *  keeps a single engine timer running, on the object of one of the scripts
+ *  that uses it (the 'driver'), for the earliest timer that is due. When that
+ *  fires, every timer that has fallen due is sent to its script as a normal
+ *  Timer message, by calling the script's ReceiveMessage() directly, so the
+ *  engine only needs to create one timer and message per tick no matter how
+ *  many scripts are polling.
+ *
+ *  The wheel has three levels of 64 slots. The first level has one slot per
+ *  RESOLUTION milliseconds, and each slot in the levels above covers a whole
+ *  turn of the level below it; timers are moved down a level as the wheel
+ *  turns, and timers further away than the top level can hold are parked in
+ *  its last slot until they come into range. The slots only decide where a
+ *  timer is kept: the engine timer is set for the exact time the next timer
+ *  is due, so timers fire when they would have done as engine timers.
+ *
+ *  Timers in the wheel are not saved with the game. Scripts that use it must
+ *  schedule their timers again when they are initialised after a load.
+ */
+class TimerWheel
+{
+public:
+    typedef uint Timer;     //!< A handle for a scheduled timer. 0 is never a valid timer.
+
+    static const char* const TICK_MESSAGE; //!< The name of the engine timer that drives the wheel
+    static const uint        RESOLUTION;   //!< The time covered by each slot in the first level, in milliseconds
+
+
+    /** Schedule a timer for a script. When it falls due, the script will be
+     *  sent a Timer message with the specified name.
+     *
+     * @param script The script to send the timer message to.
+     * @param obj_id The ID of the object the script is attached to.
+     * @param name   The name to give the timer message. This is not copied,
+     *               so it should be a string literal.
+     * @param now    The current sim time.
+     * @param delay  How many milliseconds to wait before sending the message.
+     * @return A handle for the timer, which can be passed to cancel().
+     */
+    static Timer schedule(TWBaseScript* script, const int obj_id, const char* name, const uint now, const uint delay);
+
+
+    /** Cancel a scheduled timer. Timers that have already fired, or been
+     *  cancelled, are ignored.
+     *
+     * @param timer The handle of the timer to cancel.
+     */
+    static void cancel(const Timer timer);
+
+
+    /** Cancel all the timers scheduled for a script. This must be called
+     *  before the script is destroyed.
+     *
+     * @param script The script to cancel the timers of.
+     * @param now    The current sim time.
+     * @param rearm  If the script was driving the wheel, and other scripts
+     *               still have timers scheduled, move the engine timer to one
+     *               of them. This should be false if the game is shutting the
+     *               scripts down.
+     */
+    static void release(TWBaseScript* script, const uint now, const bool rearm = true);
+
+
+    /** Determine whether the specified script is the one driving the wheel.
+     *  Only the driver should pass TICK_MESSAGE timers on to tick().
+     */
+    static bool is_driver(const TWBaseScript* script);
+
+
+    /** Turn the wheel to the specified time, sending out any timers that have
+     *  fallen due, and then set the engine timer for the next one.
+     *
+     * @param now The current sim time.
+     */
+    static void tick(const uint now);
+};
+
+#endif // TIMERWHEEL_H
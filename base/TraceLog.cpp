@@ -0,0 +1,264 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#include <lg/interface.h>
+#include <lg/scrmanagers.h>
+#include <lg/scrservices.h>
+#include <stdint.h>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <set>
+#include <vector>
+#include "TraceLog.h"
+#include "ScriptModule.h"
+
+const char* const TraceLog::SIGNATURE     = "TWTRACE1";
+const char* const TraceLog::TRACE_FILE    = "twscript_trace.bin";
+const char* const TraceLog::TRACE_CONFIG  = "twscript_trace";
+const size_t      TraceLog::RECORD_HEADER = 17;
+const size_t      TraceLog::BUFFER_SIZE   = 131072;
+const uint        TraceLog::ERROR_DUMP_INTERVAL = 10000;
+
+namespace {
+    const size_t MAX_RECORD = TraceLog::RECORD_HEADER + DebugLog::MAX_ARGS * 257; //!< The largest a record can be, with every argument a long string
+
+    unsigned char ring[TraceLog::BUFFER_SIZE]; //!< The trace, as a ring of variable-sized records
+    size_t start = 0;       //!< The offset of the oldest record in the ring
+    size_t used  = 0;       //!< How many bytes of the ring contain records
+
+    bool checked = false;   //!< Has the config been checked for the trace variable?
+    bool tracing = false;   //!< Is the trace enabled?
+
+    bool error_dumped    = false; //!< Has the trace been dumped for an error yet?
+    uint error_dump_time = 0;     //!< The sim time of the last dump for an error
+
+    // Note that these must not allocate until they are used, as they are
+    // constructed before the module's allocator is available.
+    std::map<const char*, uint16_t> string_ids; //!< The index of each string in the table, by address
+    std::vector<const char*>        strings;    //!< The level names, script names, and formats used by records
+
+
+    /** Obtain the index of the specified string in the string table, adding
+     *  it if needed. Level names, script names, and formats all have static
+     *  storage, so the address identifies the string.
+     */
+    uint16_t string_id(const char* str)
+    {
+        std::map<const char*, uint16_t>::iterator it = string_ids.find(str);
+        if(it != string_ids.end()) return it -> second;
+
+        // Give up on adding strings once the table is full; these show up as
+        // unknown when decoded, but there should never be this many.
+        if(strings.size() >= 0xFFFF) return 0xFFFF;
+
+        uint16_t id = static_cast<uint16_t>(strings.size());
+        strings.push_back(str);
+        string_ids.insert(std::make_pair(str, id));
+
+        return id;
+    }
+
+
+    /** Copy data into the ring at the specified offset, wrapping as needed.
+     */
+    void ring_write(const size_t offset, const void* src, const size_t len)
+    {
+        size_t pos   = offset % sizeof(ring);
+        size_t first = sizeof(ring) - pos;
+
+        if(len <= first) {
+            memcpy(&ring[pos], src, len);
+        } else {
+            memcpy(&ring[pos], src, first);
+            memcpy(ring, static_cast<const unsigned char*>(src) + first, len - first);
+        }
+    }
+
+
+    /** Copy data out of the ring from the specified offset, wrapping as needed.
+     */
+    void ring_read(const size_t offset, void* dest, const size_t len)
+    {
+        size_t pos   = offset % sizeof(ring);
+        size_t first = sizeof(ring) - pos;
+
+        if(len <= first) {
+            memcpy(dest, &ring[pos], len);
+        } else {
+            memcpy(dest, &ring[pos], first);
+            memcpy(static_cast<unsigned char*>(dest) + first, ring, len - first);
+        }
+    }
+
+
+    /** Drop the oldest records from the ring until there is enough space
+     *  for a record of the specified size.
+     */
+    void make_room(const size_t size)
+    {
+        while(used && used + size > sizeof(ring)) {
+            uint16_t oldest;
+            ring_read(start, &oldest, sizeof(oldest));
+
+            start = (start + oldest) % sizeof(ring);
+            used -= oldest;
+        }
+    }
+
+
+    /* Helpers for writing values to the dump file.
+     */
+    template <typename T>
+    void write_value(FILE* out, const T value)
+    {
+        fwrite(&value, sizeof(value), 1, out);
+    }
+
+
+    void write_string(FILE* out, const char* str)
+    {
+        size_t len = strlen(str);
+        if(len > 0xFFFF) len = 0xFFFF;
+
+        write_value(out, static_cast<uint16_t>(len));
+        fwrite(str, 1, len, out);
+    }
+}
+
+
+/* ------------------------------------------------------------------------
+ *  Public interface
+ */
+
+bool TraceLog::enabled(void)
+{
+    if(!checked && g_pScriptManager) {
+        SService<IEngineSrv> engine(g_pScriptManager);
+
+        tracing = engine -> ConfigIsDefined(TRACE_CONFIG);
+        checked = true;
+    }
+
+    return tracing;
+}
+
+
+void TraceLog::append(const DebugLog::Record& record)
+{
+    unsigned char data[MAX_RECORD];
+    size_t size = RECORD_HEADER;
+
+    // Arguments first, as the header needs the size of the record
+    for(unsigned arg = 0; arg < record.arg_count; ++arg) {
+        const DebugLog::Arg& value = record.args[arg];
+
+        data[size++] = static_cast<unsigned char>(value.type);
+        if(value.type == DebugLog::Arg::STRING) {
+            size_t len = strlen(value.s);
+            if(len > 255) len = 255;
+
+            data[size++] = static_cast<unsigned char>(len);
+            memcpy(&data[size], value.s, len);
+            size += len;
+
+        } else {
+            // Pointers may be smaller than the other values in the union
+            uint64_t bits = (value.type == DebugLog::Arg::POINTER) ? reinterpret_cast<size_t>(value.p) : value.u;
+
+            memcpy(&data[size], &bits, sizeof(bits));
+            size += sizeof(bits);
+        }
+    }
+
+    uint16_t header[4] = { static_cast<uint16_t>(size), string_id(record.level), string_id(record.script), string_id(record.format) };
+    uint32_t time      = record.time;
+    int32_t  obj_id    = record.obj_id;
+
+    memcpy(&data[0], header, sizeof(header));
+    memcpy(&data[8], &time, sizeof(time));
+    memcpy(&data[12], &obj_id, sizeof(obj_id));
+    data[16] = static_cast<unsigned char>(record.arg_count);
+
+    make_room(size);
+    ring_write(start + used, data, size);
+    used += size;
+}
+
+
+bool TraceLog::dump(void)
+{
+    DebugLog::flush();
+
+    FILE* out = fopen(TRACE_FILE, "wb");
+    if(!out) return false;
+
+    fwrite(SIGNATURE, 1, strlen(SIGNATURE), out);
+
+    write_value(out, static_cast<uint32_t>(strings.size()));
+    for(std::vector<const char*>::const_iterator it = strings.begin(); it != strings.end(); ++it)
+        write_string(out, *it);
+
+    // Look up the names of the objects now, so the decoder doesn't need to
+    std::set<int32_t> objects;
+    for(size_t offset = 0; offset < used; ) {
+        uint16_t size;
+        int32_t  obj_id;
+
+        ring_read(start + offset, &size, sizeof(size));
+        ring_read(start + offset + 12, &obj_id, sizeof(obj_id));
+        objects.insert(obj_id);
+
+        offset += size;
+    }
+
+    write_value(out, static_cast<uint32_t>(objects.size()));
+    for(std::set<int32_t>::const_iterator it = objects.begin(); it != objects.end(); ++it) {
+        char name[256];
+        DebugLog::object_name(name, sizeof(name), *it);
+
+        write_value(out, *it);
+        write_string(out, name);
+    }
+
+    // And finally the records themselves, unwrapped
+    write_value(out, static_cast<uint32_t>(used));
+    size_t first = sizeof(ring) - start;
+    if(used <= first) {
+        fwrite(&ring[start], 1, used, out);
+    } else {
+        fwrite(&ring[start], 1, first, out);
+        fwrite(ring, 1, used - first, out);
+    }
+
+    bool written = !ferror(out);
+    fclose(out);
+
+    return written;
+}
+
+
+bool TraceLog::dump_error(const uint time)
+{
+    // Sim time goes backwards when a save is loaded, which should not hold
+    // up the dump for the first error after the load.
+    if(error_dumped && time >= error_dump_time && time - error_dump_time < ERROR_DUMP_INTERVAL)
+        return false;
+
+    error_dumped    = true;
+    error_dump_time = time;
+
+    return dump();
+}
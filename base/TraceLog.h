@@ -0,0 +1,106 @@
+/** @file
+ * This file contains the interface for the TraceLog class, which keeps a
+ * compact binary record of recent debugging messages in memory, so that
+ * debugging can be left enabled without the cost of writing to the monolog.
+ *
+ * @author Chris Page &lt;chris@starforge.co.uk&gt;
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef TRACELOG_H
+#define TRACELOG_H
+
+#include <cstddef>
+#include "DebugLog.h"
+
+/** A fixed-size ring of binary debug records. When the `twscript_trace`
+ *  config variable is set (for example, in cam_ext.cfg), DebugLog sends its
+ *  records here rather than formatting them for the monolog. Once the ring
+ *  is full, the oldest records are dropped to make room for new ones.
+ *
+ *  The ring is written to TRACE_FILE when a script reports an error (at most
+ *  once every ERROR_DUMP_INTERVAL ms), or when any script receives a
+ *  DumpTrace message. The dump starts with the eight
+ *  byte SIGNATURE, followed by these sections, in native byte order:
+ *
+ *      uint32 string count, then for each string: uint16 length, characters
+ *      uint32 object count, then for each object: int32 id, uint16 length, characters
+ *      uint32 record bytes, then the records, oldest first
+ *
+ *  The strings are the level names, script names, and format strings used by
+ *  the records, and the objects give the names of the objects the records
+ *  refer to at the time of the dump. Each record starts with a header of
+ *  RECORD_HEADER bytes:
+ *
+ *      uint16 size     The size of the record, including the header
+ *      uint16 level    The index of the level name in the string table
+ *      uint16 script   The index of the script name in the string table
+ *      uint16 format   The index of the format string in the string table
+ *      uint32 time     The sim time the record was written at
+ *      int32  obj_id   The object the script is attached to
+ *      uint8  count    The number of arguments
+ *
+ *  which is followed by the arguments. Each argument is a uint8 type (a
+ *  DebugLog::Arg::Type), then either a uint8 length and the characters for
+ *  strings, or an 8 byte value for everything else.
+ */
+class TraceLog
+{
+public:
+    static const char* const SIGNATURE;     //!< The signature at the start of the dump
+    static const char* const TRACE_FILE;    //!< The name of the file the trace is dumped to
+    static const char* const TRACE_CONFIG;  //!< The config variable that enables the trace
+    static const size_t      RECORD_HEADER; //!< The size of a record header, in bytes
+    static const size_t      BUFFER_SIZE;   //!< The size of the ring, in bytes
+    static const uint        ERROR_DUMP_INTERVAL; //!< The shortest sim time between dumps for errors, in milliseconds
+
+
+    /** Determine whether the trace is enabled. This checks the game's config
+     *  the first time it is called.
+     *
+     * @return true if debug records should go to the trace.
+     */
+    static bool enabled(void);
+
+
+    /** Add a debug record to the trace, dropping the oldest records if needed
+     *  to make room for it.
+     *
+     * @param record The record to add.
+     */
+    static void append(const DebugLog::Record& record);
+
+
+    /** Write the contents of the trace to TRACE_FILE, replacing any previous
+     *  dump. Any records waiting in the DebugLog are added first.
+     *
+     * @return true if the trace was written, false otherwise.
+     */
+    static bool dump(void);
+
+
+    /** Write the contents of the trace to TRACE_FILE because a script has
+     *  reported an error, unless the trace was written for an error less than
+     *  ERROR_DUMP_INTERVAL ms of sim time ago. Rewriting the whole trace for
+     *  every error would slow a script that fails repeatedly to a crawl; the
+     *  records for skipped errors stay in the ring for the next dump.
+     *
+     * @param time The sim time the error was reported at.
+     * @return true if the trace was written, false if it was not.
+     */
+    static bool dump_error(const uint time);
+};
+
+#endif // TRACELOG_H
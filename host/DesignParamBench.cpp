@@ -0,0 +1,344 @@
+/** @file
+ * This file contains the DesignParam initialisation benchmark. It times
+ * init() for each of the design note parameter types over a small corpus
+ * of design notes modelled on those found in real missions, and reports
+ * the time and number of heap allocations each init takes. The time taken
+ * to parse each design note, which scripts do once for all their
+ * parameters, and the time taken by radius target searches, are reported
+ * separately.
+ *
+ * @author Chris Page &lt;chris@starforge.co.uk&gt;
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "ScriptLib.h"
+#include "HostModule.h"
+#include "HostScriptMan.h"
+#include "DesignNote.h"
+#include "DesignParam.h"
+
+namespace {
+
+    /** A design note to run the benchmarks over. Every note in the corpus
+     *  uses the same parameter names, so each parameter type can be timed
+     *  against every note.
+     */
+    struct CorpusNote {
+        const char* name;  //!< A short name for the note, shown in the results
+        const char* note;  //!< The design note itself
+    };
+
+
+    const CorpusNote corpus[] = {
+        // Just the parameters being benchmarked, as a designer would write them
+        { "short",
+          "TWBenchName=Guard;TWBenchSpeed=2.5;TWBenchRate=1.5s;TWBenchImmediate=true;TWBenchCountOnly=On;"
+          "TWBenchDest=&ControlDevice;TWBenchCapacitor=3;TWBenchCapacitorFalloff=500;TWBenchVelocity=0, 0, 2.5" },
+
+        // The parameters buried among settings for several other scripts on the same object
+        { "long",
+          "TWTrapAIEcologyRate=30s;TWTrapAIEcologyPopulation=4;TWTrapAIEcologyLives=20;TWTrapAIEcologyStartOn=true;"
+          "TWTrapAIEcologyVisibleSpawn=false;TWTrapAIEcologyPopulationQVar=ecopop;TWTrapAIEcologySpawnCountQVar=ecototal;"
+          "TWTrapAIBreathInCold=true;TWTrapAIBreathImmediate=false;TWTrapAIBreathStopOnKO=true;TWTrapAIBreathExhaleTime=250;"
+          "TWTrapAIBreathSFX=BreathPuff;TWTrapAIBreathLinkType=ParticleAttachement;TWTrapAIBreathColdRooms=*ColdRoom;"
+          "TWTriggerAIAwareObject=Player;TWTriggerAIAwareAlertness=2;TWTriggerAIAwareRate=250;TCount=0;TCountOnly=Both;"
+          "TWTriggerVisibleLow=30;TWTriggerVisibleHigh=60;TWTriggerVisibleRate=500;TOn=TurnOn;TOff=TurnOff;TDest=[me];"
+          "TWBenchName=Guard;TWBenchSpeed=2.5;TWBenchRate=1.5s;TWBenchImmediate=true;TWBenchCountOnly=On;"
+          "TWBenchDest=&ControlDevice;TWBenchCapacitor=3;TWBenchCapacitorFalloff=500;TWBenchVelocity=0, 0, 2.5" },
+
+        // Quoted values, with the spacing designers tend to use when quoting
+        { "quoted",
+          "TWBenchName = \"Guard; the second\" ; TWBenchSpeed = '2.5' ; TWBenchRate = '1.5s' ; TWBenchImmediate = 'yes' ; "
+          "TWBenchCountOnly = \"Off\" ; TWBenchDest = '?[2]#ControlDevice' ; TWBenchCapacitor = '3' ; "
+          "TWBenchCapacitorFalloff = '500' ; TWBenchCapacitorLimit = 'true' ; TWBenchVelocity = '0, 0, 2.5'" },
+
+        // Quest variable calculations wherever they are allowed
+        { "qvar",
+          "TWBenchName=Guard;TWBenchSpeed=$speed * 2;TWBenchRate=$delay + 250;TWBenchImmediate=$immediate;TWBenchCountOnly=2;"
+          "TWBenchDest=$target;TWBenchCapacitor=$capcount;TWBenchCapacitorFalloff=$capfall * 10;TWBenchCapacitorLimit=$caplimit;"
+          "TWBenchVelocity=$velx, $vely * 2, 10 - $velz" },
+
+        // None of the parameters are set, so every init falls back on its defaults
+        { "missing",
+          "TWTrapAIEcologyRate=30s;TWTrapAIEcologyPopulation=4;TWTriggerAIAwareObject=Player;TCount=0;TOn=TurnOn;TDest=[me]" },
+    };
+
+    const size_t corpus_size = sizeof(corpus) / sizeof(corpus[0]);
+
+    /** The number of objects scattered around the world for the search benchmarks.
+     */
+    const int SEARCH_OBJECTS = 3200;
+
+    /** The number of ControlDevice and ScriptParams links from the host for the
+     *  link search benchmarks.
+     */
+    const int LINK_FANOUT = 64;
+
+
+    /** The results of timing one parameter type over one note.
+     */
+    struct BenchResult {
+        double ns_per_op;      //!< The average time taken per init, in nanoseconds
+        double allocs_per_op;  //!< The average number of heap allocations per init
+    };
+
+
+    /** Time the first call to init() on a set of freshly constructed parameter
+     *  objects, as scripts construct their parameters along with the script and
+     *  init them on the first message. Construction happens outside the timed
+     *  loop, so only the cost of init() is measured.
+     *
+     * @param name       The name of the parameter to look for in the design note.
+     * @param host       The ID of the object the parameters are attached to.
+     * @param note       The parsed design note to initialise the parameters from.
+     * @param iterations The number of parameters to construct and initialise.
+     * @param init       The function that calls init() on a parameter.
+     * @return The timing and allocation results.
+     */
+    template <class Param, class InitFunc>
+    BenchResult run_bench(const char* name, int host, const DesignNote& note, int iterations, InitFunc init)
+    {
+        std::vector<Param*> params;
+        params.reserve(iterations);
+        for(int i = 0; i < iterations; ++i)
+            params.push_back(new Param(host, "TWBench", name));
+
+        ulong allocs = host_malloc().allocs;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        for(int i = 0; i < iterations; ++i)
+            init(*params[i], note);
+
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+        BenchResult result;
+        result.ns_per_op     = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+        result.allocs_per_op = double(host_malloc().allocs - allocs) / iterations;
+
+        // Release in reverse order, as cMemoryAllocator searches its block list from
+        // the most recent allocation when freeing.
+        for(int i = iterations - 1; i >= 0; --i)
+            delete params[i];
+
+        return result;
+    }
+
+
+    /** Run the benchmark for one parameter type over every note in the corpus,
+     *  printing a line of results for each note.
+     */
+    template <class Param, class InitFunc>
+    void bench_type(const char* type, const char* name, int host, int iterations, const char* filter, InitFunc init)
+    {
+        if(filter && strcasecmp(filter, type)) return;
+
+        for(size_t i = 0; i < corpus_size; ++i) {
+            DesignNote note(corpus[i].note);
+
+            BenchResult result = run_bench<Param>(name, host, note, iterations, init);
+            printf("%-22s %-8s %10.1f %10.2f\n", type, corpus[i].name, result.ns_per_op, result.allocs_per_op);
+        }
+    }
+
+
+    /** Time parsing each note in the corpus into a DesignNote, printing a line
+     *  of results for each note.
+     */
+    void bench_parse(int iterations, const char* filter)
+    {
+        if(filter && strcasecmp(filter, "DesignNote")) return;
+
+        for(size_t i = 0; i < corpus_size; ++i) {
+            size_t params = 0;
+
+            ulong allocs = host_malloc().allocs;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+            for(int pass = 0; pass < iterations; ++pass) {
+                DesignNote note(corpus[i].note);
+                params += note.size();
+            }
+
+            std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+            double ns_per_op     = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+            double allocs_per_op = double(host_malloc().allocs - allocs) / iterations;
+
+            // Use the parameter count, so the parse can't be optimised away
+            if(!params) printf("%-22s %-8s parsed no parameters\n", "DesignNote", corpus[i].name);
+            printf("%-22s %-8s %10.1f %10.2f\n", "DesignNote", corpus[i].name, ns_per_op, allocs_per_op);
+        }
+    }
+
+
+    /** Time target searches over a field of SEARCH_OBJECTS objects scattered
+     *  around the host, and over its LINK_FANOUT ControlDevice and ScriptParams
+     *  links, printing a line of results for each search. Unlike the other
+     *  benchmarks, this times values() on an initialised parameter, as searches
+     *  happen whenever a trap or trigger fires rather than at init.
+     */
+    void bench_search(int host, int iterations, const char* filter)
+    {
+        if(filter && strcasecmp(filter, "TargetSearch")) return;
+
+        const CorpusNote searches[] = {
+            { "near",   "TWBenchDest=<40:@Scatter" },
+            { "far",    "TWBenchDest=>450:@Scatter" },
+            { "direct", "TWBenchDest=<40:*Scatter" },
+            { "links",  "TWBenchDest=&ControlDevice" },
+            { "random", "TWBenchDest=&?[3]ControlDevice" },
+            { "weighted", "TWBenchDest=&[3]Weighted" },
+        };
+
+        for(size_t i = 0; i < sizeof(searches) / sizeof(searches[0]); ++i) {
+            DesignParamTarget param(host, "TWBench", "Dest");
+            param.init(DesignNote(searches[i].note), "[me]");
+
+            sScrMsg msg;
+            msg.to   = host;
+            msg.from = host;
+
+            TargetList matches;
+            size_t found = 0;
+
+            ulong allocs = host_malloc().allocs;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+            for(int pass = 0; pass < iterations; ++pass) {
+                msg.time = pass;
+                param.values(&msg, matches);
+                found += matches.size();
+            }
+
+            std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+            double ns_per_op     = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+            double allocs_per_op = double(host_malloc().allocs - allocs) / iterations;
+
+            printf("%-22s %-8s %10.1f %10.2f %8.1f found\n", "TargetSearch", searches[i].name, ns_per_op, allocs_per_op, double(found) / iterations);
+        }
+    }
+
+
+    /** Build the world the parameters are initialised in. Targets may name
+     *  objects, and qvar calculations need their qvars to exist.
+     */
+    int build_world(HostScriptMan& manager)
+    {
+        int marker = manager.add_archetype("Marker");
+        int host   = manager.add_object("BenchHost", marker);
+
+        manager.add_object("Guard", manager.add_archetype("Guard"));
+        for(int i = 0; i < LINK_FANOUT; ++i) {
+            manager.add_link("ControlDevice", host, manager.add_object(NULL, marker));
+
+            char weight[8];
+            int length = snprintf(weight, sizeof(weight), "%d", 1 + i % 10);
+            manager.add_link("ScriptParams", host, manager.add_object(NULL, marker), weight, length + 1);
+        }
+
+        // A field of objects for the target searches, a fifth of which have physics
+        int scatter = manager.add_archetype("Scatter", marker);
+        int mobile  = manager.add_archetype("MobileScatter", scatter);
+        manager.set_property(mobile, "PhysType", "Type", cMultiParm(3));
+
+        for(int i = 0; i < SEARCH_OBJECTS; ++i) {
+            cScrVec position(float(i % 40) * 25.0f - 500.0f, float(i / 40 % 40) * 25.0f - 500.0f, float(i / 1600) * 10.0f);
+            manager.add_object(NULL, (i % 5) ? scatter : mobile, position);
+        }
+
+        const char* qvars[] = { "speed", "delay", "immediate", "target", "capcount", "capfall", "caplimit", "velx", "vely", "velz" };
+        for(size_t i = 0; i < sizeof(qvars) / sizeof(qvars[0]); ++i)
+            manager.set_qvar(qvars[i], int(i) + 1);
+
+        return host;
+    }
+
+
+    void usage(const char* name)
+    {
+        fprintf(stderr, "Usage: %s [-n iterations] [-t type]\n", name);
+        fprintf(stderr, "    -n iterations  The number of parameters to init per type and note (default 20000)\n");
+        fprintf(stderr, "    -t type        Only benchmark the named type, eg: DesignParamTarget, DesignNote, or TargetSearch\n");
+    }
+}
+
+
+int main(int argc, char** argv)
+{
+    int iterations = 20000;
+    const char* filter = NULL;
+
+    for(int arg = 1; arg < argc; ++arg) {
+        if(!strcmp(argv[arg], "-n") && arg + 1 < argc) {
+            iterations = atoi(argv[++arg]);
+        } else if(!strcmp(argv[arg], "-t") && arg + 1 < argc) {
+            filter = argv[++arg];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if(iterations < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    HostScriptMan* manager = new HostScriptMan();
+    host_module_init(manager, false);
+
+    int host = build_world(*manager);
+
+    printf("%-22s %-8s %10s %10s\n", "type", "note", "ns/op", "allocs/op");
+
+    bench_parse(iterations, filter);
+    bench_search(host, iterations / 10, filter);
+
+    bench_type<DesignParamString>("DesignParamString", "Name", host, iterations, filter,
+                                  [](DesignParamString& param, const DesignNote& note) { param.init(note, "default"); });
+
+    bench_type<DesignParamFloat>("DesignParamFloat", "Speed", host, iterations, filter,
+                                 [](DesignParamFloat& param, const DesignNote& note) { param.init(note, 1.0f); });
+
+    bench_type<DesignParamTime>("DesignParamTime", "Rate", host, iterations, filter,
+                                [](DesignParamTime& param, const DesignNote& note) { param.init(note, 500); });
+
+    bench_type<DesignParamBool>("DesignParamBool", "Immediate", host, iterations, filter,
+                                [](DesignParamBool& param, const DesignNote& note) { param.init(note, false); });
+
+    bench_type<DesignParamCountMode>("DesignParamCountMode", "CountOnly", host, iterations, filter,
+                                     [](DesignParamCountMode& param, const DesignNote& note) { param.init(note); });
+
+    bench_type<DesignParamTarget>("DesignParamTarget", "Dest", host, iterations, filter,
+                                  [](DesignParamTarget& param, const DesignNote& note) { param.init(note, "[me]"); });
+
+    bench_type<DesignParamCapacitor>("DesignParamCapacitor", "Capacitor", host, iterations, filter,
+                                     [](DesignParamCapacitor& param, const DesignNote& note) { param.init(note); });
+
+    bench_type<DesignParamFloatVec>("DesignParamFloatVec", "Velocity", host, iterations, filter,
+                                    [](DesignParamFloatVec& param, const DesignNote& note) { param.init(note); });
+
+    delete manager;
+
+    return 0;
+}
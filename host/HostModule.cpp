@@ -0,0 +1,222 @@
+/** @file
+ * This file contains the host build module globals, and the parts of
+ * liblg's basic types that are implemented out of line.
+ *
+ * @author Chris Page &lt;chris@starforge.co.uk&gt;
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <cstdarg>
+#include <malloc.h>
+
+#include "ScriptModule.h"
+#include "Allocator.h"
+#include "HostModule.h"
+
+namespace {
+    int __cdecl NullPrintf(const char*, ...)
+    {
+        return 0;
+    }
+
+    int __cdecl StderrPrintf(const char* format, ...)
+    {
+        va_list args;
+
+        va_start(args, format);
+        int result = vfprintf(stderr, format, args);
+        va_end(args);
+
+        return result;
+    }
+
+    HostMalloc allocator;
+}
+
+// As in the game, all module allocations - including operator new - go through
+// cMemoryAllocator, which passes them on to the host allocator.
+cMemoryAllocator      g_Allocator;
+IMalloc*              g_pMalloc        = g_Allocator.AttachMalloc(&allocator, "twhost");
+IScriptMan*           g_pScriptManager = NULL;
+volatile MPrintfProc  g_pfnMPrintf     = NullPrintf;
+
+
+void host_module_init(IScriptMan* manager, bool verbose)
+{
+    g_pScriptManager = manager;
+    g_pfnMPrintf     = verbose ? StderrPrintf : NullPrintf;
+}
+
+
+HostMalloc& host_malloc(void)
+{
+    return allocator;
+}
+
+
+/* ------------------------------------------------------------------------
+ *  HostMalloc
+ */
+
+STDMETHODIMP_(void*) HostMalloc::Alloc(ulong size)
+{
+    ++allocs;
+    bytes += size;
+
+    return malloc(size);
+}
+
+
+STDMETHODIMP_(void*) HostMalloc::Realloc(void* ptr, ulong size)
+{
+    if(!ptr) ++allocs;
+    bytes += size;
+
+    return realloc(ptr, size);
+}
+
+
+STDMETHODIMP_(void) HostMalloc::Free(void* ptr)
+{
+    if(ptr) ++frees;
+
+    free(ptr);
+}
+
+
+STDMETHODIMP_(ulong) HostMalloc::GetSize(void* ptr)
+{
+    return malloc_usable_size(ptr);
+}
+
+
+STDMETHODIMP_(int) HostMalloc::DidAlloc(void*)
+{
+    return -1;
+}
+
+
+STDMETHODIMP_(void) HostMalloc::HeapMinimize(void)
+{
+    /* fnord */
+}
+
+
+/* ------------------------------------------------------------------------
+ *  Basic types
+ */
+
+const cScrVec    cScrVec::Zero;
+const cMultiParm cMultiParm::Undef;
+
+
+cMultiParm::operator int() const
+{
+    switch(type) {
+        case kMT_Int:    return i;
+        case kMT_Float:  return static_cast<int>(f);
+        case kMT_String: return psz ? strtol(psz, NULL, 10) : 0;
+        default:         return 0;
+    }
+}
+
+
+cMultiParm::operator float() const
+{
+    switch(type) {
+        case kMT_Int:    return static_cast<float>(i);
+        case kMT_Float:  return f;
+        case kMT_String: return psz ? strtof(psz, NULL) : 0.0f;
+        default:         return 0.0f;
+    }
+}
+
+
+cMultiParm::operator const char*() const
+{
+    return (type == kMT_String && psz) ? psz : "";
+}
+
+
+cMultiParm::operator const mxs_vector*() const
+{
+    return (type == kMT_Vector) ? pVector : NULL;
+}
+
+
+bool cMultiParm::operator==(const char* val) const
+{
+    return type == kMT_String && psz && val && !strcmp(psz, val);
+}
+
+
+void cMultiParm::clear()
+{
+    if(type == kMT_String && psz) {
+        g_pMalloc -> Free(psz);
+    } else if(type == kMT_Vector && pVector) {
+        g_pMalloc -> Free(pVector);
+    }
+
+    type = kMT_Undef;
+    i = 0;
+}
+
+
+void cMultiParm::copy(const sMultiParm& val)
+{
+    switch(val.type) {
+        case kMT_String:  set_string(val.psz);
+            break;
+        case kMT_Vector:  set_vector(*val.pVector);
+            break;
+        default:
+            clear();
+            type = val.type;
+            if(type == kMT_Float) {
+                f = val.f;
+            } else {
+                i = val.i;
+            }
+            break;
+    }
+}
+
+
+void cMultiParm::set_string(const char* val)
+{
+    size_t len = val ? strlen(val) : 0;
+    char* copy = static_cast<char*>(g_pMalloc -> Alloc(len + 1));
+    if(val) memcpy(copy, val, len);
+    copy[len] = '\0';
+
+    clear();
+    type = kMT_String;
+    psz  = copy;
+}
+
+
+void cMultiParm::set_vector(const mxs_vector& val)
+{
+    mxs_vector* copy = static_cast<mxs_vector*>(g_pMalloc -> Alloc(sizeof(mxs_vector)));
+    *copy = val;
+
+    clear();
+    type    = kMT_Vector;
+    pVector = copy;
+}
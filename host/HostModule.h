@@ -0,0 +1,65 @@
+/** @file
+ * This file contains the interface for the host build module globals - the
+ * stand-ins for the things ScriptModule.cpp and liblg normally provide.
+ *
+ * @author Chris Page &lt;chris@starforge.co.uk&gt;
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef HOSTMODULE_H
+#define HOSTMODULE_H
+
+#include <lg/config.h>
+#include <lg/objstd.h>
+#include <lg/interfaceimp.h>
+
+/** A counting allocator standing in for the engine's heap in the host build.
+ *  g_pMalloc and operator new reach it via cMemoryAllocator, as they would in
+ *  the game, so the counts let the benchmarks report how many heap allocations
+ *  an operation makes.
+ */
+class HostMalloc : public cInterfaceImp<IMalloc, IID_Def<IMalloc>, kInterfaceImpStatic>
+{
+public:
+    HostMalloc() : allocs(0), frees(0), bytes(0)
+        { /* fnord */ }
+
+    STDMETHOD_(void*,Alloc)(ulong size);
+    STDMETHOD_(void*,Realloc)(void* ptr, ulong size);
+    STDMETHOD_(void,Free)(void* ptr);
+    STDMETHOD_(ulong,GetSize)(void* ptr);
+    STDMETHOD_(int,DidAlloc)(void* ptr);
+    STDMETHOD_(void,HeapMinimize)(void);
+
+    ulong allocs;  //!< The number of allocations made
+    ulong frees;   //!< The number of blocks released
+    ulong bytes;   //!< The total number of bytes requested
+};
+
+
+/** Install the host stand-ins as the module globals.
+ *
+ * @param manager The script manager to install as g_pScriptManager.
+ * @param verbose If true, monolog output is written to stderr, otherwise
+ *                it is discarded.
+ */
+void host_module_init(IScriptMan* manager, bool verbose);
+
+
+/** Obtain the allocator installed as g_pMalloc.
+ */
+HostMalloc& host_malloc(void);
+
+#endif // HOSTMODULE_H
@@ -0,0 +1,240 @@
+/** @file
+ * This file contains host build implementations of the ScriptLib functions
+ * used by the script module. These follow the behaviour of Telliamed's
+ * ScriptLib closely enough for profiling purposes, but operate on the world
+ * held by HostScriptMan.
+ *
+ * @author Chris Page &lt;chris@starforge.co.uk&gt;
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#include <cctype>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "ScriptLib.h"
+#include "HostScriptMan.h"
+
+namespace {
+
+    /** Duplicate a string using g_pMalloc, as ScriptLib does for all returned strings.
+     */
+    char* malloc_strdup(const char* str, size_t len)
+    {
+        char* copy = static_cast<char*>(g_pMalloc -> Alloc(len + 1));
+        memcpy(copy, str, len);
+        copy[len] = '\0';
+
+        return copy;
+    }
+
+
+    HostScriptMan* host_manager(void)
+    {
+        return static_cast<HostScriptMan*>(g_pScriptManager);
+    }
+
+
+    /** Locate the value for the named parameter in the design note, returning
+     *  a pointer to the start of the value and its length via the arguments.
+     */
+    bool find_param(const char* note, const char* param, const char** value, size_t* length)
+    {
+        size_t namelen = strlen(param);
+
+        while(*note) {
+            // Skip leading whitespace and separators
+            while(*note && (isspace(*note) || *note == ';')) ++note;
+            if(!*note) break;
+
+            const char* name_start = note;
+            while(*note && *note != '=' && *note != ';') ++note;
+
+            // Trim whitespace from the end of the name
+            const char* name_end = note;
+            while(name_end > name_start && isspace(*(name_end - 1))) --name_end;
+
+            bool matched = (*note == '=' && size_t(name_end - name_start) == namelen && !strncasecmp(name_start, param, namelen));
+            if(*note != '=') continue;
+            ++note;
+
+            // Values may be quoted, in which case the ; separator may appear in the value
+            while(*note && isspace(*note)) ++note;
+            const char* value_start = note;
+            const char* value_end;
+            if(*note == '"' || *note == '\'') {
+                char quote = *note++;
+                value_start = note;
+                while(*note && *note != quote) ++note;
+                value_end = note;
+                if(*note) ++note;
+                while(*note && *note != ';') ++note;
+            } else {
+                while(*note && *note != ';') ++note;
+                value_end = note;
+                while(value_end > value_start && isspace(*(value_end - 1))) --value_end;
+            }
+
+            if(matched) {
+                *value  = value_start;
+                *length = value_end - value_start;
+                return true;
+            }
+        }
+
+        return false;
+    }
+}
+
+
+char* GetObjectParams(int iObj)
+{
+    const cMultiParm* note = host_manager() -> get_property(iObj, "DesignNote", NULL);
+    if(!note || note -> type != kMT_String) return NULL;
+
+    const char* str = static_cast<const char*>(*note);
+    return malloc_strdup(str, strlen(str));
+}
+
+
+char* GetParamString(const char* pszString, const char* pszParam, const char* pszDefault)
+{
+    const char* value;
+    size_t length;
+
+    if(pszString && find_param(pszString, pszParam, &value, &length))
+        return malloc_strdup(value, length);
+
+    return pszDefault ? malloc_strdup(pszDefault, strlen(pszDefault)) : NULL;
+}
+
+
+int GetObjectParamInt(int iObj, const char* pszParam, int iDefault)
+{
+    char* note = GetObjectParams(iObj);
+    int result = iDefault;
+
+    if(note) {
+        char* value = GetParamString(note, pszParam, NULL);
+        if(value) {
+            result = strtol(value, NULL, 10);
+            g_pMalloc -> Free(value);
+        }
+        g_pMalloc -> Free(note);
+    }
+
+    return result;
+}
+
+
+void SetObjectParamInt(int iObj, const char* pszParam, int iVal)
+{
+    char* note = GetObjectParams(iObj);
+    std::string updated;
+
+    // Rebuild the note without the parameter, then append the new value
+    if(note) {
+        std::string current(note);
+        g_pMalloc -> Free(note);
+
+        size_t pos = 0;
+        while(pos < current.size()) {
+            size_t end = current.find(';', pos);
+            if(end == std::string::npos) end = current.size();
+
+            std::string param = current.substr(pos, end - pos);
+            size_t eq = param.find('=');
+            if(!param.empty() && (eq == std::string::npos || strcasecmp(param.substr(0, eq).c_str(), pszParam))) {
+                if(!updated.empty()) updated += ';';
+                updated += param;
+            }
+
+            pos = end + 1;
+        }
+    }
+
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%d", iVal);
+
+    if(!updated.empty()) updated += ';';
+    updated += pszParam;
+    updated += '=';
+    updated += buffer;
+
+    host_manager() -> set_design_note(iObj, updated.c_str());
+}
+
+
+int StrToObject(const char* pszName)
+{
+    if(!pszName || !*pszName) return 0;
+
+    char* end;
+    long id = strtol(pszName, &end, 10);
+    if(!*end) return host_manager() -> find_object(id) ? int(id) : 0;
+
+    return host_manager() -> find_named(pszName);
+}
+
+
+void FixupPlayerLinks(int, int)
+{
+    // Nothing to fix up in the host world
+}
+
+
+long IterateLinks(const char* pszLinkType, int iSource, int iDest,
+                  LinkIterCallbackFunc pfnLinkIterCallback, IScript* pScript, void* pData)
+{
+    return IterateLinksByData(pszLinkType, iSource, iDest, NULL, 0, pfnLinkIterCallback, pScript, pData);
+}
+
+
+long IterateLinksByData(const char* pszLinkType, int iSource, int iDest,
+                        const void* pvFilter, int iFilterLen,
+                        LinkIterCallbackFunc pfnLinkIterCallback, IScript* pScript, void* pData)
+{
+    SService<ILinkSrv>      link_srv(g_pScriptManager);
+    SService<ILinkToolsSrv> link_tools(g_pScriptManager);
+
+    long flavour = link_tools -> LinkKindNamed(pszLinkType);
+    if(!flavour) return 0;
+
+    std::vector<long> ids;
+    host_manager() -> find_links(ids, flavour, iSource, iDest);
+
+    long count = 0;
+    for(std::vector<long>::iterator it = ids.begin(); it != ids.end(); ++it) {
+        HostScriptMan::Link* link = host_manager() -> find_link(*it);
+        if(!link) continue;
+
+        if(pvFilter && iFilterLen) {
+            if(link -> data.size() < size_t(iFilterLen) || memcmp(&link -> data[0], pvFilter, iFilterLen))
+                continue;
+        }
+
+        // The callback is given a query positioned on this link
+        std::vector<long> single(1, *it);
+        SInterface<ILinkQuery> query = host_manager() -> query_links(single);
+
+        ++count;
+        if(!pfnLinkIterCallback(link_srv, query, pScript, pData)) break;
+    }
+
+    return count;
+}
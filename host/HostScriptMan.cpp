@@ -0,0 +1,1275 @@
+/** @file
+ * This file contains the implementation of the host build script manager
+ * and the script services it provides.
+ *
+ * @author Chris Page &lt;chris@starforge.co.uk&gt;
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+#include "ScriptLib.h"
+#include "HostScriptMan.h"
+
+namespace {
+
+    /* ------------------------------------------------------------------------
+     *  Helpers
+     */
+
+    /** Build the key used to store a property field in an object's property map.
+     */
+    std::string prop_key(const char* prop, const char* field)
+    {
+        std::string key(prop ? prop : "");
+        key += ':';
+        if(field) key += field;
+
+        return key;
+    }
+
+
+    /** Copy a multiparm into a raw sMultiParm owned by the caller. Strings and
+     *  vectors are duplicated using g_pMalloc, as the engine does.
+     */
+    void export_parm(sMultiParm* dest, const cMultiParm& src)
+    {
+        dest -> type = src.type;
+        switch(src.type) {
+            case kMT_String: {
+                    const char* str = static_cast<const char*>(src);
+                    dest -> psz = static_cast<char*>(g_pMalloc -> Alloc(strlen(str) + 1));
+                    strcpy(dest -> psz, str);
+                }
+                break;
+            case kMT_Vector:
+                dest -> pVector = static_cast<mxs_vector*>(g_pMalloc -> Alloc(sizeof(mxs_vector)));
+                *(dest -> pVector) = *src.pVector;
+                break;
+            case kMT_Float: dest -> f = src.f;
+                break;
+            default: dest -> i = src.i;
+                break;
+        }
+    }
+
+
+    /* ------------------------------------------------------------------------
+     *  Query objects
+     */
+
+    /** An object query over a precomputed list of object IDs.
+     */
+    class HostObjectQuery : public cInterfaceImp<IObjectQuery>
+    {
+    public:
+        HostObjectQuery(std::vector<int>& matches) : pos(0)
+            { objects.swap(matches); }
+
+        STDMETHOD_(Bool,Done)(void)
+            { return pos >= objects.size(); }
+
+        STDMETHOD_(int,Object)(void)
+            { return pos < objects.size() ? objects[pos] : 0; }
+
+        STDMETHOD(Next)(void)
+            { ++pos; return S_OK; }
+
+    private:
+        std::vector<int> objects;
+        size_t pos;
+    };
+
+
+    /** A link query over a precomputed list of link IDs.
+     */
+    class HostLinkQuery : public cInterfaceImp<ILinkQuery>
+    {
+    public:
+        HostLinkQuery(HostScriptMan& manager, std::vector<long>& matches) : man(manager), pos(0)
+            { ids.swap(matches); }
+
+        STDMETHOD_(Bool,Done)(void) const
+            { return pos >= ids.size(); }
+
+        STDMETHOD(Link)(sLink* dest) const
+        {
+            HostScriptMan::Link* link = current();
+            if(!link) return S_FALSE;
+
+            dest -> source = link -> source;
+            dest -> dest   = link -> dest;
+            dest -> flavor = static_cast<short>(link -> flavour);
+            return S_OK;
+        }
+
+        STDMETHOD_(long,ID)(void) const
+            { return pos < ids.size() ? ids[pos] : 0; }
+
+        STDMETHOD_(void*,Data)(void) const
+        {
+            HostScriptMan::Link* link = current();
+            return (link && !link -> data.empty()) ? &link -> data[0] : NULL;
+        }
+
+        STDMETHOD(Next)(void)
+            { ++pos; return S_OK; }
+
+    private:
+        HostScriptMan::Link* current() const
+            { return pos < ids.size() ? man.find_link(ids[pos]) : NULL; }
+
+        HostScriptMan& man;
+        std::vector<long> ids;
+        size_t pos;
+    };
+
+
+    /** A relation, restricted to the parts used by the scripts.
+     */
+    class HostRelation : public cInterfaceImp<IRelation>
+    {
+    public:
+        HostRelation(HostScriptMan& manager, long flavourid) : man(manager), flavour(flavourid)
+            { /* fnord */ }
+
+        STDMETHOD_(long,GetSingleLink)(object source, object dest)
+        {
+            std::vector<long> matches;
+            man.find_links(matches, flavour, source, dest);
+
+            return matches.empty() ? 0 : matches[0];
+        }
+
+        STDMETHOD_(Bool,Get)(long link_id, sLink* dest) const
+        {
+            HostScriptMan::Link* link = man.find_link(link_id);
+            if(!link) return false;
+
+            dest -> source = link -> source;
+            dest -> dest   = link -> dest;
+            dest -> flavor = static_cast<short>(link -> flavour);
+            return true;
+        }
+
+    private:
+        HostScriptMan& man;
+        long flavour;
+    };
+
+
+    /* ------------------------------------------------------------------------
+     *  Services
+     */
+
+    /** Base for the service implementations. Services live as long as the
+     *  manager, so references are not counted.
+     */
+    template <class I>
+    class HostService : public cInterfaceImp<I, IID_Def<I>, kInterfaceImpStatic>
+    {
+    public:
+        HostService(HostScriptMan& manager) : man(manager)
+            { /* fnord */ }
+
+    protected:
+        HostScriptMan& man;
+    };
+
+
+    class HostQuestSrv : public HostService<IQuestSrv>
+    {
+    public:
+        HostQuestSrv(HostScriptMan& manager) : HostService<IQuestSrv>(manager)
+            { /* fnord */ }
+
+        STDMETHOD(SubscribeMsg)(object obj_id, const char* name, eQuestDataType)
+            { man.subscribe_qvar(obj_id, name); return S_OK; }
+
+        STDMETHOD(UnsubscribeMsg)(object obj_id, const char* name)
+            { man.unsubscribe_qvar(obj_id, name); return S_OK; }
+
+        STDMETHOD(Set)(const char* name, int value, eQuestDataType)
+            { man.set_qvar(name, value); return S_OK; }
+
+        STDMETHOD_(int,Get)(const char* name)
+            { return man.get_qvar(name); }
+
+        STDMETHOD_(int,Exists)(const char* name)
+        {
+            bool exists;
+            man.get_qvar(name, &exists);
+            return exists;
+        }
+
+        STDMETHOD(Delete)(const char* name)
+            { man.delete_qvar(name); return S_OK; }
+    };
+
+
+    class HostLinkSrv : public HostService<ILinkSrv>
+    {
+    public:
+        HostLinkSrv(HostScriptMan& manager) : HostService<ILinkSrv>(manager)
+            { /* fnord */ }
+
+        STDMETHOD(AnyExist)(true_bool& result, linkkind flavour, object source, object dest)
+        {
+            std::vector<long> matches;
+            man.find_links(matches, flavour, source, dest);
+
+            result = !matches.empty();
+            return S_OK;
+        }
+
+        STDMETHOD(GetAll)(linkset& result, linkkind flavour, object source, object dest)
+        {
+            std::vector<long> matches;
+            man.find_links(matches, flavour, source, dest);
+
+            result = man.query_links(matches);
+            return S_OK;
+        }
+
+        STDMETHOD(GetAllInheritedSingle)(linkset& result, linkkind flavour, object source, object dest)
+        {
+            std::vector<long> matches;
+
+            // Walk up the inheritance chain until something has links
+            int current = source;
+            while(current && matches.empty()) {
+                man.find_links(matches, flavour, current, dest);
+
+                HostScriptMan::Object* obj = man.find_object(current);
+                current = obj ? obj -> archetype : 0;
+            }
+
+            result = man.query_links(matches);
+            return S_OK;
+        }
+    };
+
+
+    class HostLinkToolsSrv : public HostService<ILinkToolsSrv>
+    {
+    public:
+        HostLinkToolsSrv(HostScriptMan& manager) : HostService<ILinkToolsSrv>(manager)
+            { /* fnord */ }
+
+        STDMETHOD_(long,LinkKindNamed)(const char* name)
+            { return man.find_flavour(name); }
+
+        STDMETHOD(LinkSetData)(long link_id, const char* field, const cMultiParm& value)
+        {
+            HostScriptMan::Link* link = man.find_link(link_id);
+            if(!link) return S_FALSE;
+
+            link -> fields[field ? field : ""] = value;
+            return S_OK;
+        }
+    };
+
+
+    class HostLinkManager : public HostService<ILinkManager>
+    {
+    public:
+        HostLinkManager(HostScriptMan& manager) : HostService<ILinkManager>(manager)
+            { /* fnord */ }
+
+        STDMETHOD_(IRelation*,GetRelationNamed)(const char* name)
+            { return new HostRelation(man, man.find_flavour(name)); }
+
+        STDMETHOD_(long,Add)(object source, object dest, long flavour)
+        {
+            if(flavour <= 0) return 0;
+
+            HostScriptMan::Link* link = man.find_link(man.add_link(NULL, source, dest));
+            link -> flavour = flavour;
+            return link -> id;
+        }
+
+        STDMETHOD(Remove)(long link_id)
+            { man.remove_link(link_id); return S_OK; }
+
+        STDMETHOD(SetData)(long link_id, void* data)
+        {
+            HostScriptMan::Link* link = man.find_link(link_id);
+            if(!link) return S_FALSE;
+
+            uint size = man.flavour_data_size(link -> flavour);
+            const char* bytes = static_cast<const char*>(data);
+            link -> data.assign(bytes, bytes + size);
+            return S_OK;
+        }
+    };
+
+
+    class HostObjectSrv : public HostService<IObjectSrv>
+    {
+    public:
+        HostObjectSrv(HostScriptMan& manager) : HostService<IObjectSrv>(manager)
+            { /* fnord */ }
+
+        STDMETHOD(BeginCreate)(object& result, object archetype)
+            { result = man.add_object(NULL, archetype); return S_OK; }
+
+        STDMETHOD(EndCreate)(object)
+            { return S_OK; }
+
+        STDMETHOD(Destroy)(object obj_id)
+            { man.destroy_object(obj_id); return S_OK; }
+
+        STDMETHOD(Named)(object& result, const char* name)
+            { result = man.find_named(name); return S_OK; }
+
+        STDMETHOD(Position)(cScrVec& result, object obj_id)
+        {
+            HostScriptMan::Object* obj = man.find_object(obj_id);
+            result = obj ? obj -> position : cScrVec::Zero;
+            return S_OK;
+        }
+
+        STDMETHOD(Facing)(cScrVec& result, object obj_id)
+        {
+            HostScriptMan::Object* obj = man.find_object(obj_id);
+            result = obj ? obj -> facing : cScrVec::Zero;
+            return S_OK;
+        }
+
+        STDMETHOD(Teleport)(object obj_id, const cScrVec& position, const cScrVec& facing, object)
+        {
+            HostScriptMan::Object* obj = man.find_object(obj_id);
+            if(obj) {
+                obj -> position = position;
+                obj -> facing   = facing;
+            }
+            return S_OK;
+        }
+
+        STDMETHOD(InheritsFrom)(true_bool& result, object obj_id, object archetype)
+            { result = man.inherits_from(obj_id, archetype); return S_OK; }
+
+        STDMETHOD(HasMetaProperty)(true_bool& result, object obj_id, object metaprop)
+        {
+            HostScriptMan::Object* obj = man.find_object(obj_id);
+            result = obj && obj -> metaprops.count(metaprop);
+            return S_OK;
+        }
+
+        STDMETHOD(AddMetaProperty)(object obj_id, object metaprop)
+        {
+            HostScriptMan::Object* obj = man.find_object(obj_id);
+            if(obj) obj -> metaprops.insert(metaprop);
+            return S_OK;
+        }
+
+        STDMETHOD(RenderedThisFrame)(true_bool& result, object obj_id)
+        {
+            HostScriptMan::Object* obj = man.find_object(obj_id);
+            result = obj && obj -> rendered;
+            return S_OK;
+        }
+    };
+
+
+    class HostPropertySrv : public HostService<IPropertySrv>
+    {
+    public:
+        HostPropertySrv(HostScriptMan& manager) : HostService<IPropertySrv>(manager)
+            { /* fnord */ }
+
+        STDMETHOD(Get)(cMultiParm& result, object obj_id, const char* prop, const char* field)
+        {
+            const cMultiParm* value = man.get_property(obj_id, prop, field);
+            if(!value) {
+                result = 0;
+                return S_FALSE;
+            }
+
+            result = *value;
+            return S_OK;
+        }
+
+        STDMETHOD(Set)(object obj_id, const char* prop, const char* field, const cMultiParm& value)
+            { man.set_property(obj_id, prop, field, value); return S_OK; }
+
+        STDMETHOD(SetSimple)(object obj_id, const char* prop, const cMultiParm& value)
+            { man.set_property(obj_id, prop, NULL, value); return S_OK; }
+
+        STDMETHOD(Add)(object obj_id, const char* prop)
+        {
+            if(!man.get_property(obj_id, prop, NULL))
+                man.set_property(obj_id, prop, NULL, 0);
+            return S_OK;
+        }
+
+        STDMETHOD(Remove)(object obj_id, const char* prop)
+        {
+            HostScriptMan::Object* obj = man.find_object(obj_id);
+            if(obj) obj -> props.erase(prop_key(prop, NULL));
+            return S_OK;
+        }
+
+        STDMETHOD_(Bool,Possessed)(object obj_id, const char* prop)
+        {
+            // A property is possessed if any of its fields are set on the object
+            // or on one of its archetypes.
+            std::string prefix = prop_key(prop, NULL);
+
+            for(int current = obj_id; current; ) {
+                HostScriptMan::Object* obj = man.find_object(current);
+                if(!obj) break;
+
+                std::map<std::string, cMultiParm, HostNameLess>::const_iterator it = obj -> props.lower_bound(prefix);
+                if(it != obj -> props.end() && !strncasecmp(it -> first.c_str(), prefix.c_str(), prefix.size()))
+                    return true;
+
+                current = obj -> archetype;
+            }
+
+            return false;
+        }
+    };
+
+
+    class HostActReactSrv : public HostService<IActReactSrv>
+    {
+    public:
+        HostActReactSrv(HostScriptMan& manager) : HostService<IActReactSrv>(manager)
+            { /* fnord */ }
+
+        STDMETHOD(Stimulate)(object obj_id, object stimulus, float intensity, object source)
+        {
+            HostScriptMan::Object* stim = man.find_object(stimulus);
+            std::string message = (stim ? stim -> name : std::string("Unknown")) + "Stimulus";
+
+            sStimMsg msg;
+            msg.to        = obj_id;
+            msg.from      = source;
+            msg.message   = message.c_str();
+            msg.time      = man.sim_time();
+            msg.stimulus  = stimulus;
+            msg.intensity = intensity;
+            msg.sensor    = 0;
+            msg.source    = source;
+
+            man.deliver(&msg);
+            return S_OK;
+        }
+    };
+
+
+    class HostPhysSrv : public HostService<IPhysSrv>
+    {
+    public:
+        HostPhysSrv(HostScriptMan& manager) : HostService<IPhysSrv>(manager)
+            { /* fnord */ }
+
+        STDMETHOD(LaunchProjectile)(object& result, object launcher, object archetype, float, int, const cScrVec&)
+        {
+            HostScriptMan::Object* obj = man.find_object(launcher);
+            result = man.add_object(NULL, archetype, obj ? obj -> position : cScrVec::Zero);
+            return S_OK;
+        }
+
+        STDMETHOD(SetVelocity)(object obj_id, const cScrVec& velocity)
+            { man.set_property(obj_id, "PhysState", "Velocity", velocity); return S_OK; }
+
+        STDMETHOD(ControlVelocity)(object obj_id, const cScrVec& velocity)
+            { man.set_property(obj_id, "PhysControl", "Velocity", velocity); return S_OK; }
+
+        // Objects are physical if they have, or inherit, a PhysType
+        STDMETHOD_(Bool,HasPhysics)(object obj_id)
+            { return man.get_property(obj_id, "PhysType", "Type") != NULL; }
+    };
+
+
+    class HostSoundScrSrv : public HostService<ISoundScrSrv>
+    {
+    public:
+        HostSoundScrSrv(HostScriptMan& manager) : HostService<ISoundScrSrv>(manager)
+            { /* fnord */ }
+
+        STDMETHOD(PlayEnvSchema)(true_bool& result, object, const char*, object, object, eEnvSoundLoc, eSoundNetwork)
+            { result = false; return S_OK; }
+    };
+
+
+    class HostPGroupSrv : public HostService<IPGroupSrv>
+    {
+    public:
+        HostPGroupSrv(HostScriptMan& manager) : HostService<IPGroupSrv>(manager)
+            { /* fnord */ }
+
+        STDMETHOD(SetActive)(object obj_id, int active)
+            { man.set_property(obj_id, "ParticleGroup", "Active", active); return S_OK; }
+    };
+
+
+    class HostAIScrSrv : public HostService<IAIScrSrv>
+    {
+    public:
+        HostAIScrSrv(HostScriptMan& manager) : HostService<IAIScrSrv>(manager)
+            { /* fnord */ }
+
+        STDMETHOD_(eAIScriptAlertLevel,GetAlertLevel)(object obj_id)
+        {
+            const cMultiParm* level = man.get_property(obj_id, "AI_Alertness", "Level");
+            return level ? static_cast<eAIScriptAlertLevel>(int(*level)) : kNoAlert;
+        }
+    };
+
+
+    class HostEngineSrv : public HostService<IEngineSrv>
+    {
+    public:
+        HostEngineSrv(HostScriptMan& manager) : HostService<IEngineSrv>(manager)
+            { /* fnord */ }
+
+        STDMETHOD_(int,ConfigIsDefined)(const char* name)
+        {
+            bool exists;
+            man.get_config(name, &exists);
+            return exists;
+        }
+
+        STDMETHOD_(int,ConfigGetInt)(const char* name, int& value)
+        {
+            bool exists;
+            value = man.get_config(name, &exists);
+            return exists;
+        }
+    };
+
+
+    class HostObjectSystem : public HostService<IObjectSystem>
+    {
+    public:
+        HostObjectSystem(HostScriptMan& manager) : HostService<IObjectSystem>(manager)
+            { /* fnord */ }
+
+        STDMETHOD_(int,GetObjectNamed)(const char* name)
+            { return man.find_named(name); }
+
+        STDMETHOD_(const char*,GetName)(int obj_id)
+        {
+            HostScriptMan::Object* obj = man.find_object(obj_id);
+            return (obj && !obj -> name.empty()) ? obj -> name.c_str() : NULL;
+        }
+
+        STDMETHOD_(int,Listen)(sObjListenerDesc* desc)
+            { return man.add_listener(desc); }
+
+        STDMETHOD(Unlisten)(int handle)
+            { man.remove_listener(handle); return S_OK; }
+    };
+
+
+    class HostTraitManager : public HostService<ITraitManager>
+    {
+    public:
+        HostTraitManager(HostScriptMan& manager) : HostService<ITraitManager>(manager)
+            { /* fnord */ }
+
+        STDMETHOD_(int,GetArchetype)(int obj_id)
+        {
+            HostScriptMan::Object* obj = man.find_object(obj_id);
+            return obj ? obj -> archetype : 0;
+        }
+
+        STDMETHOD_(IObjectQuery*,Query)(int obj_id, ulong flags)
+        {
+            std::vector<int> matches;
+            if(flags & kTraitQueryChildren)
+                man.list_descendants(matches, obj_id, (flags & kTraitQueryFull) != 0);
+
+            return new HostObjectQuery(matches);
+        }
+    };
+
+
+    template <class I, class S>
+    void register_service(std::vector<std::pair<const IID*, IUnknown*> >& services, HostScriptMan& manager)
+    {
+        services.push_back(std::make_pair(&IID_OF(I), static_cast<IUnknown*>(static_cast<I*>(new S(manager)))));
+    }
+}
+
+
+/* ------------------------------------------------------------------------
+ *  Construction and destruction
+ */
+
+HostScriptMan::HostScriptMan() : now(0), delivered(0), next_archetype(-1), next_object(1), next_link(1), next_timer(1), dispatch_depth(0)
+{
+    register_service<IQuestSrv,     HostQuestSrv>(services, *this);
+    register_service<ILinkSrv,      HostLinkSrv>(services, *this);
+    register_service<ILinkToolsSrv, HostLinkToolsSrv>(services, *this);
+    register_service<ILinkManager,  HostLinkManager>(services, *this);
+    register_service<IObjectSrv,    HostObjectSrv>(services, *this);
+    register_service<IPropertySrv,  HostPropertySrv>(services, *this);
+    register_service<IActReactSrv,  HostActReactSrv>(services, *this);
+    register_service<IPhysSrv,      HostPhysSrv>(services, *this);
+    register_service<ISoundScrSrv,  HostSoundScrSrv>(services, *this);
+    register_service<IPGroupSrv,    HostPGroupSrv>(services, *this);
+    register_service<IAIScrSrv,     HostAIScrSrv>(services, *this);
+    register_service<IEngineSrv,    HostEngineSrv>(services, *this);
+    register_service<IObjectSystem, HostObjectSystem>(services, *this);
+    register_service<ITraitManager, HostTraitManager>(services, *this);
+
+    // Every world has the root archetype
+    add_archetype("Object", 0);
+}
+
+
+HostScriptMan::~HostScriptMan()
+{
+    std::map<int, Object>::iterator it;
+    for(it = objects.begin(); it != objects.end(); ++it) {
+        std::vector<IScript*>::iterator script;
+        for(script = it -> second.scripts.begin(); script != it -> second.scripts.end(); ++script)
+            (*script) -> Release();
+    }
+    release_dead_scripts();
+
+    std::vector<std::pair<const IID*, IUnknown*> >::iterator srv;
+    for(srv = services.begin(); srv != services.end(); ++srv)
+        delete srv -> second;
+
+    // Module statics may try to talk to the manager when they are destroyed
+    if(g_pScriptManager == this) g_pScriptManager = NULL;
+}
+
+
+/* ------------------------------------------------------------------------
+ *  IScriptMan
+ */
+
+STDMETHODIMP HostScriptMan::QueryInterface(REFIID riid, void** iface)
+{
+    if(&riid == &IID_OF(IScriptMan) || &riid == &IID_OF(IUnknown)) {
+        *iface = static_cast<IScriptMan*>(this);
+        AddRef();
+        return S_OK;
+    }
+
+    *iface = GetService(riid);
+    return *iface ? S_OK : E_NOINTERFACE;
+}
+
+
+STDMETHODIMP_(IUnknown*) HostScriptMan::GetService(REFIID riid)
+{
+    std::vector<std::pair<const IID*, IUnknown*> >::iterator srv;
+    for(srv = services.begin(); srv != services.end(); ++srv) {
+        if(srv -> first == &riid) {
+            srv -> second -> AddRef();
+            return srv -> second;
+        }
+    }
+
+    return NULL;
+}
+
+
+STDMETHODIMP_(cMultiParm*) HostScriptMan::SendMessage2(cMultiParm& reply, object from, object to, const char* message, const cMultiParm& data, const cMultiParm& data2, const cMultiParm& data3)
+{
+    sScrMsg msg;
+    msg.from    = from;
+    msg.to      = to;
+    msg.message = message;
+    msg.time    = now;
+    msg.data    = data;
+    msg.data2   = data2;
+    msg.data3   = data3;
+
+    deliver(&msg, &reply);
+    return &reply;
+}
+
+
+STDMETHODIMP_(void) HostScriptMan::PostMessage2(object from, object to, const char* message, const cMultiParm& data, const cMultiParm& data2, const cMultiParm& data3, ulong)
+{
+    posted.push_back(Posted());
+
+    Posted& post = posted.back();
+    post.from    = from;
+    post.to      = to;
+    post.message = message;
+    post.data    = data;
+    post.data2   = data2;
+    post.data3   = data3;
+}
+
+
+STDMETHODIMP_(tScrTimer) HostScriptMan::SetTimedMessage2(object to, const char* message, ulong time, eScrTimedMsgKind kind, const cMultiParm& data)
+{
+    Timer& timer = timers[next_timer];
+    timer.id      = next_timer++;
+    timer.dest    = to;
+    timer.message = message;
+    timer.kind    = kind;
+    timer.period  = time ? time : 1;
+    timer.data    = data;
+
+    schedule.insert(std::make_pair(now + timer.period, timer.id));
+
+    return timer.id;
+}
+
+
+STDMETHODIMP_(void) HostScriptMan::KillTimedMessage(tScrTimer timer)
+{
+    // The schedule entry is left in place, and skipped when it falls due.
+    timers.erase(timer);
+}
+
+
+STDMETHODIMP_(int) HostScriptMan::IsScriptDataSet(const sScrDatumTag* tag)
+{
+    return script_data.count(DatumKey(tag -> objId, std::make_pair(std::string(tag -> pszClass), std::string(tag -> pszName)))) != 0;
+}
+
+
+STDMETHODIMP HostScriptMan::GetScriptData(const sScrDatumTag* tag, sMultiParm* data)
+{
+    std::map<DatumKey, cMultiParm>::const_iterator it = script_data.find(DatumKey(tag -> objId, std::make_pair(std::string(tag -> pszClass), std::string(tag -> pszName))));
+    if(it == script_data.end()) {
+        data -> type = kMT_Undef;
+        data -> i    = 0;
+        return S_FALSE;
+    }
+
+    export_parm(data, it -> second);
+    return S_OK;
+}
+
+
+STDMETHODIMP HostScriptMan::SetScriptData(const sScrDatumTag* tag, const sMultiParm* data)
+{
+    script_data[DatumKey(tag -> objId, std::make_pair(std::string(tag -> pszClass), std::string(tag -> pszName)))] = *data;
+    return S_OK;
+}
+
+
+STDMETHODIMP HostScriptMan::ClearScriptData(const sScrDatumTag* tag, sMultiParm* data)
+{
+    std::map<DatumKey, cMultiParm>::iterator it = script_data.find(DatumKey(tag -> objId, std::make_pair(std::string(tag -> pszClass), std::string(tag -> pszName))));
+    if(it == script_data.end()) {
+        data -> type = kMT_Undef;
+        data -> i    = 0;
+        return S_FALSE;
+    }
+
+    export_parm(data, it -> second);
+    script_data.erase(it);
+    return S_OK;
+}
+
+
+/* ------------------------------------------------------------------------
+ *  World construction
+ */
+
+int HostScriptMan::add_archetype(const char* name, int parent)
+{
+    int id = next_archetype--;
+
+    Object& obj = objects[id];
+    obj.id        = id;
+    obj.archetype = parent;
+    obj.name      = name;
+    obj.rendered  = false;
+    names[obj.name] = id;
+
+    return id;
+}
+
+
+int HostScriptMan::add_object(const char* name, int archetype, const cScrVec& position)
+{
+    int id = next_object++;
+
+    Object& obj = objects[id];
+    obj.id        = id;
+    obj.archetype = archetype;
+    obj.position  = position;
+    obj.rendered  = false;
+
+    if(name) {
+        obj.name = name;
+        names[obj.name] = id;
+    }
+
+    notify_listeners(id, kObjNotifyCreate);
+
+    return id;
+}
+
+
+void HostScriptMan::destroy_object(int obj_id)
+{
+    if(!find_object(obj_id)) return;
+
+    notify_listeners(obj_id, kObjNotifyDelete);
+
+    // As in the game, the object's scripts are ended before it goes away
+    sScrMsg end;
+    end.to      = obj_id;
+    end.message = "EndScript";
+    end.time    = now;
+    deliver(&end);
+
+    // The scripts may have destroyed the object themselves
+    std::map<int, Object>::iterator it = objects.find(obj_id);
+    if(it == objects.end()) return;
+
+    // Scripts may be destroying their own object, so they can't be released yet
+    dead_scripts.insert(dead_scripts.end(), it -> second.scripts.begin(), it -> second.scripts.end());
+
+    if(!it -> second.name.empty()) names.erase(it -> second.name);
+
+    std::vector<long> matches;
+    find_links(matches, 0, obj_id, 0);
+    find_links(matches, 0, 0, obj_id);
+
+    std::vector<long>::iterator link;
+    for(link = matches.begin(); link != matches.end(); ++link)
+        remove_link(*link);
+
+    objects.erase(it);
+
+    if(!dispatch_depth) release_dead_scripts();
+}
+
+
+void HostScriptMan::set_design_note(int obj_id, const char* note)
+{
+    set_property(obj_id, "DesignNote", NULL, note);
+}
+
+
+void HostScriptMan::set_property(int obj_id, const char* prop, const char* field, const cMultiParm& value)
+{
+    Object* obj = find_object(obj_id);
+    if(obj) obj -> props[prop_key(prop, field)] = value;
+}
+
+
+long HostScriptMan::add_flavour(const char* name, uint data_size)
+{
+    long& id = flavours[name];
+    if(!id) id = static_cast<long>(flavours.size());
+
+    if(data_size) flavour_sizes[id] = data_size;
+
+    return id;
+}
+
+
+long HostScriptMan::add_link(const char* flavour, int source, int dest, const void* data, uint size)
+{
+    Link& link = links[next_link];
+    link.id      = next_link++;
+    link.flavour = flavour ? add_flavour(flavour) : 0;
+    link.source  = source;
+    link.dest    = dest;
+
+    if(data && size) {
+        const char* bytes = static_cast<const char*>(data);
+        link.data.assign(bytes, bytes + size);
+    }
+
+    return link.id;
+}
+
+
+void HostScriptMan::add_script(int obj_id, IScript* script)
+{
+    Object* obj = find_object(obj_id);
+    if(obj) {
+        obj -> scripts.push_back(script);
+    } else {
+        script -> Release();
+    }
+}
+
+
+/* ------------------------------------------------------------------------
+ *  Message pumping
+ */
+
+int HostScriptMan::deliver(sScrMsg* msg, sMultiParm* reply)
+{
+    Object* obj = find_object(msg -> to);
+    if(!obj || obj -> scripts.empty()) return 0;
+
+    cMultiParm fallback;
+    if(!reply) reply = &fallback;
+
+    ++dispatch_depth;
+
+    // Copy the script list, as scripts may destroy their own object
+    std::vector<IScript*> scripts(obj -> scripts);
+    std::vector<IScript*>::iterator it;
+    for(it = scripts.begin(); it != scripts.end(); ++it) {
+        (*it) -> ReceiveMessage(msg, reply, kNoAction);
+        ++delivered;
+    }
+
+    if(!--dispatch_depth) release_dead_scripts();
+
+    return static_cast<int>(scripts.size());
+}
+
+
+void HostScriptMan::send(int from, int to, const char* message, const cMultiParm& data)
+{
+    cMultiParm reply;
+    SendMessage2(reply, from, to, message, data, cMultiParm::Undef, cMultiParm::Undef);
+}
+
+
+void HostScriptMan::start_sim()
+{
+    std::vector<int> targets;
+
+    std::map<int, Object>::iterator it;
+    for(it = objects.begin(); it != objects.end(); ++it) {
+        if(!it -> second.scripts.empty()) targets.push_back(it -> first);
+    }
+
+    std::vector<int>::iterator target;
+    for(target = targets.begin(); target != targets.end(); ++target) {
+        sScrMsg begin;
+        begin.to      = *target;
+        begin.message = "BeginScript";
+        begin.time    = now;
+        deliver(&begin);
+
+        sSimMsg sim;
+        sim.to        = *target;
+        sim.time      = now;
+        sim.fStarting = true;
+        deliver(&sim);
+    }
+}
+
+
+void HostScriptMan::run_until(ulong time)
+{
+    for(;;) {
+        // Posted messages are delivered before anything else happens
+        while(!posted.empty()) {
+            Posted post = posted.front();
+            posted.pop_front();
+
+            sScrMsg msg;
+            msg.from    = post.from;
+            msg.to      = post.to;
+            msg.message = post.message.c_str();
+            msg.time    = now;
+            msg.data    = post.data;
+            msg.data2   = post.data2;
+            msg.data3   = post.data3;
+            deliver(&msg);
+        }
+
+        if(schedule.empty() || schedule.begin() -> first > time) break;
+
+        std::multimap<ulong, int>::iterator next = schedule.begin();
+        now = next -> first;
+        int timer_id = next -> second;
+        schedule.erase(next);
+
+        fire_timer(timer_id);
+    }
+
+    now = time;
+}
+
+
+void HostScriptMan::fire_timer(int timer_id)
+{
+    std::map<int, Timer>::iterator it = timers.find(timer_id);
+    if(it == timers.end()) return; // killed
+
+    // Take a copy, as the handler may kill or replace the timer
+    Timer timer = it -> second;
+    if(timer.kind == kSTM_Periodic) {
+        schedule.insert(std::make_pair(now + timer.period, timer.id));
+    } else {
+        timers.erase(it);
+    }
+
+    sScrTimerMsg msg;
+    msg.to   = timer.dest;
+    msg.time = now;
+    msg.name = timer.message.c_str();
+    msg.data = timer.data;
+    deliver(&msg);
+}
+
+
+void HostScriptMan::release_dead_scripts()
+{
+    std::vector<IScript*> dead;
+    dead.swap(dead_scripts);
+
+    std::vector<IScript*>::iterator it;
+    for(it = dead.begin(); it != dead.end(); ++it)
+        (*it) -> Release();
+}
+
+
+/* ------------------------------------------------------------------------
+ *  World state
+ */
+
+HostScriptMan::Object* HostScriptMan::find_object(int obj_id)
+{
+    std::map<int, Object>::iterator it = objects.find(obj_id);
+
+    return (it != objects.end()) ? &it -> second : NULL;
+}
+
+
+int HostScriptMan::find_named(const char* name)
+{
+    if(!name) return 0;
+
+    NameMap::const_iterator it = names.find(name);
+
+    return (it != names.end()) ? it -> second : 0;
+}
+
+
+bool HostScriptMan::inherits_from(int obj_id, int archetype)
+{
+    for(int current = obj_id; current; ) {
+        if(current == archetype) return true;
+
+        Object* obj = find_object(current);
+        current = obj ? obj -> archetype : 0;
+    }
+
+    return false;
+}
+
+
+const cMultiParm* HostScriptMan::get_property(int obj_id, const char* prop, const char* field)
+{
+    std::string key = prop_key(prop, field);
+
+    // Properties are inherited from archetypes
+    for(int current = obj_id; current; ) {
+        Object* obj = find_object(current);
+        if(!obj) break;
+
+        std::map<std::string, cMultiParm, HostNameLess>::const_iterator it = obj -> props.find(key);
+        if(it != obj -> props.end()) return &it -> second;
+
+        current = obj -> archetype;
+    }
+
+    return NULL;
+}
+
+
+long HostScriptMan::find_flavour(const char* name)
+{
+    if(!name) return 0;
+
+    // Reverse flavours are indicated by a leading ~
+    bool reverse = (*name == '~');
+    std::map<std::string, long, HostNameLess>::const_iterator it = flavours.find(reverse ? name + 1 : name);
+
+    if(it == flavours.end()) return 0;
+
+    return reverse ? -(it -> second) : it -> second;
+}
+
+
+uint HostScriptMan::flavour_data_size(long flavour)
+{
+    std::map<long, uint>::const_iterator it = flavour_sizes.find(flavour < 0 ? -flavour : flavour);
+
+    return (it != flavour_sizes.end()) ? it -> second : 0;
+}
+
+
+HostScriptMan::Link* HostScriptMan::find_link(long link_id)
+{
+    std::map<long, Link>::iterator it = links.find(link_id);
+
+    return (it != links.end()) ? &it -> second : NULL;
+}
+
+
+void HostScriptMan::find_links(std::vector<long>& matches, long flavour, int source, int dest)
+{
+    // Reverse flavours swap the source and destination
+    bool reverse = (flavour < 0);
+    if(reverse) {
+        flavour = -flavour;
+        std::swap(source, dest);
+    }
+
+    std::map<long, Link>::const_iterator it;
+    for(it = links.begin(); it != links.end(); ++it) {
+        const Link& link = it -> second;
+
+        if((!flavour || link.flavour == flavour) &&
+           (!source  || link.source  == source) &&
+           (!dest    || link.dest    == dest)) {
+            matches.push_back(link.id);
+        }
+    }
+}
+
+
+ILinkQuery* HostScriptMan::query_links(std::vector<long>& matches)
+{
+    return new HostLinkQuery(*this, matches);
+}
+
+
+void HostScriptMan::remove_link(long link_id)
+{
+    links.erase(link_id);
+}
+
+
+void HostScriptMan::list_descendants(std::vector<int>& matches, int archetype, bool full)
+{
+    std::map<int, Object>::const_iterator it;
+    for(it = objects.begin(); it != objects.end(); ++it) {
+        if(it -> second.archetype == archetype) {
+            matches.push_back(it -> first);
+
+            if(full && it -> first < 0)
+                list_descendants(matches, it -> first, full);
+        }
+    }
+}
+
+
+int HostScriptMan::get_qvar(const char* name, bool* exists)
+{
+    std::map<std::string, int, HostNameLess>::const_iterator it = qvars.find(name);
+    bool found = (it != qvars.end());
+
+    if(exists) *exists = found;
+
+    return found ? it -> second : 0;
+}
+
+
+void HostScriptMan::set_qvar(const char* name, int value)
+{
+    bool exists;
+    int old_value = get_qvar(name, &exists);
+
+    qvars[name] = value;
+
+    if(exists && old_value == value) return;
+
+    // Notify subscribers of the change. Take a copy of the subscriber list,
+    // as handlers may subscribe or unsubscribe during the notification
+    std::vector<int> targets;
+    std::pair<SubscriberMap::iterator, SubscriberMap::iterator> range = subscribers.equal_range(name);
+    for(SubscriberMap::iterator it = range.first; it != range.second; ++it)
+        targets.push_back(it -> second);
+
+    std::vector<int>::iterator target;
+    for(target = targets.begin(); target != targets.end(); ++target) {
+        sQuestMsg msg;
+        msg.to         = *target;
+        msg.time       = now;
+        msg.m_pName    = name;
+        msg.m_oldValue = old_value;
+        msg.m_newValue = value;
+        deliver(&msg);
+    }
+}
+
+
+void HostScriptMan::delete_qvar(const char* name)
+{
+    qvars.erase(name);
+}
+
+
+int HostScriptMan::get_config(const char* name, bool* exists)
+{
+    std::map<std::string, int, HostNameLess>::const_iterator it = config.find(name);
+    bool found = (it != config.end());
+
+    if(exists) *exists = found;
+
+    return found ? it -> second : 0;
+}
+
+
+void HostScriptMan::set_config(const char* name, int value)
+{
+    config[name] = value;
+}
+
+
+void HostScriptMan::subscribe_qvar(int obj_id, const char* name)
+{
+    subscribers.insert(std::make_pair(std::string(name), obj_id));
+}
+
+
+void HostScriptMan::unsubscribe_qvar(int obj_id, const char* name)
+{
+    std::pair<SubscriberMap::iterator, SubscriberMap::iterator> range = subscribers.equal_range(name);
+    for(SubscriberMap::iterator it = range.first; it != range.second; ++it) {
+        if(it -> second == obj_id) {
+            subscribers.erase(it);
+            return;
+        }
+    }
+}
+
+
+int HostScriptMan::add_listener(const sObjListenerDesc* desc)
+{
+    listeners.push_back(*desc);
+
+    return listeners.size();
+}
+
+
+void HostScriptMan::remove_listener(int handle)
+{
+    // Handles stay valid, so removed listeners are just cleared
+    if(handle > 0 && size_t(handle) <= listeners.size())
+        listeners[handle - 1].pfnListener = NULL;
+}
+
+
+void HostScriptMan::notify_listeners(int obj_id, eObjNotifyMsg msg)
+{
+    for(size_t i = 0; i < listeners.size(); ++i) {
+        if(listeners[i].pfnListener)
+            listeners[i].pfnListener(obj_id, msg, listeners[i].pData);
+    }
+}
+
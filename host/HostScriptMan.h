@@ -0,0 +1,297 @@
+/** @file
+ * This file contains the interface for the host build script manager, an
+ * in-process stand-in for the game's script manager and script services.
+ * It holds a tiny model of the game world - objects, archetypes, properties,
+ * links, quest variables, script data, timers and posted messages - so that
+ * scripts can be driven natively for profiling and benchmarking.
+ *
+ * @author Chris Page &lt;chris@starforge.co.uk&gt;
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef HOSTSCRIPTMAN_H
+#define HOSTSCRIPTMAN_H
+
+#include <lg/config.h>
+#include <lg/objstd.h>
+#include <lg/interfaceimp.h>
+#include <lg/scrmanagers.h>
+#include <lg/scrservices.h>
+#include <lg/objects.h>
+#include <lg/links.h>
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <strings.h>
+
+/** Case-insensitive ordering for names, as the game treats object, property,
+ *  link flavour and quest variable names case-insensitively.
+ */
+struct HostNameLess
+{
+    bool operator()(const std::string& left, const std::string& right) const
+        { return strcasecmp(left.c_str(), right.c_str()) < 0; }
+};
+
+
+/** The host build script manager. A single instance of this class is
+ *  created by the host driver and installed as g_pScriptManager. All of
+ *  the script services used by the module are provided by helper objects
+ *  owned by the manager, and fetched via GetService().
+ */
+class HostScriptMan : public cInterfaceImp<IScriptMan, IID_Def<IScriptMan>, kInterfaceImpStatic>
+{
+public:
+    HostScriptMan();
+    virtual ~HostScriptMan();
+
+    /* ------------------------------------------------------------------------
+     *  IScriptMan
+     */
+    STDMETHOD(QueryInterface)(REFIID riid, void** iface);
+    STDMETHOD_(IUnknown*,GetService)(REFIID riid);
+
+    STDMETHOD_(cMultiParm*,SendMessage2)(cMultiParm& reply, object from, object to, const char* message, const cMultiParm& data, const cMultiParm& data2, const cMultiParm& data3);
+    STDMETHOD_(void,PostMessage2)(object from, object to, const char* message, const cMultiParm& data, const cMultiParm& data2, const cMultiParm& data3, ulong flags);
+    STDMETHOD_(tScrTimer,SetTimedMessage2)(object to, const char* message, ulong time, eScrTimedMsgKind kind, const cMultiParm& data);
+    STDMETHOD_(void,KillTimedMessage)(tScrTimer timer);
+
+    STDMETHOD_(int,IsScriptDataSet)(const sScrDatumTag* tag);
+    STDMETHOD(GetScriptData)(const sScrDatumTag* tag, sMultiParm* data);
+    STDMETHOD(SetScriptData)(const sScrDatumTag* tag, const sMultiParm* data);
+    STDMETHOD(ClearScriptData)(const sScrDatumTag* tag, sMultiParm* data);
+
+
+    /* ------------------------------------------------------------------------
+     *  World construction, used by the host driver
+     */
+
+    /** Create a new archetype.
+     *
+     * @param name   The name of the archetype.
+     * @param parent The ID of the parent archetype, defaults to the root "Object".
+     * @return The (negative) ID of the new archetype.
+     */
+    int add_archetype(const char* name, int parent = -1);
+
+
+    /** Create a new concrete object.
+     *
+     * @param name      The name of the object, may be NULL for unnamed objects.
+     * @param archetype The archetype the object inherits from.
+     * @param position  The location of the object in the world.
+     * @return The ID of the new object.
+     */
+    int add_object(const char* name, int archetype, const cScrVec& position = cScrVec::Zero);
+
+
+    /** Remove an object from the world. Scripts on the object are released
+     *  once the current message has been fully processed.
+     *
+     * @param obj_id The ID of the object to destroy.
+     */
+    void destroy_object(int obj_id);
+
+
+    /** Set the Editor -> Design Note on the specified object.
+     */
+    void set_design_note(int obj_id, const char* note);
+
+
+    /** Set a property field on the specified object. A NULL or empty field name
+     *  sets a simple property.
+     */
+    void set_property(int obj_id, const char* prop, const char* field, const cMultiParm& value);
+
+
+    /** Register a link flavour, optionally with the size of the data stored
+     *  on links of that flavour. Flavours are registered automatically by
+     *  add_link(), so this only needs to be called to set the data size.
+     *
+     * @return The flavour ID.
+     */
+    long add_flavour(const char* name, uint data_size = 0);
+
+
+    /** Create a link between two objects.
+     *
+     * @param flavour The name of the link flavour.
+     * @param source  The object the link is from.
+     * @param dest    The object the link is to.
+     * @param data    A pointer to data to copy into the link, or NULL.
+     * @param size    The size of the data to copy, in bytes.
+     * @return The ID of the new link.
+     */
+    long add_link(const char* flavour, int source, int dest, const void* data = NULL, uint size = 0);
+
+
+    /** Attach a script to an object. The manager takes ownership of the
+     *  script's reference.
+     */
+    void add_script(int obj_id, IScript* script);
+
+
+    /** Set a game config variable, as if it had been set in cam.cfg or
+     *  one of the other config files.
+     */
+    void set_config(const char* name, int value = 1);
+
+
+    /* ------------------------------------------------------------------------
+     *  Message pumping, used by the host driver
+     */
+
+    /** Deliver the message to all scripts on msg -> to immediately.
+     *
+     * @return The number of scripts that received the message.
+     */
+    int deliver(sScrMsg* msg, sMultiParm* reply = NULL);
+
+
+    /** Send a plain message to an object immediately.
+     */
+    void send(int from, int to, const char* message, const cMultiParm& data = cMultiParm::Undef);
+
+
+    /** Send Sim start messages to every object with scripts.
+     */
+    void start_sim();
+
+
+    /** Advance the sim clock to the specified time, delivering posted
+     *  messages and firing any timers that fall due along the way.
+     *
+     * @param time The sim time to advance to, in milliseconds.
+     */
+    void run_until(ulong time);
+
+
+    /** Obtain the current sim time in milliseconds.
+     */
+    ulong sim_time() const
+        { return now; }
+
+
+    /** Obtain the number of messages delivered to scripts so far.
+     */
+    ulong message_count() const
+        { return delivered; }
+
+
+    /* ------------------------------------------------------------------------
+     *  World state, used by the service implementations
+     */
+
+    struct Object {
+        int                     id;
+        int                     archetype;
+        std::string             name;
+        cScrVec                 position;
+        cScrVec                 facing;
+        bool                    rendered;
+        std::set<int>           metaprops;
+        std::vector<IScript*>   scripts;
+        std::map<std::string, cMultiParm, HostNameLess> props;
+    };
+
+    struct Link {
+        long                    id;
+        long                    flavour;
+        int                     source;
+        int                     dest;
+        std::vector<char>       data;
+        std::map<std::string, cMultiParm, HostNameLess> fields;
+    };
+
+    Object*     find_object(int obj_id);
+    int         find_named(const char* name);
+    bool        inherits_from(int obj_id, int archetype);
+    const cMultiParm* get_property(int obj_id, const char* prop, const char* field);
+
+    long        find_flavour(const char* name);
+    uint        flavour_data_size(long flavour);
+    Link*       find_link(long link_id);
+    void        find_links(std::vector<long>& matches, long flavour, int source, int dest);
+    ILinkQuery* query_links(std::vector<long>& matches);
+    void        remove_link(long link_id);
+    void        list_descendants(std::vector<int>& matches, int archetype, bool full);
+
+    int         get_qvar(const char* name, bool* exists = NULL);
+    void        set_qvar(const char* name, int value);
+    void        delete_qvar(const char* name);
+    void        subscribe_qvar(int obj_id, const char* name);
+    void        unsubscribe_qvar(int obj_id, const char* name);
+
+    int         get_config(const char* name, bool* exists = NULL);
+
+    int         add_listener(const sObjListenerDesc* desc);
+    void        remove_listener(int handle);
+
+private:
+    struct Timer {
+        int              id;
+        int              dest;
+        std::string      message;
+        eScrTimedMsgKind kind;
+        ulong            period;
+        cMultiParm       data;
+    };
+
+    struct Posted {
+        int         from;
+        int         to;
+        std::string message;
+        cMultiParm  data;
+        cMultiParm  data2;
+        cMultiParm  data3;
+    };
+
+    typedef std::map<std::string, int, HostNameLess> NameMap;
+    typedef std::multimap<std::string, int, HostNameLess> SubscriberMap;
+    typedef std::pair<int, std::pair<std::string, std::string> > DatumKey;
+
+    void fire_timer(int timer_id);
+    void release_dead_scripts();
+    void notify_listeners(int obj_id, eObjNotifyMsg msg);
+
+    ulong now;                              //!< The current sim time
+    ulong delivered;                        //!< How many messages have been delivered
+    int   next_archetype;                   //!< The next archetype ID to hand out
+    int   next_object;                      //!< The next concrete object ID to hand out
+    long  next_link;                        //!< The next link ID to hand out
+    int   next_timer;                       //!< The next timer handle to hand out
+    int   dispatch_depth;                   //!< How deeply nested message delivery currently is
+
+    std::map<int, Object>                   objects;
+    NameMap                                 names;
+    std::map<long, Link>                    links;
+    std::map<std::string, long, HostNameLess> flavours;
+    std::map<long, uint>                    flavour_sizes;
+    std::map<std::string, int, HostNameLess> qvars;
+    std::map<std::string, int, HostNameLess> config;
+    SubscriberMap                           subscribers;
+    std::map<DatumKey, cMultiParm>          script_data;
+    std::map<int, Timer>                    timers;
+    std::multimap<ulong, int>               schedule;
+    std::deque<Posted>                      posted;
+    std::vector<IScript*>                   dead_scripts;
+    std::vector<sObjListenerDesc>           listeners;
+
+    std::vector<std::pair<const IID*, IUnknown*> > services;
+};
+
+#endif // HOSTSCRIPTMAN_H
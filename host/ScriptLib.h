@@ -0,0 +1,62 @@
+/** @file
+ * Host build stand-in for the subset of Telliamed's ScriptLib used by the
+ * script module. The implementations live in HostScriptLib.cpp, and operate
+ * on the in-process world provided by HostScriptMan.
+ *
+ * @author Chris Page &lt;chris@starforge.co.uk&gt;
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef HOST_SCRIPTLIB_H
+#define HOST_SCRIPTLIB_H
+
+#include <lg/types.h>
+#include <lg/links.h>
+#include <lg/script.h>
+#include <lg/scrservices.h>
+
+extern IScriptMan* g_pScriptManager;
+extern IMalloc*    g_pMalloc;
+
+typedef int (__cdecl *LinkIterCallbackFunc)(ILinkSrv*, ILinkQuery*, IScript*, void*);
+
+/** Fetch the design note for the specified object. The returned string is
+ *  allocated via g_pMalloc, and must be freed by the caller.
+ */
+char* GetObjectParams(int iObj);
+
+/** Locate the named parameter in the design note string. The returned string
+ *  is allocated via g_pMalloc and must be freed by the caller. If the parameter
+ *  is not found, a copy of the default is returned, or NULL if no default is set.
+ */
+char* GetParamString(const char* pszString, const char* pszParam, const char* pszDefault = NULL);
+
+int  GetObjectParamInt(int iObj, const char* pszParam, int iDefault = 0);
+void SetObjectParamInt(int iObj, const char* pszParam, int iVal);
+
+/** Convert a string containing an object name or number to an object ID.
+ */
+int StrToObject(const char* pszName);
+
+void FixupPlayerLinks(int iSource, int iPlayer);
+
+long IterateLinks(const char* pszLinkType, int iSource, int iDest,
+                  LinkIterCallbackFunc pfnLinkIterCallback, IScript* pScript, void* pData);
+
+long IterateLinksByData(const char* pszLinkType, int iSource, int iDest,
+                        const void* pvFilter, int iFilterLen,
+                        LinkIterCallbackFunc pfnLinkIterCallback, IScript* pScript, void* pData);
+
+#endif // HOST_SCRIPTLIB_H
@@ -0,0 +1,292 @@
+/** @file
+ * This file contains the host build driver. It builds a small mission in
+ * HostScriptMan, attaches the TW scripts to it, and then drives the sim
+ * for a fixed number of ticks so that message handling can be timed, or
+ * profiled with perf.
+ *
+ * @author Chris Page &lt;chris@starforge.co.uk&gt;
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "ScriptLib.h"
+#include "HostModule.h"
+#include "HostScriptMan.h"
+
+#include "TWBaseTrap.h"
+#include "TWTrapSetSpeed.h"
+#include "TWTrapPhysStateCtrl.h"
+#include "TWTrapAIEcology.h"
+#include "TWTriggerAIAware.h"
+#include "TWTriggerVisible.h"
+
+namespace {
+
+    const ulong TICK_LENGTH = 50; //!< How many milliseconds of sim time pass per tick
+
+    /** The objects in the test mission the driver needs to poke at directly.
+     */
+    struct Mission {
+        int player;
+        int speed_trap;
+        int phys_trap;
+        int ecology;
+        int guard_arch;
+        std::vector<int> guards;
+        std::vector<long> awareness;
+    };
+
+
+    /** Create a script of the specified type and attach it to the object.
+     */
+    template <class T>
+    void attach(HostScriptMan& manager, int obj_id, const char* name)
+    {
+        manager.add_script(obj_id, new T(name, obj_id));
+    }
+
+
+    /** Build the test mission: a set of guards watching the player, a moving
+     *  terrain path controlled by a qvar, some physics controlled crates, and
+     *  an AI ecology spawning more guards.
+     */
+    void build_mission(HostScriptMan& manager, Mission& mission, int guard_count)
+    {
+        int marker  = manager.add_archetype("Marker");
+        int terrpt  = manager.add_archetype("TerrPt");
+        int moving  = manager.add_archetype("MovingTerrain");
+        int crate   = manager.add_archetype("Crate");
+        int ai      = manager.add_archetype("AI");
+        int human   = manager.add_archetype("Human", ai);
+        mission.guard_arch = manager.add_archetype("Guard", human);
+        int archer  = manager.add_archetype("Archer", human);
+
+        // AIs, crates, and moving terrain have physics (the PhysType value is not used)
+        manager.set_property(ai, "PhysType", "Type", cMultiParm(3));
+        manager.set_property(crate, "PhysType", "Type", cMultiParm(0));
+        manager.set_property(moving, "PhysType", "Type", cMultiParm(0));
+
+        manager.add_flavour("AIAwareness", sizeof(sAIAwareness));
+        manager.add_flavour("ScriptParams", 16);
+
+        mission.player = manager.add_object("Player", manager.add_archetype("Avatar"), cScrVec(0, 0, 0));
+
+        // Relay that all the triggers fire at
+        int relay = manager.add_object("Relay", marker);
+        manager.set_design_note(relay, "TWBaseTrapCount=0");
+        attach<TWBaseTrap>(manager, relay, "TWBaseTrap");
+
+        // Guards with awareness and visibility triggers
+        for(int i = 0; i < guard_count; ++i) {
+            char name[32];
+            snprintf(name, sizeof(name), "Guard %d", i + 1);
+
+            int guard = manager.add_object(name, mission.guard_arch, cScrVec(float(i % 16) * 10.0f, float(i / 16) * 10.0f, 0));
+            manager.set_design_note(guard, "TWTriggerAIAwareObject=Player;TWTriggerAIAwareAlertness=2;TWTriggerAIAwareRate=250;"
+                                           "TWTriggerVisibleLow=30;TWTriggerVisibleHigh=60;TWTriggerVisibleRate=250;TDest=[me]");
+            manager.set_property(guard, "AI_Visibility", "Light rating", cMultiParm(i * 7 % 100));
+            manager.add_link("ControlDevice", guard, relay);
+
+            sAIAwareness awareness = sAIAwareness();
+            awareness.Object = mission.player;
+            awareness.Level  = kAIAL_Lowest;
+            mission.awareness.push_back(manager.add_link("AIAwareness", guard, mission.player, &awareness, sizeof(awareness)));
+
+            attach<TWTriggerAIAware>(manager, guard, "TWTriggerAIAware");
+            attach<TWTriggerVisible>(manager, guard, "TWTriggerVisible");
+            mission.guards.push_back(guard);
+        }
+
+        // Moving terrain path, with speed controlled by a qvar
+        int previous = 0;
+        for(int i = 0; i < 8; ++i) {
+            char name[32];
+            snprintf(name, sizeof(name), "TerrPt %d", i + 1);
+
+            int point = manager.add_object(name, terrpt, cScrVec(float(i) * 5.0f, 0, 10));
+            if(previous) manager.add_link("TPath", previous, point);
+            previous = point;
+        }
+        int elevator = manager.add_object("Elevator", moving);
+
+        mission.speed_trap = manager.add_object("SpeedTrap", marker);
+        manager.set_design_note(mission.speed_trap, "TWTrapSetSpeedSpeed=$speedvar * 2;TWTrapSetSpeedWatchQVar=true;"
+                                                    "TWTrapSetSpeedImmediate=true;TWTrapSetSpeedDest=@TerrPt");
+        manager.add_link("ScriptParams", mission.speed_trap, elevator, "SetSpeed", 9);
+        manager.set_qvar("speedvar", 1);
+        attach<TWTrapSetSpeed>(manager, mission.speed_trap, "TWTrapSetSpeed");
+
+        // Physics controlled crates
+        mission.phys_trap = manager.add_object("PhysTrap", marker);
+        manager.set_design_note(mission.phys_trap, "TWTrapPhysStateCtrlLocation=10, 20, 30;TWTrapPhysStateCtrlFacing=0,0,90;"
+                                                   "TWTrapPhysStateCtrlVelocity='0, 0, 2.5'");
+        for(int i = 0; i < 4; ++i) {
+            int box = manager.add_object(NULL, crate, cScrVec(float(i), 0, 0));
+            manager.add_link("ControlDevice", mission.phys_trap, box);
+        }
+        attach<TWTrapPhysStateCtrl>(manager, mission.phys_trap, "TWTrapPhysStateCtrl");
+
+        // An ecology spawning guards and archers at a few spawn points
+        mission.ecology = manager.add_object("Ecology", marker);
+        manager.set_design_note(mission.ecology, "TWTrapAIEcologyRate=500;TWTrapAIEcologyPopulation=6;TWTrapAIEcologyStartOn=true;"
+                                                 "TWTrapAIEcologyVisibleSpawn=yes;TWTrapAIEcologyPopulationQVar=ecopop;"
+                                                 "TWTrapAIEcologySpawnCountQVar=ecospawned");
+        manager.add_link("ScriptParams", mission.ecology, mission.guard_arch, "3", 2);
+        manager.add_link("ScriptParams", mission.ecology, archer, "1", 2);
+        for(int i = 0; i < 4; ++i) {
+            int point = manager.add_object(NULL, marker, cScrVec(100.0f, float(i) * 20.0f, 0));
+            manager.add_link("ScriptParams", mission.ecology, point, "1", 2);
+        }
+        attach<TWTrapAIEcology>(manager, mission.ecology, "TWTrapAIEcology");
+    }
+
+
+    /** Send an alertness change to the specified AI.
+     */
+    void send_alertness(HostScriptMan& manager, int ai, int level, int old_level)
+    {
+        sAIAlertnessMsg msg;
+        msg.to       = ai;
+        msg.message  = "Alertness";
+        msg.time     = manager.sim_time();
+        msg.level    = eAIScriptAlertLevel(level);
+        msg.oldLevel = eAIScriptAlertLevel(old_level);
+        manager.deliver(&msg);
+    }
+
+
+    /** Remove spawned AIs from the world, telling the ecology they have gone,
+     *  as TWTriggerAIEcologyDespawn would if it was on the spawned AI.
+     */
+    void despawn_ais(HostScriptMan& manager, Mission& mission)
+    {
+        std::vector<int> ais;
+        manager.list_descendants(ais, manager.find_named("Human"), true);
+
+        std::vector<int>::iterator it;
+        for(it = ais.begin(); it != ais.end(); ++it) {
+            if(*it > 0 && GetObjectParamInt(*it, "EcologyID", 0) == mission.ecology) {
+                manager.destroy_object(*it);
+                manager.send(*it, mission.ecology, "Despawned");
+            }
+        }
+    }
+
+
+    /** Run one tick of the mission. The driver changes a little of the world
+     *  state each tick - light levels, awareness, qvars - and sends the traps
+     *  their on and off messages, then lets the sim clock advance.
+     */
+    void run_tick(HostScriptMan& manager, Mission& mission, int tick)
+    {
+        size_t count = mission.guards.size();
+
+        // Raise and lower alertness on a rolling subset of the guards
+        int guard = mission.guards[tick % count];
+        send_alertness(manager, guard, (tick / int(count)) % 2 ? 1 : 3, (tick / int(count)) % 2 ? 3 : 1);
+
+        // Update the awareness link on another guard
+        HostScriptMan::Link* link = manager.find_link(mission.awareness[(tick * 7) % count]);
+        if(link) {
+            sAIAwareness* awareness = reinterpret_cast<sAIAwareness*>(&link -> data[0]);
+            awareness -> Level = eAIAwareLevel((tick / 3) % (kAIAL_High + 1));
+        }
+
+        // Let the light on one guard change
+        manager.set_property(mission.guards[(tick * 3) % count], "AI_Visibility", "Light rating", cMultiParm((tick * 13) % 100));
+
+        // Drive the traps
+        manager.set_qvar("speedvar", tick % 10);
+        manager.send(mission.player, mission.speed_trap, (tick % 2) ? "TurnOn" : "TurnOff");
+        if(!(tick % 4)) manager.send(mission.player, mission.phys_trap, "TurnOn");
+
+        if(!(tick % 40)) despawn_ais(manager, mission);
+
+        manager.run_until(manager.sim_time() + TICK_LENGTH);
+    }
+
+
+    void usage(const char* name)
+    {
+        fprintf(stderr, "Usage: %s [-n ticks] [-g guards] [-v]\n", name);
+        fprintf(stderr, "    -n ticks   The number of %lums sim ticks to run (default 20000)\n", TICK_LENGTH);
+        fprintf(stderr, "    -g guards  The number of scripted guards in the mission (default 64)\n");
+        fprintf(stderr, "    -v         Write script monolog output to stderr\n");
+    }
+}
+
+
+int main(int argc, char** argv)
+{
+    int  ticks   = 20000;
+    int  guards  = 64;
+    bool verbose = false;
+
+    for(int arg = 1; arg < argc; ++arg) {
+        if(!strcmp(argv[arg], "-n") && arg + 1 < argc) {
+            ticks = atoi(argv[++arg]);
+        } else if(!strcmp(argv[arg], "-g") && arg + 1 < argc) {
+            guards = atoi(argv[++arg]);
+        } else if(!strcmp(argv[arg], "-v")) {
+            verbose = true;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if(ticks < 1 || guards < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    srand(1);
+
+    HostScriptMan* manager = new HostScriptMan();
+    host_module_init(manager, verbose);
+
+    Mission mission;
+    build_mission(*manager, mission, guards);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    ulong allocs = host_malloc().allocs;
+
+    manager -> start_sim();
+    for(int tick = 0; tick < ticks; ++tick)
+        run_tick(*manager, mission, tick);
+
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double, std::nano>(end - start).count();
+
+    ulong messages = manager -> message_count();
+    allocs = host_malloc().allocs - allocs;
+
+    printf("ticks:          %d (%lums sim time)\n", ticks, manager -> sim_time());
+    printf("scripted AIs:   %d\n", guards);
+    printf("ecology spawns: %d\n", manager -> get_qvar("ecospawned"));
+    printf("messages:       %lu\n", messages);
+    printf("elapsed:        %.3f ms\n", elapsed / 1e6);
+    printf("ns/message:     %.1f\n", messages ? elapsed / messages : 0.0);
+    printf("allocs/message: %.2f\n", messages ? double(allocs) / messages : 0.0);
+
+    delete manager;
+
+    return 0;
+}
@@ -0,0 +1,213 @@
+/** @file
+ * This file contains the trace decoder. It reads a binary trace written by
+ * TraceLog (normally twscript_trace.bin, in the game directory) and prints
+ * the records it contains as text, in the same form they would have been
+ * written to the monolog, prefixed with the sim time of each record.
+ *
+ * @author Chris Page &lt;chris@starforge.co.uk&gt;
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#include <stdint.h>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "ScriptLib.h"
+#include "DebugLog.h"
+#include "TraceLog.h"
+
+namespace {
+
+    /** Read a value from the dump, returning false if the dump is truncated.
+     */
+    template <typename T>
+    bool read_value(FILE* in, T& value)
+    {
+        return fread(&value, sizeof(value), 1, in) == 1;
+    }
+
+
+    /** Read a length-prefixed string from the dump.
+     */
+    bool read_string(FILE* in, std::string& str)
+    {
+        uint16_t len;
+        if(!read_value(in, len)) return false;
+
+        str.resize(len);
+        return !len || fread(&str[0], 1, len, in) == len;
+    }
+
+
+    /** Fetch a string from the table, or a placeholder if the index is bad.
+     */
+    const char* table_string(const std::vector<std::string>& strings, const uint16_t index)
+    {
+        return (index < strings.size()) ? strings[index].c_str() : "?";
+    }
+
+
+    /** Convert one record from the dump back into a DebugLog record, so that
+     *  it can be formatted by the same code that writes to the monolog.
+     *
+     * @return true if the record was decoded, false if it is malformed.
+     */
+    bool decode_record(const unsigned char* data, const size_t size, const std::vector<std::string>& strings, DebugLog::Record& record)
+    {
+        if(size < TraceLog::RECORD_HEADER) return false;
+
+        uint16_t header[4];
+        uint32_t time;
+        int32_t  obj_id;
+
+        memcpy(header, &data[0], sizeof(header));
+        memcpy(&time, &data[8], sizeof(time));
+        memcpy(&obj_id, &data[12], sizeof(obj_id));
+
+        record.level     = table_string(strings, header[1]);
+        record.script    = table_string(strings, header[2]);
+        record.format    = table_string(strings, header[3]);
+        record.time      = time;
+        record.obj_id    = obj_id;
+        record.arg_count = data[16];
+        record.text_used = 0;
+
+        if(record.arg_count > DebugLog::MAX_ARGS) return false;
+
+        size_t pos = TraceLog::RECORD_HEADER;
+        for(unsigned arg = 0; arg < record.arg_count; ++arg) {
+            DebugLog::Arg& value = record.args[arg];
+            if(pos >= size) return false;
+
+            value.type = static_cast<DebugLog::Arg::Type>(data[pos++]);
+            if(value.type == DebugLog::Arg::STRING) {
+                if(pos >= size) return false;
+
+                size_t len = data[pos++];
+                if(pos + len > size || record.text_used + len + 1 > DebugLog::TEXT_SIZE) return false;
+
+                char* copy = &record.text[record.text_used];
+                memcpy(copy, &data[pos], len);
+                copy[len] = '\0';
+
+                value.s = copy;
+                record.text_used += len + 1;
+                pos += len;
+
+            } else {
+                uint64_t bits;
+                if(pos + sizeof(bits) > size) return false;
+
+                memcpy(&bits, &data[pos], sizeof(bits));
+                pos += sizeof(bits);
+
+                if(value.type == DebugLog::Arg::POINTER) {
+                    value.p = reinterpret_cast<const void*>(static_cast<size_t>(bits));
+                } else {
+                    value.u = bits;
+                }
+            }
+        }
+
+        return true;
+    }
+
+
+    /** Decode the dump in the specified file, writing the records to stdout.
+     *
+     * @return true if the whole dump was decoded, false otherwise.
+     */
+    bool decode(const char* filename)
+    {
+        FILE* in = fopen(filename, "rb");
+        if(!in) {
+            fprintf(stderr, "Unable to open %s\n", filename);
+            return false;
+        }
+
+        std::vector<std::string>   strings;
+        std::map<int, std::string> objects;
+        std::vector<unsigned char> data;
+        uint32_t count;
+        bool     valid = false;
+
+        // Check the signature, and read the string and object tables
+        char signature[8];
+        if(fread(signature, 1, sizeof(signature), in) == sizeof(signature) && !memcmp(signature, TraceLog::SIGNATURE, sizeof(signature)) && read_value(in, count)) {
+            valid = true;
+
+            strings.resize(count);
+            for(uint32_t str = 0; valid && str < count; ++str)
+                valid = read_string(in, strings[str]);
+
+            if(valid) valid = read_value(in, count);
+            for(uint32_t obj = 0; valid && obj < count; ++obj) {
+                int32_t obj_id;
+                valid = read_value(in, obj_id) && read_string(in, objects[obj_id]);
+            }
+
+            if(valid) valid = read_value(in, count);
+            if(valid) {
+                data.resize(count);
+                valid = !count || fread(&data[0], 1, count, in) == count;
+            }
+        }
+        fclose(in);
+
+        if(!valid) {
+            fprintf(stderr, "%s is not a valid trace dump\n", filename);
+            return false;
+        }
+
+        // Now go through the records, formatting each one
+        DebugLog::Record record;
+        char buffer[900];
+        size_t pos = 0;
+
+        while(pos + sizeof(uint16_t) <= data.size()) {
+            uint16_t size;
+            memcpy(&size, &data[pos], sizeof(size));
+
+            if(!size || pos + size > data.size() || !decode_record(&data[pos], size, strings, record)) {
+                fprintf(stderr, "Malformed record at offset %lu\n", static_cast<unsigned long>(pos));
+                return false;
+            }
+
+            DebugLog::format(record, buffer, sizeof(buffer));
+
+            std::map<int, std::string>::const_iterator name = objects.find(record.obj_id);
+            printf("%10u %s[%s(%s)]: %s\n", record.time, record.level, record.script, (name != objects.end()) ? name -> second.c_str() : "?", buffer);
+
+            pos += size;
+        }
+
+        return true;
+    }
+}
+
+
+int main(int argc, char** argv)
+{
+    if(argc != 2) {
+        fprintf(stderr, "Usage: %s <trace file>\n", argv[0]);
+        fprintf(stderr, "    Decode a trace dumped by TWScript, normally %s, to stdout\n", TraceLog::TRACE_FILE);
+        return 1;
+    }
+
+    return decode(argv[1]) ? 0 : 1;
+}
@@ -0,0 +1,48 @@
+/** @file
+ * Host build stand-in for the lg compiler configuration header. This maps
+ * the handful of Windows-isms used by the script module onto their POSIX
+ * equivalents so that base/ and twscript/ can be compiled natively.
+ *
+ * @author Chris Page &lt;chris@starforge.co.uk&gt;
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef HOST_LG_CONFIG_H
+#define HOST_LG_CONFIG_H
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdarg>
+#include <strings.h>
+
+#define __stdcall
+#define __cdecl
+#define __declspec(x)
+
+#define _stricmp   strcasecmp
+#define stricmp    strcasecmp
+#define _strnicmp  strncasecmp
+#define strnicmp   strncasecmp
+#define _vsnprintf vsnprintf
+
+#define IF_NOT(a,b) ((a)?(a):(b))
+
+typedef unsigned int   uint;
+typedef unsigned long  ulong;
+typedef unsigned short ushort;
+typedef unsigned char  uchar;
+typedef int            Bool;
+
+#endif // HOST_LG_CONFIG_H
@@ -0,0 +1,114 @@
+/** @file
+ * Host build stand-in for the lg definitions header.
+ *
+ * @author Chris Page &lt;chris@starforge.co.uk&gt;
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef HOST_LG_DEFS_H
+#define HOST_LG_DEFS_H
+
+#include <lg/types.h>
+
+/** Timer handles. The real engine uses an opaque pointer, but scriptvars.h
+ *  stores handles in an int, so an int is used here to keep 64 bit hosts happy.
+ */
+typedef int tScrTimer;
+
+struct sScrDatumTag
+{
+    int         objId;
+    const char* pszClass;
+    const char* pszName;
+};
+
+enum eScrTimedMsgKind {
+    kSTM_OneShot,
+    kSTM_Periodic
+};
+
+enum eScrMsgFlags {
+    kScrMsgSendToProxy  = 1,
+    kScrMsgPostToOwner  = 2
+};
+
+enum eScrTraceAction {
+    kNoAction,
+    kBreak,
+    kSpew
+};
+
+enum eQuestDataType {
+    kQuestDataMission,
+    kQuestDataCampaign,
+    kQuestDataAny
+};
+
+enum eEnvSoundLoc {
+    kEnvSoundOnObj,
+    kEnvSoundAtObjLoc,
+    kEnvSoundAmbient
+};
+
+enum eSoundNetwork {
+    kSoundNetDefault,
+    kSoundNetworkAmbient,
+    kSoundNetNormal = kSoundNetDefault
+};
+
+enum eAIScriptAlertLevel {
+    kNoAlert,
+    kLowAlert,
+    kModerateAlert,
+    kHighAlert
+};
+
+enum eAIMode {
+    kAIM_Asleep,
+    kAIM_SuperEfficient,
+    kAIM_Efficient,
+    kAIM_Normal,
+    kAIM_Combat,
+    kAIM_Dead
+};
+
+enum eTweqType {
+    kTweqTypeScale,
+    kTweqTypeRotate,
+    kTweqTypeJoints,
+    kTweqTypeModels,
+    kTweqTypeDelete,
+    kTweqTypeEmitter,
+    kTweqTypeFlicker,
+    kTweqTypeLock,
+    kTweqTypeAll,
+    kTweqTypeNull
+};
+
+enum eTweqOperation {
+    kTweqOpKillAll,
+    kTweqOpRemoveTweq,
+    kTweqOpHaltTweq,
+    kTweqOpStatusQuo,
+    kTweqOpSlayAll,
+    kTweqOpFrameEvent
+};
+
+enum eTweqDirection {
+    kTweqDirForward,
+    kTweqDirReverse
+};
+
+#endif // HOST_LG_DEFS_H
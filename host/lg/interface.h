@@ -0,0 +1,99 @@
+/** @file
+ * Host build stand-in for the lg interface smart pointers.
+ *
+ * @author Chris Page &lt;chris@starforge.co.uk&gt;
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef HOST_LG_INTERFACE_H
+#define HOST_LG_INTERFACE_H
+
+#include <lg/objstd.h>
+
+class IScriptMan;
+
+/** Reference counted interface pointer. Constructing from a raw pointer to
+ *  the interface takes ownership of the reference; constructing from any
+ *  other IUnknown queries it for the interface.
+ */
+template <class T>
+class SInterface
+{
+public:
+    SInterface() : ptr(NULL)
+        { /* fnord */ }
+
+    SInterface(T* iface) : ptr(iface)
+        { /* fnord */ }
+
+    SInterface(IUnknown* source) : ptr(NULL)
+    {
+        if(source) source -> QueryInterface(IID_OF(T), reinterpret_cast<void**>(&ptr));
+    }
+
+    SInterface(const SInterface<T>& other) : ptr(other.ptr)
+    {
+        if(ptr) ptr -> AddRef();
+    }
+
+    ~SInterface()
+    {
+        if(ptr) ptr -> Release();
+    }
+
+    SInterface<T>& operator=(T* iface)
+    {
+        if(ptr) ptr -> Release();
+        ptr = iface;
+        return *this;
+    }
+
+    SInterface<T>& operator=(const SInterface<T>& other)
+    {
+        if(other.ptr) other.ptr -> AddRef();
+        if(ptr) ptr -> Release();
+        ptr = other.ptr;
+        return *this;
+    }
+
+    T* operator->() const
+        { return ptr; }
+
+    operator T*() const
+        { return ptr; }
+
+    T* get() const
+        { return ptr; }
+
+private:
+    T* ptr;
+};
+
+
+/** Script service pointer. Services are always fetched from the script
+ *  manager, which is only declared here to avoid an include cycle.
+ */
+template <class T>
+class SService : public SInterface<T>
+{
+public:
+    SService(IScriptMan* manager) : SInterface<T>(fetch(manager))
+        { /* fnord */ }
+
+private:
+    static T* fetch(IScriptMan* manager);
+};
+
+#endif // HOST_LG_INTERFACE_H
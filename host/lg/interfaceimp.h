@@ -0,0 +1,67 @@
+/** @file
+ * Host build stand-in for the lg interface implementation helper.
+ *
+ * @author Chris Page &lt;chris@starforge.co.uk&gt;
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef HOST_LG_INTERFACEIMP_H
+#define HOST_LG_INTERFACEIMP_H
+
+#include <lg/objstd.h>
+
+enum eInterfaceImpKind {
+    kInterfaceImpDynamic, //!< Deleted when the last reference is released
+    kInterfaceImpStatic   //!< Never deleted by Release()
+};
+
+
+template <class I, class IIDDef = IID_Def<I>, eInterfaceImpKind kind = kInterfaceImpDynamic>
+class cInterfaceImp : public I
+{
+public:
+    cInterfaceImp() : refcount(1)
+        { /* fnord */ }
+
+    virtual ~cInterfaceImp()
+        { /* fnord */ }
+
+    STDMETHOD(QueryInterface)(REFIID riid, void** iface)
+    {
+        if(&riid == &IIDDef::iid() || &riid == &IID_OF(IUnknown)) {
+            *iface = static_cast<I*>(this);
+            AddRef();
+            return S_OK;
+        }
+
+        *iface = NULL;
+        return E_NOINTERFACE;
+    }
+
+    STDMETHOD_(ulong,AddRef)(void)
+        { return ++refcount; }
+
+    STDMETHOD_(ulong,Release)(void)
+    {
+        ulong count = --refcount;
+        if(!count && kind == kInterfaceImpDynamic) delete this;
+        return count;
+    }
+
+private:
+    ulong refcount;
+};
+
+#endif // HOST_LG_INTERFACEIMP_H
@@ -0,0 +1,132 @@
+/** @file
+ * Host build stand-in for the lg link interfaces.
+ *
+ * @author Chris Page &lt;chris@starforge.co.uk&gt;
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef HOST_LG_LINKS_H
+#define HOST_LG_LINKS_H
+
+#include <lg/objstd.h>
+#include <lg/types.h>
+
+typedef long linkkind;
+
+struct sLink
+{
+    object source;
+    object dest;
+    short  flavor;
+};
+
+
+enum eAIAwareLevel {
+    kAIAL_Lowest,
+    kAIAL_Low,
+    kAIAL_Moderate,
+    kAIAL_High
+};
+
+/** Data stored on AIAwareness links.
+ */
+struct sAIAwareness
+{
+    object        Object;
+    uint          Flags;
+    eAIAwareLevel Level;
+    int           LevelEnterTime;
+    int           TimeLastContact;
+    mxs_vector    PosLastContact;
+    int           VisCone;
+    int           LastUpdate;
+};
+
+
+class ILinkQuery : public IUnknown
+{
+public:
+    STDMETHOD_(Bool,Done)(void) const PURE;
+    STDMETHOD(Link)(sLink*) const PURE;
+    STDMETHOD_(long,ID)(void) const PURE;
+    STDMETHOD_(void*,Data)(void) const PURE;
+    STDMETHOD(Next)(void) PURE;
+};
+
+
+class IRelation : public IUnknown
+{
+public:
+    STDMETHOD_(long,GetSingleLink)(object, object) PURE;
+    STDMETHOD_(Bool,Get)(long, sLink*) const PURE;
+};
+
+
+class ILinkManager : public IUnknown
+{
+public:
+    STDMETHOD_(IRelation*,GetRelationNamed)(const char*) PURE;
+    STDMETHOD_(long,Add)(object, object, long) PURE;
+    STDMETHOD(Remove)(long) PURE;
+    STDMETHOD(SetData)(long, void*) PURE;
+};
+
+
+/** A set of links returned by a link service query. The linkset owns the
+ *  query it wraps, and releases it on destruction.
+ */
+class linkset
+{
+public:
+    linkset() : query(NULL)
+        { /* fnord */ }
+
+    ~linkset()
+        { if(query) query -> Release(); }
+
+    linkset& operator=(ILinkQuery* newquery)
+    {
+        if(query) query -> Release();
+        query = newquery;
+        return *this;
+    }
+
+    bool AnyLinksLeft() const
+        { return query && !query -> Done(); }
+
+    void NextLink()
+        { if(query) query -> Next(); }
+
+    long Link() const
+        { return query ? query -> ID() : 0; }
+
+    sLink Get() const
+    {
+        sLink result = { 0, 0, 0 };
+        if(query) query -> Link(&result);
+        return result;
+    }
+
+    void* Data() const
+        { return query ? query -> Data() : NULL; }
+
+private:
+    linkset(const linkset&);
+    linkset& operator=(const linkset&);
+
+    ILinkQuery* query;
+};
+
+#endif // HOST_LG_LINKS_H
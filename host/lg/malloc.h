@@ -0,0 +1,47 @@
+/** @file
+ * Host build stand-in for the lg allocator header.
+ *
+ * @author Chris Page &lt;chris@starforge.co.uk&gt;
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef HOST_LG_MALLOC_H
+#define HOST_LG_MALLOC_H
+
+#include <lg/objstd.h>
+
+/** The debugging allocator interface. The host script manager never provides
+ *  this, but cMemoryAllocator needs the declaration in DEBUG builds.
+ */
+class IDebugMalloc : public IMalloc
+{
+public:
+    STDMETHOD_(void*,AllocEx)(ulong, const char*, int) PURE;
+    STDMETHOD_(void*,ReallocEx)(void*, ulong, const char*, int) PURE;
+    STDMETHOD_(void,FreeEx)(void*, const char*, int) PURE;
+    STDMETHOD(VerifyAlloc)(void*) PURE;
+    STDMETHOD(VerifyHeap)(void) PURE;
+    STDMETHOD_(void,DumpHeapInfo)(void) PURE;
+    STDMETHOD_(void,DumpStats)(void) PURE;
+    STDMETHOD_(void,DumpBlocks)(void) PURE;
+    STDMETHOD_(void,DumpModules)(void) PURE;
+    STDMETHOD_(void,PushCredit)(const char*, int) PURE;
+    STDMETHOD_(void,PopCredit)(void) PURE;
+};
+
+#define IID_IMalloc      IID_OF(IMalloc)
+#define IID_IDebugMalloc IID_OF(IDebugMalloc)
+
+#endif // HOST_LG_MALLOC_H
@@ -0,0 +1,73 @@
+/** @file
+ * Host build stand-in for the lg object system interfaces.
+ *
+ * @author Chris Page &lt;chris@starforge.co.uk&gt;
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef HOST_LG_OBJECTS_H
+#define HOST_LG_OBJECTS_H
+
+#include <lg/objstd.h>
+#include <lg/types.h>
+
+enum eTraitQueryType {
+    kTraitQueryMetaProps = 0x01,
+    kTraitQueryDonors    = 0x02,
+    kTraitQueryChildren  = 0x04,
+    kTraitQueryFull      = 0x10
+};
+
+
+class IObjectQuery : public IUnknown
+{
+public:
+    STDMETHOD_(Bool,Done)(void) PURE;
+    STDMETHOD_(int,Object)(void) PURE;
+    STDMETHOD(Next)(void) PURE;
+};
+
+
+enum eObjNotifyMsg {
+    kObjNotifyCreate,
+    kObjNotifyDelete
+};
+
+typedef void (__stdcall *ObjListenerFunc)(int, ulong, void*);
+
+struct sObjListenerDesc {
+    ObjListenerFunc pfnListener;
+    void*           pData;
+};
+
+
+class IObjectSystem : public IUnknown
+{
+public:
+    STDMETHOD_(int,GetObjectNamed)(const char*) PURE;
+    STDMETHOD_(const char*,GetName)(int) PURE;
+    STDMETHOD_(int,Listen)(sObjListenerDesc*) PURE;
+    STDMETHOD(Unlisten)(int) PURE;
+};
+
+
+class ITraitManager : public IUnknown
+{
+public:
+    STDMETHOD_(int,GetArchetype)(int) PURE;
+    STDMETHOD_(IObjectQuery*,Query)(int, ulong) PURE;
+};
+
+#endif // HOST_LG_OBJECTS_H
@@ -0,0 +1,88 @@
+/** @file
+ * Host build stand-in for the lg COM object header. Interfaces are plain
+ * abstract classes, and interface IDs are compared by address rather than
+ * by GUID value.
+ *
+ * @author Chris Page &lt;chris@starforge.co.uk&gt;
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef HOST_LG_OBJSTD_H
+#define HOST_LG_OBJSTD_H
+
+#include <lg/config.h>
+
+#define STDMETHOD(m)        virtual long __stdcall m
+#define STDMETHOD_(t,m)     virtual t __stdcall m
+#define STDMETHODIMP        long __stdcall
+#define STDMETHODIMP_(t)    t __stdcall
+#define PURE                = 0
+
+#define S_OK          0L
+#define S_FALSE       1L
+#define E_NOINTERFACE 0x80004002L
+#define E_FAIL        0x80004005L
+
+typedef long HRESULT;
+
+/** Interface identifiers. Each interface has a unique static GUID object,
+ *  and identity is established by comparing addresses.
+ */
+struct GUID {
+    const char* name;
+};
+
+typedef GUID IID;
+typedef const IID& REFIID;
+
+
+/** Fetch the identifier for the interface type T.
+ */
+template <class T>
+struct IID_Def
+{
+    static REFIID iid(void)
+    {
+        static const GUID id = { "" };
+        return id;
+    }
+};
+
+#define IID_OF(T) (IID_Def<T>::iid())
+
+
+class IUnknown
+{
+public:
+    virtual ~IUnknown() { /* fnord */ }
+
+    STDMETHOD(QueryInterface)(REFIID, void**) PURE;
+    STDMETHOD_(ulong,AddRef)(void) PURE;
+    STDMETHOD_(ulong,Release)(void) PURE;
+};
+
+
+class IMalloc : public IUnknown
+{
+public:
+    STDMETHOD_(void*,Alloc)(ulong) PURE;
+    STDMETHOD_(void*,Realloc)(void*, ulong) PURE;
+    STDMETHOD_(void,Free)(void*) PURE;
+    STDMETHOD_(ulong,GetSize)(void*) PURE;
+    STDMETHOD_(int,DidAlloc)(void*) PURE;
+    STDMETHOD_(void,HeapMinimize)(void) PURE;
+};
+
+#endif // HOST_LG_OBJSTD_H
@@ -0,0 +1,26 @@
+/** @file
+ * Host build stand-in for the lg propdefs header. Property access goes through
+ * IPropertySrv in scrservices.h, so there is nothing further to declare.
+ *
+ * @author Chris Page &lt;chris@starforge.co.uk&gt;
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef HOST_LG_PROPDEFS_H
+#define HOST_LG_PROPDEFS_H
+
+#include <lg/types.h>
+
+#endif // HOST_LG_PROPDEFS_H
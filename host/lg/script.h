@@ -0,0 +1,56 @@
+/** @file
+ * Host build stand-in for the lg script and script module interfaces.
+ *
+ * @author Chris Page &lt;chris@starforge.co.uk&gt;
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef HOST_LG_SCRIPT_H
+#define HOST_LG_SCRIPT_H
+
+#include <lg/objstd.h>
+#include <lg/scrmsgs.h>
+
+class IScript : public IUnknown
+{
+public:
+    STDMETHOD_(const char*,GetClassName)(void) PURE;
+    STDMETHOD(ReceiveMessage)(sScrMsg*, sMultiParm*, eScrTraceAction) PURE;
+};
+
+
+typedef IScript* (__cdecl *ScriptFactoryProc)(const char*, int);
+
+struct sScrClassDesc
+{
+    const char*       pszModule;
+    const char*       pszClass;
+    const char*       pszBaseClass;
+    ScriptFactoryProc pfnFactory;
+};
+
+typedef uint tScrIter;
+
+
+class IScriptModule : public IUnknown
+{
+public:
+    STDMETHOD_(const char*,GetName)(void) PURE;
+    STDMETHOD_(const sScrClassDesc*,GetFirstClass)(tScrIter*) PURE;
+    STDMETHOD_(const sScrClassDesc*,GetNextClass)(tScrIter*) PURE;
+    STDMETHOD_(void,EndClassIter)(tScrIter*) PURE;
+};
+
+#endif // HOST_LG_SCRIPT_H
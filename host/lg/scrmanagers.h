@@ -0,0 +1,52 @@
+/** @file
+ * Host build stand-in for the lg script manager interface.
+ *
+ * @author Chris Page &lt;chris@starforge.co.uk&gt;
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef HOST_LG_SCRMANAGERS_H
+#define HOST_LG_SCRMANAGERS_H
+
+#include <lg/objstd.h>
+#include <lg/types.h>
+#include <lg/defs.h>
+#include <lg/interface.h>
+#include <lg/script.h>
+
+class IScriptMan : public IUnknown
+{
+public:
+    STDMETHOD_(IUnknown*,GetService)(REFIID) PURE;
+
+    STDMETHOD_(cMultiParm*,SendMessage2)(cMultiParm&, object, object, const char*, const cMultiParm&, const cMultiParm&, const cMultiParm&) PURE;
+    STDMETHOD_(void,PostMessage2)(object, object, const char*, const cMultiParm&, const cMultiParm&, const cMultiParm&, ulong) PURE;
+    STDMETHOD_(tScrTimer,SetTimedMessage2)(object, const char*, ulong, eScrTimedMsgKind, const cMultiParm&) PURE;
+    STDMETHOD_(void,KillTimedMessage)(tScrTimer) PURE;
+
+    STDMETHOD_(int,IsScriptDataSet)(const sScrDatumTag*) PURE;
+    STDMETHOD(GetScriptData)(const sScrDatumTag*, sMultiParm*) PURE;
+    STDMETHOD(SetScriptData)(const sScrDatumTag*, const sMultiParm*) PURE;
+    STDMETHOD(ClearScriptData)(const sScrDatumTag*, sMultiParm*) PURE;
+};
+
+
+template <class T>
+T* SService<T>::fetch(IScriptMan* manager)
+{
+    return static_cast<T*>(manager -> GetService(IID_OF(T)));
+}
+
+#endif // HOST_LG_SCRMANAGERS_H
@@ -0,0 +1,143 @@
+/** @file
+ * Host build stand-in for the lg script message structures. Only the
+ * messages handled by base/ and twscript/ are declared.
+ *
+ * @author Chris Page &lt;chris@starforge.co.uk&gt;
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef HOST_LG_SCRMSGS_H
+#define HOST_LG_SCRMSGS_H
+
+#include <lg/types.h>
+#include <lg/defs.h>
+
+struct sScrMsg
+{
+    sScrMsg() : from(0), to(0), message(""), time(0), flags(0)
+        { /* fnord */ }
+
+    virtual ~sScrMsg()
+        { /* fnord */ }
+
+    virtual const char* GetName() const
+        { return "sScrMsg"; }
+
+    int         from;
+    int         to;
+    const char* message;
+    ulong       time;
+    int         flags;
+    cMultiParm  data;
+    cMultiParm  data2;
+    cMultiParm  data3;
+};
+
+
+struct sSimMsg : public sScrMsg
+{
+    sSimMsg() : fStarting(false)
+        { message = "Sim"; }
+
+    bool fStarting;
+};
+
+
+struct sScrTimerMsg : public sScrMsg
+{
+    sScrTimerMsg() : name("")
+        { message = "Timer"; }
+
+    const char* name;
+};
+
+
+struct sQuestMsg : public sScrMsg
+{
+    sQuestMsg() : m_pName(""), m_oldValue(0), m_newValue(0)
+        { message = "QuestChange"; }
+
+    const char* m_pName;
+    int         m_oldValue;
+    int         m_newValue;
+};
+
+
+struct sStimMsg : public sScrMsg
+{
+    sStimMsg() : stimulus(0), intensity(0.0f), sensor(0), source(0)
+        { /* fnord */ }
+
+    int   stimulus;
+    float intensity;
+    int   sensor;
+    int   source;
+};
+
+
+struct sTweqMsg : public sScrMsg
+{
+    sTweqMsg() : Type(kTweqTypeNull), Op(kTweqOpStatusQuo), Dir(kTweqDirForward)
+        { message = "TweqComplete"; }
+
+    eTweqType      Type;
+    eTweqOperation Op;
+    eTweqDirection Dir;
+};
+
+
+struct sRoomMsg : public sScrMsg
+{
+    sRoomMsg() : FromObjId(0), ToObjId(0), MoveObjId(0), ObjType(0), TransitionType(0)
+        { /* fnord */ }
+
+    int FromObjId;
+    int ToObjId;
+    int MoveObjId;
+    int ObjType;
+    int TransitionType;
+};
+
+
+struct sSlayMsg : public sScrMsg
+{
+    sSlayMsg() : culprit(0), kind(0)
+        { message = "Slain"; }
+
+    int culprit;
+    int kind;
+};
+
+
+struct sAIAlertnessMsg : public sScrMsg
+{
+    sAIAlertnessMsg() : level(kNoAlert), oldLevel(kNoAlert)
+        { message = "Alertness"; }
+
+    eAIScriptAlertLevel level;
+    eAIScriptAlertLevel oldLevel;
+};
+
+
+struct sAIModeChangeMsg : public sScrMsg
+{
+    sAIModeChangeMsg() : mode(kAIM_Normal), previous_mode(kAIM_Normal)
+        { message = "AIModeChange"; }
+
+    eAIMode mode;
+    eAIMode previous_mode;
+};
+
+#endif // HOST_LG_SCRMSGS_H
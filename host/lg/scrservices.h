@@ -0,0 +1,133 @@
+/** @file
+ * Host build stand-in for the lg script services. Only the service
+ * methods used by base/ and twscript/ are declared.
+ *
+ * @author Chris Page &lt;chris@starforge.co.uk&gt;
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef HOST_LG_SCRSERVICES_H
+#define HOST_LG_SCRSERVICES_H
+
+#include <lg/objstd.h>
+#include <lg/types.h>
+#include <lg/defs.h>
+#include <lg/links.h>
+#include <lg/scrmanagers.h>
+
+class IQuestSrv : public IUnknown
+{
+public:
+    STDMETHOD(SubscribeMsg)(object, const char*, eQuestDataType) PURE;
+    STDMETHOD(UnsubscribeMsg)(object, const char*) PURE;
+    STDMETHOD(Set)(const char*, int, eQuestDataType) PURE;
+    STDMETHOD_(int,Get)(const char*) PURE;
+    STDMETHOD_(int,Exists)(const char*) PURE;
+    STDMETHOD(Delete)(const char*) PURE;
+};
+
+
+class ILinkSrv : public IUnknown
+{
+public:
+    STDMETHOD(AnyExist)(true_bool&, linkkind, object, object) PURE;
+    STDMETHOD(GetAll)(linkset&, linkkind, object, object) PURE;
+    STDMETHOD(GetAllInheritedSingle)(linkset&, linkkind, object, object) PURE;
+};
+
+
+class ILinkToolsSrv : public IUnknown
+{
+public:
+    STDMETHOD_(long,LinkKindNamed)(const char*) PURE;
+    STDMETHOD(LinkSetData)(long, const char*, const cMultiParm&) PURE;
+};
+
+
+class IObjectSrv : public IUnknown
+{
+public:
+    STDMETHOD(BeginCreate)(object&, object) PURE;
+    STDMETHOD(EndCreate)(object) PURE;
+    STDMETHOD(Destroy)(object) PURE;
+    STDMETHOD(Named)(object&, const char*) PURE;
+    STDMETHOD(Position)(cScrVec&, object) PURE;
+    STDMETHOD(Facing)(cScrVec&, object) PURE;
+    STDMETHOD(Teleport)(object, const cScrVec&, const cScrVec&, object) PURE;
+    STDMETHOD(InheritsFrom)(true_bool&, object, object) PURE;
+    STDMETHOD(HasMetaProperty)(true_bool&, object, object) PURE;
+    STDMETHOD(AddMetaProperty)(object, object) PURE;
+    STDMETHOD(RenderedThisFrame)(true_bool&, object) PURE;
+};
+
+
+class IPropertySrv : public IUnknown
+{
+public:
+    STDMETHOD(Get)(cMultiParm&, object, const char*, const char*) PURE;
+    STDMETHOD(Set)(object, const char*, const char*, const cMultiParm&) PURE;
+    STDMETHOD(SetSimple)(object, const char*, const cMultiParm&) PURE;
+    STDMETHOD(Add)(object, const char*) PURE;
+    STDMETHOD(Remove)(object, const char*) PURE;
+    STDMETHOD_(Bool,Possessed)(object, const char*) PURE;
+};
+
+
+class IActReactSrv : public IUnknown
+{
+public:
+    STDMETHOD(Stimulate)(object, object, float, object) PURE;
+};
+
+
+class IPhysSrv : public IUnknown
+{
+public:
+    STDMETHOD(LaunchProjectile)(object&, object, object, float, int, const cScrVec&) PURE;
+    STDMETHOD(SetVelocity)(object, const cScrVec&) PURE;
+    STDMETHOD(ControlVelocity)(object, const cScrVec&) PURE;
+    STDMETHOD_(Bool,HasPhysics)(object) PURE;
+};
+
+
+class ISoundScrSrv : public IUnknown
+{
+public:
+    STDMETHOD(PlayEnvSchema)(true_bool&, object, const char*, object, object, eEnvSoundLoc, eSoundNetwork) PURE;
+};
+
+
+class IPGroupSrv : public IUnknown
+{
+public:
+    STDMETHOD(SetActive)(object, int) PURE;
+};
+
+
+class IEngineSrv : public IUnknown
+{
+public:
+    STDMETHOD_(int,ConfigIsDefined)(const char*) PURE;
+    STDMETHOD_(int,ConfigGetInt)(const char*, int&) PURE;
+};
+
+
+class IAIScrSrv : public IUnknown
+{
+public:
+    STDMETHOD_(eAIScriptAlertLevel,GetAlertLevel)(object) PURE;
+};
+
+#endif // HOST_LG_SCRSERVICES_H
@@ -0,0 +1,237 @@
+/** @file
+ * Host build stand-in for the lg basic types header. Only the parts of
+ * object, true_bool, cScrStr, cScrVec and cMultiParm that the script
+ * module actually relies upon are provided here.
+ *
+ * @author Chris Page &lt;chris@starforge.co.uk&gt;
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/.
+ */
+
+#ifndef HOST_LG_TYPES_H
+#define HOST_LG_TYPES_H
+
+#include <lg/objstd.h>
+#include <cmath>
+
+extern IMalloc* g_pMalloc;
+
+
+/** Object IDs. Concrete objects are positive, archetypes are negative.
+ */
+struct object
+{
+    int id;
+
+    object(int obj = 0) : id(obj)
+        { /* fnord */ }
+
+    operator int() const
+        { return id; }
+};
+
+
+/** Boolean results returned by reference from the script services.
+ */
+struct true_bool
+{
+    int f;
+
+    true_bool() : f(0)
+        { /* fnord */ }
+
+    operator bool() const
+        { return f != 0; }
+
+    true_bool& operator=(bool val)
+        { f = val ? 1 : 0; return *this; }
+};
+
+
+struct mxs_vector
+{
+    float x, y, z;
+};
+
+
+class cScrVec : public mxs_vector
+{
+public:
+    static const cScrVec Zero;
+
+    cScrVec()
+        { x = y = z = 0.0f; }
+
+    cScrVec(float vx, float vy, float vz)
+        { x = vx; y = vy; z = vz; }
+
+    cScrVec(const mxs_vector& vec)
+        { x = vec.x; y = vec.y; z = vec.z; }
+
+    cScrVec& operator=(const mxs_vector& vec)
+        { x = vec.x; y = vec.y; z = vec.z; return *this; }
+
+    cScrVec& operator*=(float scale)
+        { x *= scale; y *= scale; z *= scale; return *this; }
+
+    cScrVec operator-(const mxs_vector& vec) const
+        { return cScrVec(x - vec.x, y - vec.y, z - vec.z); }
+
+    cScrVec operator+(const mxs_vector& vec) const
+        { return cScrVec(x + vec.x, y + vec.y, z + vec.z); }
+
+    double MagSquared() const
+        { return double(x) * x + double(y) * y + double(z) * z; }
+
+    double Magnitude() const
+        { return std::sqrt(MagSquared()); }
+
+    double Distance(const mxs_vector& vec) const
+        { return (*this - vec).Magnitude(); }
+
+    cScrVec& Normalize()
+    {
+        double mag = Magnitude();
+        if(mag > 0.0) *this *= float(1.0 / mag);
+        return *this;
+    }
+};
+
+
+/** Strings returned by the script services. The memory is owned by the
+ *  caller once returned, and must be released with Free().
+ */
+class cScrStr
+{
+public:
+    cScrStr() : str(NULL)
+        { /* fnord */ }
+
+    cScrStr(const char* val) : str(const_cast<char*>(val))
+        { /* fnord */ }
+
+    cScrStr& operator=(const char* val)
+        { str = const_cast<char*>(val); return *this; }
+
+    operator const char*() const
+        { return str ? str : ""; }
+
+    void Free()
+    {
+        if(str) g_pMalloc -> Free(str);
+        str = NULL;
+    }
+
+private:
+    char* str;
+};
+
+
+enum eMultiParmType {
+    kMT_Undef,
+    kMT_Int,
+    kMT_Float,
+    kMT_String,
+    kMT_Vector,
+};
+
+
+struct sMultiParm
+{
+    union {
+        int         i;
+        float       f;
+        char*       psz;
+        mxs_vector* pVector;
+    };
+    eMultiParmType type;
+};
+
+
+/** A multi-type parameter value. Strings and vectors are stored in memory
+ *  allocated via g_pMalloc, and are released when the value changes.
+ */
+class cMultiParm : public sMultiParm
+{
+public:
+    static const cMultiParm Undef;
+
+    cMultiParm()
+        { type = kMT_Undef; i = 0; }
+
+    cMultiParm(int val)
+        { type = kMT_Int; i = val; }
+
+    cMultiParm(long val)
+        { type = kMT_Int; i = int(val); }
+
+    cMultiParm(float val)
+        { type = kMT_Float; f = val; }
+
+    cMultiParm(double val)
+        { type = kMT_Float; f = float(val); }
+
+    cMultiParm(const char* val)
+        { type = kMT_Undef; set_string(val); }
+
+    cMultiParm(const mxs_vector& val)
+        { type = kMT_Undef; set_vector(val); }
+
+    cMultiParm(const cMultiParm& val)
+        { type = kMT_Undef; copy(val); }
+
+    cMultiParm(const sMultiParm& val)
+        { type = kMT_Undef; copy(val); }
+
+    ~cMultiParm()
+        { clear(); }
+
+    cMultiParm& operator=(int val)
+        { clear(); type = kMT_Int; i = val; return *this; }
+
+    cMultiParm& operator=(float val)
+        { clear(); type = kMT_Float; f = val; return *this; }
+
+    cMultiParm& operator=(double val)
+        { clear(); type = kMT_Float; f = float(val); return *this; }
+
+    cMultiParm& operator=(const char* val)
+        { set_string(val); return *this; }
+
+    cMultiParm& operator=(const mxs_vector& val)
+        { set_vector(val); return *this; }
+
+    cMultiParm& operator=(const cMultiParm& val)
+        { if(&val != this) copy(val); return *this; }
+
+    cMultiParm& operator=(const sMultiParm& val)
+        { if(&val != this) copy(val); return *this; }
+
+    operator int() const;
+    operator float() const;
+    operator const char*() const;
+    operator const mxs_vector*() const;
+
+    bool operator==(const char* val) const;
+    bool operator!=(const char* val) const
+        { return !(*this == val); }
+
+private:
+    void clear();
+    void copy(const sMultiParm& val);
+    void set_string(const char* val);
+    void set_vector(const mxs_vector& val);
+};
+
+#endif // HOST_LG_TYPES_H
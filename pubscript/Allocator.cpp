@@ -75,25 +75,74 @@ void operator delete[](void* ptr, const std::nothrow_t&) throw()
 		g_Allocator.Free(ptr);
 }
 
-cMemoryAllocator::AllocRecord cMemoryAllocator::nullrecord;
+// The block sizes of the pools, and the pool used for each multiple of 8 bytes.
+// The sizes are multiples of 16, the strictest alignment of any target.
+constexpr ulong cMemoryAllocator::sm_poolsize[kPoolClasses];
+
+const unsigned char cMemoryAllocator::sm_poolclass[kPoolMax/8 + 1] = {
+	0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 6,
+	6, 7, 7, 7, 7, 8, 8, 8, 8, 9, 9, 9, 9, 9, 9, 9,
+	9
+};
+
+bool cMemoryAllocator::sm_destroyed = false;
 
 cMemoryAllocator::cMemoryAllocator()
 {
+	// Slabs and heap blocks come from the engine aligned to kAlign, so this
+	// is all it takes for every block to be aligned
+	static_assert((sizeof(PoolSlab) + sizeof(AllocRecord)) % kAlign == 0, "pool blocks would be misaligned");
+	static_assert(sizeof(AllocRecord) % kAlign == 0, "heap blocks would be misaligned");
+	static_assert(PoolSizesAligned(0), "pool sizes must be multiples of the alignment");
+	static_assert((kSlabSize & (kSlabSize - 1)) == 0, "slabs are found by masking addresses");
+
 	m_alloc = NULL;
 #ifdef DEBUG
 	m_dballoc = NULL;
 #endif
-	m_recordhead = &nullrecord;
+	for (int pool = 0; pool < int(kPoolClasses); ++pool)
+		m_freelist[pool] = NULL;
+	m_slabset.slots = NULL;
+	m_slabset.count = m_slabset.mask = 0;
+	m_heapset.slots = NULL;
+	m_heapset.count = m_heapset.mask = 0;
+	m_chunks = NULL;
+	m_spareslabs = NULL;
+	m_poolblocks = 0;
+	memset(&m_stats, 0, sizeof(m_stats));
+	for (int pool = 0; pool < int(kPoolClasses); ++pool)
+		m_stats.classes[pool].blocksize = sm_poolsize[pool];
 }
 
 cMemoryAllocator::~cMemoryAllocator()
 {
+	// Slabs can only be returned if nothing still points into them, as
+	// other static objects may be destroyed after this one.
+	if (m_alloc && !m_poolblocks)
+	{
+		while (m_chunks)
+		{
+			PoolChunk* chunk = m_chunks;
+			m_chunks = chunk->next;
+			HeapFree(chunk, __FILE__, __LINE__);
+		}
+	}
+	// Nothing looks at the sets once sm_destroyed is set below
 	if (m_alloc)
+	{
+		SetRelease(m_slabset);
+		SetRelease(m_heapset);
 		m_alloc->Release();
+	}
 #ifdef DEBUG
 	if (m_dballoc)
 		m_dballoc->Release();
 #endif
+	// Static containers destroyed after this one still free their storage
+	// through operator delete, which must then do nothing. This is kept
+	// outside the object, as the compiler may drop stores to an object
+	// in its own destructor.
+	sm_destroyed = true;
 }
 
 IMalloc* cMemoryAllocator::AttachMalloc(IMalloc* allocator, const char* module)
@@ -115,138 +164,390 @@ IMalloc* cMemoryAllocator::AttachMalloc(IMalloc* allocator, const char* module)
 }
 
 ulong cMemoryAllocator::CountAlloc(void)
+{
+	return m_stats.allocs;
+}
+
+ulong cMemoryAllocator::CountAverage(void)
+{
+	return m_stats.allocs ? m_stats.bytes / m_stats.allocs : 0;
+}
+
+ulong cMemoryAllocator::CountBlocks(void)
+{
+	return m_stats.blocks;
+}
+
+ulong cMemoryAllocator::CountSize(void)
+{
+	return m_stats.size;
+}
+
+void cMemoryAllocator::Counted(int cls, ulong size)
+{
+	m_stats.allocs++;
+	m_stats.bytes += size;
+	if (++m_stats.blocks > m_stats.peakblocks)
+		m_stats.peakblocks = m_stats.blocks;
+	if ((m_stats.size += size) > m_stats.peaksize)
+		m_stats.peaksize = m_stats.size;
+
+	ClassStats& counts = m_stats.classes[cls];
+	counts.allocs++;
+	if (++counts.live > counts.peak)
+		counts.peak = counts.live;
+}
+
+void cMemoryAllocator::Uncounted(int cls, ulong size)
+{
+	m_stats.blocks--;
+	m_stats.size -= size;
+	m_stats.classes[cls].live--;
+}
+
+ulong cMemoryAllocator::SetHash(const void* ptr)
+{
+	// Slab addresses differ only above kSlabSize, and heap blocks are
+	// aligned, so fold the high bits down before mixing
+	size_t key = reinterpret_cast<size_t>(ptr);
+	key ^= key >> 14;
+	key = (key >> 4) * 2654435761UL;
+	return ulong(key ^ (key >> 16));
+}
+
+bool cMemoryAllocator::SetFind(const PtrSet& set, const void* ptr)
+{
+	if (!set.count)
+		return false;
+	for (ulong slot = SetHash(ptr) & set.mask; set.slots[slot]; slot = (slot + 1) & set.mask)
+	{
+		if (set.slots[slot] == ptr)
+			return true;
+	}
+	return false;
+}
+
+bool cMemoryAllocator::SetInsert(PtrSet& set, void* ptr)
+{
+	// Keep the set at most half full, so probes stay short
+	if ((set.count + 1) * 2 > (set.slots ? set.mask + 1 : 0))
+	{
+		ulong size = set.slots ? (set.mask + 1) * 2 : 64;
+		void** slots = static_cast<void**>(HeapAlloc(size * sizeof(void*), __FILE__, __LINE__));
+		if (!slots)
+			return false;
+		memset(slots, 0, size * sizeof(void*));
+		if (set.slots)
+		{
+			for (ulong old = 0; old <= set.mask; ++old)
+			{
+				if (!set.slots[old])
+					continue;
+				ulong slot = SetHash(set.slots[old]) & (size - 1);
+				while (slots[slot])
+					slot = (slot + 1) & (size - 1);
+				slots[slot] = set.slots[old];
+			}
+			HeapFree(set.slots, __FILE__, __LINE__);
+		}
+		set.slots = slots;
+		set.mask = size - 1;
+	}
+	ulong slot = SetHash(ptr) & set.mask;
+	while (set.slots[slot])
+		slot = (slot + 1) & set.mask;
+	set.slots[slot] = ptr;
+	++set.count;
+	return true;
+}
+
+void cMemoryAllocator::SetErase(PtrSet& set, void* ptr)
+{
+	ulong slot = SetHash(ptr) & set.mask;
+	while (set.slots[slot] != ptr)
+		slot = (slot + 1) & set.mask;
+	set.slots[slot] = NULL;
+	--set.count;
+
+	// Move back any later entries that the gap would hide from SetFind()
+	for (ulong next = (slot + 1) & set.mask; set.slots[next]; next = (next + 1) & set.mask)
+	{
+		ulong home = SetHash(set.slots[next]) & set.mask;
+		if (((next - home) & set.mask) >= ((next - slot) & set.mask))
+		{
+			set.slots[slot] = set.slots[next];
+			set.slots[next] = NULL;
+			slot = next;
+		}
+	}
+}
+
+void cMemoryAllocator::SetRelease(PtrSet& set)
+{
+	if (set.slots)
+		HeapFree(set.slots, __FILE__, __LINE__);
+	set.slots = NULL;
+	set.count = set.mask = 0;
+}
+
+// Work out where a block came from without touching it unless it is ours.
+// Returns its pool class, kHeapClass, kForeign, or kBadBlock if it lies in
+// a slab but does not start a block there.
+int cMemoryAllocator::FindBlock(void* ptr) const
+{
+	char* addr = static_cast<char*>(ptr);
+	PoolSlab* slab = reinterpret_cast<PoolSlab*>(reinterpret_cast<size_t>(ptr) & ~size_t(kSlabSize - 1));
+	if (SetFind(m_slabset, slab))
+	{
+		if (slab->pool == kNoPool)
+			return kBadBlock;
+		char* first = reinterpret_cast<char*>(slab+1) + sizeof(AllocRecord);
+		ulong stride = sizeof(AllocRecord) + sm_poolsize[slab->pool];
+		if (addr < first || ulong(addr - first) % stride != 0
+		 || addr + sm_poolsize[slab->pool] > reinterpret_cast<char*>(slab) + kSlabSize)
+			return kBadBlock;
+		return int(slab->pool);
+	}
+	if (SetFind(m_heapset, static_cast<AllocRecord*>(ptr)-1))
+		return kHeapClass;
+	return kForeign;
+}
+
+void* cMemoryAllocator::HeapAlloc(ulong size, const char* file, int line)
 {
 #ifdef DEBUG
-	return m_numallocs;
-#else
-	return (ulong)-1;
+	if (m_dballoc)
+		return m_dballoc->AllocEx(size, file, line);
 #endif
+	return m_alloc->Alloc(size);
 }
 
-ulong cMemoryAllocator::CountAverage(void)
+void* cMemoryAllocator::HeapRealloc(void* ptr, ulong size, const char* file, int line)
 {
 #ifdef DEBUG
-	return m_grosstotal / m_numallocs;
-#else
-	return (ulong)-1;
+	if (m_dballoc)
+		return m_dballoc->ReallocEx(ptr, size, file, line);
 #endif
+	return m_alloc->Realloc(ptr, size);
 }
 
-ulong cMemoryAllocator::CountBlocks(void)
+void cMemoryAllocator::HeapFree(void* ptr, const char* file, int line)
 {
 #ifdef DEBUG
-	ulong num = 0;
-	AllocRecord *rec;
-	for (rec = m_recordhead;
-		 rec->next != rec;
-		 rec = rec->next)
+	if (m_dballoc)
 	{
-		num++;
+		m_dballoc->FreeEx(ptr, file, line);
+		return;
 	}
-	return num;
-#else
-	return (ulong)-1;
 #endif
+	m_alloc->Free(ptr);
+}
+
+// Take a chunk from the engine heap and split it into spare slabs on
+// kSlabSize boundaries. The chunk has a slab's worth of slack so that at
+// least kChunkSlabs-1 whole slabs fit after the chunk header.
+bool cMemoryAllocator::AddChunk(void)
+{
+	ulong chunksize = (kChunkSlabs + 1) * kSlabSize;
+	PoolChunk* chunk = static_cast<PoolChunk*>(HeapAlloc(chunksize, __FILE__, __LINE__));
+	if (!chunk)
+		return false;
+	size_t start = reinterpret_cast<size_t>(chunk+1);
+	char* slab = reinterpret_cast<char*>((start + kSlabSize - 1) & ~size_t(kSlabSize - 1));
+	char* end = reinterpret_cast<char*>(chunk) + chunksize;
+	bool added = false;
+	for (; slab + kSlabSize <= end; slab += kSlabSize)
+	{
+		if (!SetInsert(m_slabset, slab))
+			break;
+		PoolSlab* spare = reinterpret_cast<PoolSlab*>(slab);
+		spare->pool = kNoPool;
+		spare->next = m_spareslabs;
+		m_spareslabs = spare;
+		added = true;
+	}
+	if (!added)
+	{
+		HeapFree(chunk, __FILE__, __LINE__);
+		return false;
+	}
+	chunk->next = m_chunks;
+	m_chunks = chunk;
+	return true;
 }
 
-ulong cMemoryAllocator::CountSize(void)
+bool cMemoryAllocator::RefillPool(int pool)
 {
-#ifdef DEBUG
-	ulong size = 0;
-	AllocRecord *rec;
-	for (rec = m_recordhead;
-		 rec->next != rec;
-		 rec = rec->next)
+	if (!m_spareslabs && !AddChunk())
+		return false;
+	PoolSlab* slab = m_spareslabs;
+	m_spareslabs = slab->next;
+	slab->pool = pool;
+	m_stats.slabs++;
+
+	// Carve the rest of the slab into blocks for the pool's free list
+	ulong stride = sizeof(AllocRecord) + sm_poolsize[pool];
+	char* block = reinterpret_cast<char*>(slab+1);
+	char* end = reinterpret_cast<char*>(slab) + kSlabSize;
+	for (; block + stride <= end; block += stride)
 	{
-		size += rec->size;
+		AllocRecord* rec = reinterpret_cast<AllocRecord*>(block);
+		rec->next = m_freelist[pool];
+		rec->tag = 0;
+		m_freelist[pool] = rec;
 	}
-	return size;
-#else
-	return (ulong)-1;
-#endif
+	return true;
 }
 
-STDMETHODIMP_(void*) cMemoryAllocator::Alloc(ulong size)
+void* cMemoryAllocator::DoAlloc(ulong size, const char* file, int line)
 {
 	assert(m_alloc != NULL);
 	AllocRecord* rec;
-#ifdef DEBUG
-	if (m_dballoc)
-		rec = static_cast<AllocRecord*>(m_dballoc->AllocEx(size+sizeof(AllocRecord), m_module, 0));
+	int cls = kHeapClass;
+	if (size <= kPoolMax)
+	{
+		cls = sm_poolclass[(size + 7) >> 3];
+		if (!m_freelist[cls] && !RefillPool(cls))
+			return NULL;
+		rec = m_freelist[cls];
+		m_freelist[cls] = rec->next;
+		++m_poolblocks;
+	}
 	else
-#endif
-		rec = static_cast<AllocRecord*>(m_alloc->Alloc(size+sizeof(AllocRecord)));
-	rec->insert(&m_recordhead);
+	{
+		rec = static_cast<AllocRecord*>(HeapAlloc(size+sizeof(AllocRecord), file, line));
+		if (!rec)
+			return NULL;
+		if (!SetInsert(m_heapset, rec))
+		{
+			HeapFree(rec, file, line);
+			return NULL;
+		}
+	}
+	rec->tag = kRecordMagic | cls;
 	rec->size = size;
-#ifdef DEBUG
-	m_numallocs++;
-	m_grosstotal += size;
-#endif
+	Counted(cls, size);
 	return rec+1;
 }
 
-STDMETHODIMP_(void*) cMemoryAllocator::Realloc(void* ptr, ulong size)
+void cMemoryAllocator::DoFree(void* ptr, const char* file, int line)
+{
+	// Once the allocator has been destroyed, anything left is leaked
+	if (!ptr || sm_destroyed)
+		return;
+	int pool = FindBlock(ptr);
+	if (pool == kForeign)
+	{
+		HeapFree(ptr, file, line);
+		return;
+	}
+	AllocRecord* rec = static_cast<AllocRecord*>(ptr)-1;
+	if (pool == kBadBlock || rec->tag != (kRecordMagic | pool))
+	{
+		// Freed twice, or never allocated: either way, leave it alone
+		assert(!"cMemoryAllocator: free of a block that is not allocated");
+		return;
+	}
+	Uncounted(pool, rec->size);
+	if (pool == kHeapClass)
+	{
+		SetErase(m_heapset, rec);
+		HeapFree(rec, file, line);
+	}
+	else
+	{
+		rec->tag = 0;
+		rec->next = m_freelist[pool];
+		m_freelist[pool] = rec;
+		--m_poolblocks;
+	}
+}
+
+void* cMemoryAllocator::DoRealloc(void* ptr, ulong size, const char* file, int line)
 {
 	assert(m_alloc != NULL);
 	if (!ptr)
-		return Alloc(size);
+		return DoAlloc(size, file, line);
 	if (!size)
 	{
-		Free(ptr);
+		DoFree(ptr, file, line);
 		return NULL;
 	}
+	int pool = FindBlock(ptr);
+	if (pool == kForeign)
+		return HeapRealloc(ptr, size, file, line);
+
 	AllocRecord* rec = static_cast<AllocRecord*>(ptr)-1;
-	if (rec->remove(&m_recordhead))
+	if (pool == kBadBlock || rec->tag != (kRecordMagic | pool))
 	{
-		AllocRecord* newrec;
-#ifdef DEBUG
-		if (m_dballoc)
-			newrec = static_cast<AllocRecord*>(m_dballoc->ReallocEx(rec, size+sizeof(AllocRecord), m_module, 0));
-		else
-#endif
-			newrec = static_cast<AllocRecord*>(m_alloc->Realloc(rec, size+sizeof(AllocRecord)));
+		assert(!"cMemoryAllocator: realloc of a block that is not allocated");
+		return NULL;
+	}
+	if (pool == kHeapClass && size > kPoolMax)
+	{
+		ulong oldsize = rec->size;
+		AllocRecord* newrec = static_cast<AllocRecord*>(HeapRealloc(rec, size+sizeof(AllocRecord), file, line));
 		if (!newrec)
-		{
-			rec->insert(&m_recordhead);
 			return NULL;
+		if (newrec != rec)
+		{
+			// Removing the old entry leaves room for the new one
+			SetErase(m_heapset, rec);
+			SetInsert(m_heapset, newrec);
 		}
-#ifdef DEBUG
-		if (size > rec->size)
-			m_grosstotal += size - rec->size;
-#endif
-		newrec->insert(&m_recordhead);
 		newrec->size = size;
+		if (size > oldsize)
+			m_stats.bytes += size - oldsize;
+		m_stats.size += size;
+		m_stats.size -= oldsize;
+		if (m_stats.size > m_stats.peaksize)
+			m_stats.peaksize = m_stats.size;
 		return newrec+1;
 	}
+	if (pool != kHeapClass && size <= sm_poolsize[pool])
+	{
+		m_stats.size += size;
+		m_stats.size -= rec->size;
+		if (m_stats.size > m_stats.peaksize)
+			m_stats.peaksize = m_stats.size;
+		rec->size = size;
+		return ptr;
+	}
+
+	// Moving between a pool and the heap, or between pools
+	void* newptr = DoAlloc(size, file, line);
+	if (!newptr)
+		return NULL;
+	memcpy(newptr, ptr, (size < rec->size) ? size : rec->size);
+	DoFree(ptr, file, line);
+	return newptr;
+}
+
+STDMETHODIMP_(void*) cMemoryAllocator::Alloc(ulong size)
+{
 #ifdef DEBUG
-	if (m_dballoc)
-		return m_dballoc->ReallocEx(rec, size+sizeof(AllocRecord), m_module, 0);
+	return DoAlloc(size, m_module, 0);
+#else
+	return DoAlloc(size, NULL, 0);
 #endif
-	return m_alloc->Realloc(ptr, size);
 }
 
-STDMETHODIMP_(void) cMemoryAllocator::Free(void* ptr)
+STDMETHODIMP_(void*) cMemoryAllocator::Realloc(void* ptr, ulong size)
 {
-	assert(m_alloc != NULL);
-	AllocRecord* rec = static_cast<AllocRecord*>(ptr)-1;
-	if (rec->remove(&m_recordhead))
-	{
 #ifdef DEBUG
-		if (m_dballoc)
-			m_dballoc->FreeEx(rec, m_module, 0);
-		else
+	return DoRealloc(ptr, size, m_module, 0);
+#else
+	return DoRealloc(ptr, size, NULL, 0);
 #endif
-			m_alloc->Free(rec);
-	}
-	else
-	{
+}
+
+STDMETHODIMP_(void) cMemoryAllocator::Free(void* ptr)
+{
 #ifdef DEBUG
-		if (m_dballoc)
-			m_dballoc->FreeEx(ptr, m_module, 0);
-		else
+	DoFree(ptr, m_module, 0);
+#else
+	DoFree(ptr, NULL, 0);
 #endif
-			m_alloc->Free(ptr);
-	}
 }
 
 STDMETHODIMP_(ulong) cMemoryAllocator::GetSize(void* ptr)
@@ -254,11 +555,12 @@ STDMETHODIMP_(ulong) cMemoryAllocator::GetSize(void* ptr)
 	assert(m_alloc != NULL);
 	if (!ptr)
 		return (ulong)-1;
-	AllocRecord* rec = static_cast<AllocRecord*>(ptr)-1;
-	rec = rec->find(m_recordhead);
-	if (rec)
-		return rec->size;
-	return m_alloc->GetSize(ptr);
+	int pool = FindBlock(ptr);
+	if (pool == kForeign)
+		return m_alloc->GetSize(ptr);
+	if (pool == kBadBlock)
+		return (ulong)-1;
+	return (static_cast<AllocRecord*>(ptr)-1)->size;
 }
 
 STDMETHODIMP_(int) cMemoryAllocator::DidAlloc(void* ptr)
@@ -266,11 +568,10 @@ STDMETHODIMP_(int) cMemoryAllocator::DidAlloc(void* ptr)
 	assert(m_alloc != NULL);
 	if (!ptr)
 		return 0;
-	AllocRecord* rec = static_cast<AllocRecord*>(ptr)-1;
-	rec = rec->find(m_recordhead);
-	if (rec)
-		return 1;
-	return 0;
+	int pool = FindBlock(ptr);
+	if (pool < 0)
+		return 0;
+	return ((static_cast<AllocRecord*>(ptr)-1)->tag == ulong(kRecordMagic | pool)) ? 1 : 0;
 }
 
 STDMETHODIMP_(void) cMemoryAllocator::HeapMinimize(void)
@@ -282,71 +583,17 @@ STDMETHODIMP_(void) cMemoryAllocator::HeapMinimize(void)
 #ifdef DEBUG
 STDMETHODIMP_(void*) cMemoryAllocator::AllocEx(ulong size, const char* file, int line)
 {
-	assert(m_alloc != NULL);
-	AllocRecord* rec;
-	if (m_dballoc)
-		rec = static_cast<AllocRecord*>(m_dballoc->AllocEx(size+sizeof(AllocRecord), file, line));
-	else
-		rec = static_cast<AllocRecord*>(m_alloc->Alloc(size+sizeof(AllocRecord)));
-	rec->insert(&m_recordhead);
-	rec->size = size;
-	m_numallocs++;
-	m_grosstotal += size;
-	return rec+1;
+	return DoAlloc(size, file, line);
 }
 
 STDMETHODIMP_(void*) cMemoryAllocator::ReallocEx(void* ptr, ulong size, const char* file, int line)
 {
-	assert(m_alloc != NULL);
-	if (!ptr)
-		return Alloc(size);
-	if (!size)
-	{
-		Free(ptr);
-		return NULL;
-	}
-	AllocRecord* rec = static_cast<AllocRecord*>(ptr)-1;
-	if (rec->remove(&m_recordhead))
-	{
-		AllocRecord* newrec;
-		if (m_dballoc)
-			newrec = static_cast<AllocRecord*>(m_dballoc->ReallocEx(rec, size+sizeof(AllocRecord), file, line));
-		else
-			newrec = static_cast<AllocRecord*>(m_alloc->Realloc(rec, size+sizeof(AllocRecord)));
-		if (!newrec)
-		{
-			rec->insert(&m_recordhead);
-			return NULL;
-		}
-		if (size > rec->size)
-			m_grosstotal += size - rec->size;
-		newrec->insert(&m_recordhead);
-		newrec->size = size;
-		return newrec+1;
-	}
-	if (m_dballoc)
-		return m_dballoc->ReallocEx(rec, size+sizeof(AllocRecord), file, line);
-	return m_alloc->Realloc(ptr, size);
+	return DoRealloc(ptr, size, file, line);
 }
 
 STDMETHODIMP_(void) cMemoryAllocator::FreeEx(void* ptr, const char* file, int line)
 {
-	assert(m_alloc != NULL);
-	AllocRecord* rec = static_cast<AllocRecord*>(ptr)-1;
-	if (rec->remove(&m_recordhead))
-	{
-		if (m_dballoc)
-			m_dballoc->FreeEx(rec, file, line);
-		else
-			m_alloc->Free(rec);
-	}
-	else
-	{
-		if (m_dballoc)
-			m_dballoc->FreeEx(ptr, file, line);
-		else
-			m_alloc->Free(ptr);
-	}
+	DoFree(ptr, file, line);
 }
 
 STDMETHODIMP cMemoryAllocator::VerifyAlloc(void* ptr)
@@ -30,12 +30,57 @@
 #else
 #define cMemoryAllocatorBase IMalloc
 #endif
+/*
+ * Small blocks are served from per-size-class pools carved out of slabs taken
+ * from the engine heap, so that most allocations and frees are a free list
+ * push or pop rather than a call into the engine. Larger blocks go straight
+ * to the engine heap. Every block carries a short header recording its size.
+ *
+ * Whether a block being freed came from a pool, from the heap through here,
+ * or from somewhere else entirely (the engine hands out strings that are
+ * freed through g_pMalloc) is decided from its address alone, so the memory
+ * in front of a foreign block is never read. Slabs are carved from larger
+ * chunks on kSlabSize boundaries, so masking an address gives the only slab
+ * it could lie in, which is looked up in a hash set of slabs; heap blocks
+ * are looked up in a hash set of their headers. Both take constant time.
+ */
 class cMemoryAllocator : public cMemoryAllocatorBase
 {
 	struct AllocRecord;
+	struct PoolSlab;
+	struct PoolChunk;
 
 public:
 
+	enum
+	{
+		kPoolClasses = 10,        // The number of pool size classes
+		kHeapClass   = 10         // The class engine heap blocks are tagged with
+	};
+
+	// Counters for one size class, or for the blocks on the engine heap
+	struct ClassStats
+	{
+		ulong blocksize;  // The size of the blocks in the class, 0 for the heap
+		ulong allocs;     // How many blocks have been allocated from the class
+		ulong live;       // How many blocks are currently allocated
+		ulong peak;       // The most blocks allocated at once
+	};
+
+	// A snapshot of the allocator's counters. These are kept in every build,
+	// and cost a few increments per allocation.
+	struct Stats
+	{
+		ulong allocs;      // How many blocks have been allocated
+		ulong bytes;       // How many bytes have been requested in total
+		ulong blocks;      // How many blocks are currently allocated
+		ulong size;        // How many bytes are currently allocated
+		ulong peakblocks;  // The most blocks allocated at once
+		ulong peaksize;    // The most bytes allocated at once
+		ulong slabs;       // How many slabs have been taken from the engine heap
+		ClassStats classes[kHeapClass+1];
+	};
+
 	virtual ~cMemoryAllocator();
 	cMemoryAllocator();
 	IMalloc* AttachMalloc(IMalloc* allocator, const char* module);
@@ -43,6 +88,10 @@ public:
 	ulong CountAverage(void);
 	ulong CountBlocks(void);
 	ulong CountSize(void);
+	const Stats& GetStats(void) const
+	{
+		return m_stats;
+	}
 
 	STDMETHOD(QueryInterface)(REFIID, void** ppv)
 	{
@@ -80,61 +129,109 @@ public:
 
 private:
 
+	// The types with the strictest alignment a block may have to hold
+	union MaxAlign
+	{
+		double d;
+		long double ld;
+		long long ll;
+		void* p;
+	};
+
+	enum
+	{
+		kAlign       = alignof(MaxAlign), // Every block handed out is aligned to this
+		kPoolMax     = 256,       // The largest block served from the pools
+		kSlabSize    = 16384,     // The size of the slabs the pools are carved from, a power of 2
+		kChunkSlabs  = 8,         // How many slabs to take from the engine heap at once
+		kNoPool      = kPoolClasses, // The pool of a slab that is not in use yet
+		kRecordMagic = 0xA110C000 // Marks an allocated block, the low bits hold the pool class
+	};
+
+	enum
+	{
+		kForeign  = -1,           // FindBlock() result for blocks that did not come from here
+		kBadBlock = -2            // FindBlock() result for pointers into a slab that are not a block
+	};
+
+	// An open addressing hash set of addresses
+	struct PtrSet
+	{
+		void** slots;
+		ulong count;
+		ulong mask;               // One less than the number of slots, which is a power of 2
+	};
+
+	void* DoAlloc(ulong size, const char* file, int line);
+	void* DoRealloc(void* ptr, ulong size, const char* file, int line);
+	void DoFree(void* ptr, const char* file, int line);
+	void* HeapAlloc(ulong size, const char* file, int line);
+	void* HeapRealloc(void* ptr, ulong size, const char* file, int line);
+	void HeapFree(void* ptr, const char* file, int line);
+	bool RefillPool(int pool);
+	bool AddChunk(void);
+
+	int FindBlock(void* ptr) const;
+	static ulong SetHash(const void* ptr);
+	static bool SetFind(const PtrSet& set, const void* ptr);
+	bool SetInsert(PtrSet& set, void* ptr);
+	static void SetErase(PtrSet& set, void* ptr);
+	void SetRelease(PtrSet& set);
+
+	void Counted(int cls, ulong size);
+	void Uncounted(int cls, ulong size);
+
 	IMalloc* m_alloc;
-	AllocRecord* m_recordhead;
+	AllocRecord* m_freelist[kPoolClasses];
+	PtrSet m_slabset;         // Every slab carved from a chunk
+	PtrSet m_heapset;         // The headers of the heap blocks
+	PoolChunk* m_chunks;
+	PoolSlab* m_spareslabs;   // Slabs not given to a pool yet
+	ulong m_poolblocks;
+	Stats m_stats;
 #ifdef DEBUG
 	IDebugMalloc* m_dballoc;
-	ulong m_numallocs;
-	ulong m_grosstotal;
 	char* m_module;
 #endif
 
-	struct AllocRecord
+	// The header in front of every block. While a pool block is free,
+	// next links it into its pool's free list instead, and tag is 0.
+	// Rounded up to the alignment, so the block after it is aligned too.
+	struct alignas(kAlign) AllocRecord
 	{
-		AllocRecord* next;
-		ulong size;
-
-		AllocRecord()
+		union
 		{
-			next = this;
-			size = 0;
-		}
-
-		void insert(AllocRecord** head)
-		{
-			next = *head;
-			*head = this;
-		}
+			ulong size;
+			AllocRecord* next;
+		};
+		ulong tag;
+	};
 
-		bool remove(AllocRecord** head)
-		{
-			AllocRecord *rec;
-			for (rec = *head;
-				 rec->next != rec;
-				 head = &rec->next, rec = rec->next)
-			{
-				if (rec == this)
-				{
-					(*head) = rec->next;
-					return true;
-				}
-			}
-			return false;
-		}
-
-		AllocRecord* find(AllocRecord* rec)
-		{
-			for (; rec->next != rec; rec = rec->next)
-			{
-				if (rec == this)
-					return this;
-			}
-			return NULL;
-		}
+	// The header in front of each slab. Rounded up to the alignment, so
+	// the records after it, and hence the blocks, are aligned too.
+	struct alignas(kAlign) PoolSlab
+	{
+		ulong pool;
+		PoolSlab* next;       // The next spare slab, while this one is spare
+	};
 
+	// The header in front of each chunk of slabs
+	struct PoolChunk
+	{
+		PoolChunk* next;
 	};
 
-	static AllocRecord nullrecord;
+	// Are the pool sizes from the specified one up all multiples of kAlign?
+	static constexpr bool PoolSizesAligned(int pool)
+	{
+		return pool == kPoolClasses || (sm_poolsize[pool] % kAlign == 0 && PoolSizesAligned(pool + 1));
+	}
+
+	static constexpr ulong sm_poolsize[kPoolClasses] = {
+		16, 32, 48, 64, 80, 96, 128, 160, 192, 256
+	};
+	static const unsigned char sm_poolclass[kPoolMax/8 + 1];
+	static bool sm_destroyed;
 
 };
 
@@ -7,17 +7,14 @@
  *  TWTrapAIBreath Implementation - protected members
  */
 
-void TWTrapAIBreath::init(int time)
+void TWTrapAIBreath::init(int time, const DesignNote& design_note)
 {
-    TWBaseTrap::init(time);
+    TWBaseTrap::init(time, design_note);
 
     // AIs generally start off alive, or they wouldn't have this script on them!
     still_alive.Init(1);
 
-    // Fetch the contents of the object's design note
-    char *design_note = GetObjectParams(ObjId());
-
-    if(!design_note) {
+    if(!design_note.is_set()) {
         debug_printf(DL_WARNING, "No Editor -> Design Note. Falling back on defaults.");
 
         // Work out rates based on the base using a simple division
@@ -63,8 +60,6 @@ void TWTrapAIBreath::init(int time)
         if(rooms.value().length() > 0) {
             parse_coldrooms(rooms.value());
         }
-
-        g_pMalloc -> Free(design_note);
     }
 
     if(debug_enabled()) {
@@ -95,36 +90,28 @@ void TWTrapAIBreath::init(int time)
 }
 
 
+TWBaseScript::MessageTable<TWTrapAIBreath> TWTrapAIBreath::handlers(&TWTrapAIBreath::register_handlers);
+
+
+void TWTrapAIBreath::register_handlers(MessageTable<TWTrapAIBreath>& table)
+{
+    table.add<sScrTimerMsg, &TWTrapAIBreath::stop_breath>("Timer");
+    table.add<sTweqMsg, &TWTrapAIBreath::start_breath>("TweqComplete");
+    table.add<sAIAlertnessMsg, &TWTrapAIBreath::on_aialertness>("Alertness");
+    table.add<sRoomMsg, &TWTrapAIBreath::on_objroomtransit>("ObjRoomTransit");
+    table.add<sAIModeChangeMsg, &TWTrapAIBreath::on_aimodechange>("AIModeChange");
+    table.add<sScrMsg, &TWTrapAIBreath::on_slain>("Slain");
+    table.add<sScrMsg, &TWTrapAIBreath::on_ignorepotion>("IgnorePotion");
+}
+
+
 TWBaseScript::MsgStatus TWTrapAIBreath::on_message(sScrMsg* msg, cMultiParm& reply)
 {
     // Call the superclass to let it handle any messages it needs to
     MsgStatus result = TWBaseTrap::on_message(msg, reply);
     if(result != MS_CONTINUE) return result;
 
-    if(!::_stricmp(msg -> message, "Timer")) {
-        return stop_breath(static_cast<sScrTimerMsg*>(msg), reply);
-
-    } else if(!::_stricmp(msg -> message, "TweqComplete")) {
-        return start_breath(static_cast<sTweqMsg*>(msg), reply);
-
-    } else if(!::_stricmp(msg -> message, "Alertness")) {
-        return on_aialertness(static_cast<sAIAlertnessMsg*>(msg), reply);
-
-    } else if(!::_stricmp(msg -> message, "ObjRoomTransit")) {
-        return on_objroomtransit(static_cast<sRoomMsg*>(msg), reply);
-
-    } else if(!::_stricmp(msg -> message, "AIModeChange")) {
-        return on_aimodechange(static_cast<sAIModeChangeMsg*>(msg), reply);
-
-    } else if(!::_stricmp(msg -> message, "Slain")) {
-        return on_slain(msg, reply);
-
-    } else if(!::_stricmp(msg -> message, "IgnorePotion")) {
-        return on_ignorepotion(msg, reply);
-
-    }
-
-    return result;
+    return handlers.dispatch(this, msg, reply);
 }
 
 
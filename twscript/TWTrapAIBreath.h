@@ -100,7 +100,7 @@ protected:
      *  parameters from the design note, and sets up the script so that
      *  it can be used correctly.
      */
-    void init(int time);
+    void init(int time, const DesignNote& design_note);
 
 
     /* ------------------------------------------------------------------------
@@ -120,6 +120,15 @@ protected:
     MsgStatus on_message(sScrMsg* msg, cMultiParm& reply);
 
 
+    /** Register the handlers for the messages this script deals with.
+     *
+     * @param table A reference to the table to register the handlers in.
+     */
+    static void register_handlers(MessageTable<TWTrapAIBreath>& table);
+
+    static MessageTable<TWTrapAIBreath> handlers; //!< The handlers for the messages this script deals with
+
+
     /** On message handler, called whenever the script receives an on message.
      *
      * @param msg   A pointer to the message received by the object.
@@ -9,18 +9,15 @@
  *  Initialisation related
  */
 
-void TWTrapAIEcology::init(int time)
+void TWTrapAIEcology::init(int time, const DesignNote& design_note)
 {
-    TWBaseTrap::init(time);
+    TWBaseTrap::init(time, design_note);
 
     // Make sure the population count is set up correctly
     population.Init(0);
     spawned.Init(0);
 
-    // Fetch the contents of the object's design note
-    char *design_note = GetObjectParams(ObjId());
-
-    if(design_note) {
+    if(design_note.is_set()) {
         // How often should the ecology update?
         refresh.init(design_note, 30000);
 
@@ -47,8 +44,6 @@ void TWTrapAIEcology::init(int time)
         // Set up the name of the qvar to store the population and spawn count in
         pop_qvar.init(design_note);
         spawned_qvar.init(design_note);
-
-        g_pMalloc -> Free(design_note);
     } else {
         debug_printf(DL_WARNING, "No Editor -> Design Note. Falling back on defaults.");
 
@@ -63,12 +58,15 @@ void TWTrapAIEcology::init(int time)
         spawnpoint_link.init("", "&#Weighted");
     }
 
+    // The qvar names are interned once here, so updates don't need to look them up
     if(pop_qvar.is_set()) {
-        set_qvar(pop_qvar.value(), population);
+        pop_qvar_handle = intern_qvar(pop_qvar.value());
+        set_qvar(pop_qvar_handle, population);
     }
 
     if(spawned_qvar.is_set()) {
-        set_qvar(spawned_qvar.value(), spawned);
+        spawned_qvar_handle = intern_qvar(spawned_qvar.value());
+        set_qvar(spawned_qvar_handle, spawned);
     }
 
     // If the ecology is active, start it going
@@ -96,21 +94,24 @@ void TWTrapAIEcology::init(int time)
  *  Message handling
  */
 
+TWBaseScript::MessageTable<TWTrapAIEcology> TWTrapAIEcology::handlers(&TWTrapAIEcology::register_handlers);
+
+
+void TWTrapAIEcology::register_handlers(MessageTable<TWTrapAIEcology>& table)
+{
+    table.add<sScrTimerMsg, &TWTrapAIEcology::on_timer>("Timer");
+    table.add<sScrMsg, &TWTrapAIEcology::on_despawn>("Despawned");
+    table.add<sScrMsg, &TWTrapAIEcology::on_resetspawned>("ResetSpawned");
+}
+
+
 TWBaseScript::MsgStatus TWTrapAIEcology::on_message(sScrMsg* msg, cMultiParm& reply)
 {
     // Call the superclass to let it handle any messages it needs to
     MsgStatus result = TWBaseTrap::on_message(msg, reply);
     if(result != MS_CONTINUE) return result;
 
-    if(!::_stricmp(msg -> message, "Timer")) {
-        return on_timer(static_cast<sScrTimerMsg*>(msg), reply);
-    } else if(!::_stricmp(msg -> message, "Despawned")) {
-        return on_despawn(msg, reply);
-    } else if(!::_stricmp(msg -> message, "ResetSpawned")) {
-        return on_resetspawned(msg, reply);
-    }
-
-    return result;
+    return handlers.dispatch(this, msg, reply);
 }
 
 
@@ -175,7 +176,7 @@ TWBaseScript::MsgStatus TWTrapAIEcology::on_despawn(sScrMsg* msg, cMultiParm& re
     population = population - 1;
 
     if(pop_qvar.is_set()) {
-        set_qvar(pop_qvar.value(), population);
+        set_qvar(pop_qvar_handle, population);
     }
 
     if(debug_enabled())
@@ -190,7 +191,7 @@ TWBaseScript::MsgStatus TWTrapAIEcology::on_resetspawned(sScrMsg* msg, cMultiPar
     spawned = 0;
 
     if(spawned_qvar.is_set()) {
-        set_qvar(spawned_qvar.value(), 0);
+        set_qvar(spawned_qvar_handle, 0);
     }
 
     if(debug_enabled())
@@ -207,15 +208,15 @@ TWBaseScript::MsgStatus TWTrapAIEcology::on_resetspawned(sScrMsg* msg, cMultiPar
 void TWTrapAIEcology::start_timer(bool immediate)
 {
     stop_timer(); // most of the time this is redundant, but be sure.
-    update_timer = set_timed_message("CheckPop", immediate ? 100 : refresh.value(), kSTM_OneShot);
+    update_timer = set_wheel_timer("CheckPop", immediate ? 100 : refresh.value());
 }
 
 
 void TWTrapAIEcology::stop_timer(void)
 {
     if(update_timer) {
-        cancel_timed_message(update_timer);
-        update_timer.Clear();
+        cancel_wheel_timer(update_timer);
+        update_timer = 0;
     }
 }
 
@@ -262,20 +263,18 @@ int TWTrapAIEcology::select_archetype(sScrMsg *msg)
 {
     // Select the AI archetype to spawn an instance of. Note that this may return more than one
     // potential match, depending on the search term, but only the first archetype will be used
-    std::vector<TargetObj> *archetype = archetype_link.values(msg);
-    std::vector<TargetObj>::iterator it;
+    const TargetList& archetype = archetype_link.view(msg);
+    TargetList::const_iterator it;
 
     int target = 0;
     // Traverse the list looking for the first matched archetype.
-    for(it = archetype -> begin(); it != archetype -> end() && target >= 0; it++) {
+    for(it = archetype.begin(); it != archetype.end() && target >= 0; it++) {
         target = it -> obj_id;
 
         if(debug_enabled())
             debug_printf(DL_DEBUG, "Checking obj %d", it -> obj_id);
     }
 
-    delete archetype;
-
     // If an archetype was located, return it, otherwise 0 to indicate a failure.
     return(target < 0 ? target : 0);
 }
@@ -285,12 +284,12 @@ int TWTrapAIEcology::select_spawnpoint(sScrMsg *msg)
 {
     // Select the spawn point to use. This may return more than one potential match, in
     // which case only the first concrete object will be used.
-    std::vector<TargetObj> *concrete = spawnpoint_link.values(msg);
-    std::vector<TargetObj>::iterator it;
+    const TargetList& concrete = spawnpoint_link.view(msg);
+    TargetList::const_iterator it;
 
     int target = 0;
     // Traverse the list looking for the first matched concrete.
-    for(it = concrete -> begin(); it != concrete -> end() && target <= 0; it++) {
+    for(it = concrete.begin(); it != concrete.end() && target <= 0; it++) {
         target = it -> obj_id;
 
         if(debug_enabled())
@@ -300,8 +299,6 @@ int TWTrapAIEcology::select_spawnpoint(sScrMsg *msg)
         if(target > 0) target = check_spawn_visibility(target);
     }
 
-    delete concrete;
-
     // If a concrete object was located, return it, otherwise 0 to indicate a failure.
     return(target > 0 ? target : 0);
 }
@@ -312,12 +309,8 @@ void TWTrapAIEcology::spawn_ai(int archetype, int spawnpoint)
     SService<IObjectSrv>    obj_srv(g_pScriptManager);
     SService<ISoundScrSrv>  snd_srv(g_pScriptManager);
 
-    if(debug_enabled()) {
-        std::string aname, sname;
-        get_object_namestr(aname, archetype);
-        get_object_namestr(sname, spawnpoint);
-        debug_printf(DL_DEBUG, "Attempting to spawn an instance of %s at %s", aname.c_str(), sname.c_str());
-    }
+    if(debug_enabled())
+        debug_printf(DL_DEBUG, "Attempting to spawn an instance of %s at %s", object_name(archetype), object_name(spawnpoint));
 
     object spawn;
     obj_srv -> BeginCreate(spawn, archetype);
@@ -355,10 +348,7 @@ void TWTrapAIEcology::spawn_ai(int archetype, int spawnpoint)
         // Send a TurnOn to the spawn point so it can do stuff and/or relay it.
         post_message(spawnpoint, "TurnOn");
     } else if(debug_enabled()) {
-        std::string name;
-        get_object_namestr(name, archetype);
-
-        debug_printf(DL_WARNING, "BeginCreate failed to spawn instance of archetype %s", name.c_str());
+        debug_printf(DL_WARNING, "BeginCreate failed to spawn instance of archetype %s", object_name(archetype));
     }
 }
 
@@ -451,10 +441,10 @@ void TWTrapAIEcology::increase_spawncount(void)
 
     // If the user has set a qvar to store the population or spawn count in, update it.
     if(pop_qvar.is_set()) {
-        set_qvar(pop_qvar.value(), pop);
+        set_qvar(pop_qvar_handle, pop);
     }
     if(spawned_qvar.is_set()) {
-        set_qvar(spawned_qvar.value(), spawn);
+        set_qvar(spawned_qvar_handle, spawn);
     }
 }
 
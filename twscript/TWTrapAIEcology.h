@@ -53,13 +53,14 @@ public:
                                                     allow_visible_spawn(object, name, "VisibleSpawn"),
                                                     pop_qvar           (object, name, "PopulationQVar"),
                                                     spawned_qvar       (object, name, "SpawnCountQVar"),
+                                                    pop_qvar_handle(0), spawned_qvar_handle(0),
                                                     archetype_link     (object, name, "AILink"),
                                                     spawnpoint_link    (object, name, "SpawnLink"),
 
                                                     SCRIPT_VAROBJ(TWTrapAIEcology, enabled, object),
                                                     SCRIPT_VAROBJ(TWTrapAIEcology, population, object),
                                                     SCRIPT_VAROBJ(TWTrapAIEcology, spawned, object),
-                                                    SCRIPT_VAROBJ(TWTrapAIEcology, update_timer, object)
+                                                    update_timer(0)
         { /* fnord */ }
 
 protected:
@@ -71,7 +72,7 @@ protected:
      *  parameters from the design note, and sets up the script so that
      *  it can be used correctly.
      */
-    void init(int time);
+    void init(int time, const DesignNote& design_note);
 
 
     /* ------------------------------------------------------------------------
@@ -91,6 +92,15 @@ protected:
     MsgStatus on_message(sScrMsg* msg, cMultiParm& reply);
 
 
+    /** Register the handlers for the messages this script deals with.
+     *
+     * @param table A reference to the table to register the handlers in.
+     */
+    static void register_handlers(MessageTable<TWTrapAIEcology>& table);
+
+    static MessageTable<TWTrapAIEcology> handlers; //!< The handlers for the messages this script deals with
+
+
     /** Handle 'turn on' messages received by the script. This is invoked when
      *  the script receives the message it interprets as a 'turn on' instruction
      *  (TurnOn by default).
@@ -311,6 +321,8 @@ private:
 
     DesignParamString pop_qvar;            //!< The name of the qvar to store the current population of spawned AIs.
     DesignParamString spawned_qvar;        //!< The name of the qvar to store the total number of spawned AIs.
+    QVarHandle        pop_qvar_handle;     //!< The interned name of the population qvar, if pop_qvar is set.
+    QVarHandle        spawned_qvar_handle; //!< The interned name of the spawn count qvar, if spawned_qvar is set.
 
     DesignParamTarget archetype_link;      //!< The string to use as a linkdef when searching for the archetype to spawn.
     DesignParamTarget spawnpoint_link;     //!< The string to use as a linkdef when searching for spawn points.
@@ -318,7 +330,7 @@ private:
     script_int               enabled;      //!< Is the ecology enabled?
     script_int               population;   //!< The number of currently spawned AIs
     script_int               spawned;      //!< The number of AIs spawned from the start.
-    script_handle<tScrTimer> update_timer; //!< A timer used to update the ecology.
+    TimerWheel::Timer        update_timer; //!< A timer used to update the ecology.
 };
 
 #else // SCR_GENSCRIPTS
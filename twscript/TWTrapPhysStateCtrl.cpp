@@ -7,23 +7,17 @@
  *  TWTrapPhysStateCtrl Impmementation - protected members
  */
 
-void TWTrapPhysStateCtrl::init(int time)
+void TWTrapPhysStateCtrl::init(int time, const DesignNote& design_note)
 {
-    TWBaseTrap::init(time);
+    TWBaseTrap::init(time, design_note);
 
-    // Fetch the contents of the object's design note
-    char *design_note = GetObjectParams(ObjId());
-
-    if(!design_note) {
+    if(!design_note.is_set()) {
         debug_printf(DL_WARNING, "No Editor -> Design Note. Nothing will happen!");
     } else {
-
         location.init(design_note);
         facing.init(design_note);
         velocity.init(design_note);
         rotvel.init(design_note);
-
-        g_pMalloc -> Free(design_note);
     }
 
     if(debug_enabled()) {
@@ -111,11 +105,10 @@ int TWTrapPhysStateCtrl::set_state(ILinkSrv*, ILinkQuery* link_query, IScript* s
     object target_obj = current_link.dest; // For readability
 
     // Names are only needed for debugging, but meh.
-    std::string target_name;
-    static_cast<TWTrapPhysStateCtrl *>(script) -> get_object_namestr(target_name, target_obj);
+    const char* target_name = static_cast<TWTrapPhysStateCtrl *>(script) -> object_name(target_obj);
 
     if(static_cast<TWTrapPhysStateCtrl *>(script) -> debug_enabled())
-        static_cast<TWTrapPhysStateCtrl *>(script) -> debug_printf(DL_DEBUG, "Setting state of %s", target_name.c_str());
+        TW_DEBUG_PRINTF(static_cast<TWTrapPhysStateCtrl *>(script), DL_DEBUG, "Setting state of %s", target_name);
 
     // Obtain the current location and orientation - both are needed, even if one is being updated,
     // so that teleport will work
@@ -128,14 +121,14 @@ int TWTrapPhysStateCtrl::set_state(ILinkSrv*, ILinkQuery* link_query, IScript* s
     if(state_data -> set_location) {
         position = state_data -> location;
         if(static_cast<TWTrapPhysStateCtrl *>(script) -> debug_enabled())
-            static_cast<TWTrapPhysStateCtrl *>(script) -> debug_printf(DL_DEBUG, "Setting Location of %s to X: %.3f Y: %.3f Z: %.3f", target_name.c_str(), position.x, position.y, position.z);
+            TW_DEBUG_PRINTF(static_cast<TWTrapPhysStateCtrl *>(script), DL_DEBUG, "Setting Location of %s to X: %.3f Y: %.3f Z: %.3f", target_name, position.x, position.y, position.z);
     }
 
     // And the orientation
     if(state_data -> set_facing) {
         facing = state_data -> facing;
         if(static_cast<TWTrapPhysStateCtrl *>(script) -> debug_enabled())
-            static_cast<TWTrapPhysStateCtrl *>(script) -> debug_printf(DL_DEBUG, "Setting Facing of %s to H: %.3f P: %.3f B: %.3f", target_name.c_str(), facing.z, facing.y, facing.x);
+            TW_DEBUG_PRINTF(static_cast<TWTrapPhysStateCtrl *>(script), DL_DEBUG, "Setting Facing of %s to H: %.3f P: %.3f B: %.3f", target_name, facing.z, facing.y, facing.x);
     }
 
     // Move and orient the object
@@ -150,7 +143,7 @@ int TWTrapPhysStateCtrl::set_state(ILinkSrv*, ILinkQuery* link_query, IScript* s
             prop_srv -> Set(target_obj, "PhysState", "Velocity", prop);
 
             if(static_cast<TWTrapPhysStateCtrl *>(script) -> debug_enabled())
-                static_cast<TWTrapPhysStateCtrl *>(script) -> debug_printf(DL_DEBUG, "Setting Velocity of %s to X: %.3f Y: %.3f Z: %.3f", target_name.c_str(), state_data -> velocity.x, state_data -> velocity.y, state_data -> velocity.z);
+                TW_DEBUG_PRINTF(static_cast<TWTrapPhysStateCtrl *>(script), DL_DEBUG, "Setting Velocity of %s to X: %.3f Y: %.3f Z: %.3f", target_name, state_data -> velocity.x, state_data -> velocity.y, state_data -> velocity.z);
         }
 
         if(state_data -> set_rotvel) {
@@ -158,11 +151,11 @@ int TWTrapPhysStateCtrl::set_state(ILinkSrv*, ILinkQuery* link_query, IScript* s
             prop_srv -> Set(target_obj, "PhysState", "Rot Velocity", prop);
 
             if(static_cast<TWTrapPhysStateCtrl *>(script) -> debug_enabled())
-                static_cast<TWTrapPhysStateCtrl *>(script) -> debug_printf(DL_DEBUG, "Setting Rot Velocity of %s to H: %.3f P: %.3f B: %.3f", target_name.c_str(), state_data -> rotvel.z, state_data -> rotvel.y, state_data -> rotvel.x);
+                TW_DEBUG_PRINTF(static_cast<TWTrapPhysStateCtrl *>(script), DL_DEBUG, "Setting Rot Velocity of %s to H: %.3f P: %.3f B: %.3f", target_name, state_data -> rotvel.z, state_data -> rotvel.y, state_data -> rotvel.x);
         }
 
     } else if(static_cast<TWTrapPhysStateCtrl *>(script) -> debug_enabled()) {
-        static_cast<TWTrapPhysStateCtrl *>(script) -> debug_printf(DL_DEBUG, "%s has no PhysState property. This should not happen!", target_name.c_str());
+        TW_DEBUG_PRINTF(static_cast<TWTrapPhysStateCtrl *>(script), DL_DEBUG, "%s has no PhysState property. This should not happen!", target_name);
     }
 
     return 1;
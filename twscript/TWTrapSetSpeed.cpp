@@ -5,14 +5,11 @@
  *  TWTrapSetSpeed Impmementation - protected members
  */
 
-void TWTrapSetSpeed::init(int time)
+void TWTrapSetSpeed::init(int time, const DesignNote& design_note)
 {
-    TWBaseTrap::init(time);
+    TWBaseTrap::init(time, design_note);
 
-    // Fetch the contents of the object's design note
-    char *design_note = GetObjectParams(ObjId());
-
-    if(!design_note) {
+    if(!design_note.is_set()) {
         debug_printf(DL_WARNING, "No Editor -> Design Note. Falling back on defaults.");
     } else {
         // Watch for QVar changes?
@@ -27,8 +24,6 @@ void TWTrapSetSpeed::init(int time)
 
         // And targetting
         set_target.init(design_note, "[me]");
-
-        g_pMalloc -> Free(design_note);
     }
 
     // If debugging is enabled, print some Helpful Information
@@ -47,8 +42,10 @@ TWBaseScript::MsgStatus TWTrapSetSpeed::on_message(sScrMsg* msg, cMultiParm& rep
     MsgStatus result = TWBaseTrap::on_message(msg, reply);
     if(result != MS_CONTINUE) return result;
 
+    MsgAtom atom = message_atom();
+
     // Remove the qvar subscription during shutdown
-    if(!::_stricmp(msg -> message, "EndScript")) {
+    if(atom == MSG_ENDSCRIPT) {
         if(subscribe.value()) {
             if(debug_enabled())
                 debug_printf(DL_DEBUG, "Removing subscription to qvars");
@@ -57,7 +54,7 @@ TWBaseScript::MsgStatus TWTrapSetSpeed::on_message(sScrMsg* msg, cMultiParm& rep
         }
 
     // Handle updates on quest variable change
-    } else if(!::_stricmp(msg -> message, "QuestChange")) {
+    } else if(atom == MSG_QUESTCHANGE) {
         return on_questchange(static_cast<sQuestMsg *>(msg), reply);
     }
 
@@ -120,28 +117,20 @@ void TWTrapSetSpeed::update_speed(sScrMsg* msg)
     if(debug_enabled())
         debug_printf(DL_DEBUG, "Looking up targets matched by %s.", set_target.c_str());
 
-    std::vector<TargetObj>* targets = set_target.values(msg);
+    const TargetList& targets = set_target.view(msg);
 
-    if(targets) {
-        if(!targets -> empty()) {
-            // Process the target list, setting the speeds accordingly
-            std::vector<TargetObj>::iterator it;
-            std::string targ_name;
+    if(!targets.empty()) {
+        // Process the target list, setting the speeds accordingly
+        TargetList::const_iterator it;
 
-            for(it = targets -> begin() ; it != targets -> end(); it++) {
-                set_tpath_speed(it -> obj_id);
+        for(it = targets.begin() ; it != targets.end(); it++) {
+            set_tpath_speed(it -> obj_id);
 
-                if(debug_enabled()) {
-                    get_object_namestr(targ_name, it -> obj_id);
-                    debug_printf(DL_DEBUG, "Setting speed %.3f on %s.", set_speed, targ_name.c_str());
-                }
-            }
-        } else {
-            debug_printf(DL_WARNING, "Dest '%s' did not match any objects.", set_target.c_str());
+            if(debug_enabled())
+                debug_printf(DL_DEBUG, "Setting speed %.3f on %s.", set_speed, object_name(it -> obj_id));
         }
-
-        // And clean up
-        delete targets;
+    } else {
+        debug_printf(DL_WARNING, "Dest '%s' did not match any objects.", set_target.c_str());
     }
 
     // And now update any moving terrain objects linked to this one via ScriptParams with data set to "SetSpeed"
@@ -179,11 +168,8 @@ int TWTrapSetSpeed::set_mterr_speed(ILinkSrv*, ILinkQuery* link_query, IScript*
     // For readability
     object mterr_obj = current_link.dest;
 
-    if(client -> debug_enabled()) {
-        std::string mterr_name;
-        client -> get_object_namestr(mterr_name, mterr_obj);
-        client -> debug_printf(DL_DEBUG, "setting speed %.3f on %s", client -> set_speed, mterr_name.c_str());
-    }
+    if(client -> debug_enabled())
+        TW_DEBUG_PRINTF(client, DL_DEBUG, "setting speed %.3f on %s", client -> set_speed, client -> object_name(mterr_obj));
 
     // Find out where the moving terrain is headed to
     SInterface<ILinkManager> link_mgr(g_pScriptManager);
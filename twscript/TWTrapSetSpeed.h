@@ -124,7 +124,7 @@ protected:
      *  parameters from the design note, and sets up the script so that
      *  it can be used correctly.
      */
-    void init(int time);
+    void init(int time, const DesignNote& design_note);
 
 
     /* ------------------------------------------------------------------------
@@ -1,4 +1,6 @@
+#include <algorithm>
 #include "TWTriggerAIAware.h"
+#include "ArchetypeCache.h"
 #include "ScriptLib.h"
 
 /* =============================================================================
@@ -9,16 +11,14 @@
  *  Initialisation related
  */
 
-void TWTriggerAIAware::init(int time)
+void TWTriggerAIAware::init(int time, const DesignNote& design_note)
 {
-    TWBaseTrigger::init(time);
-
-    // Fetch the contents of the object's design note
-    char *design_note = GetObjectParams(ObjId());
+    TWBaseTrigger::init(time, design_note);
 
     is_linked.Init(0);
+    is_checking.Init(0);
 
-    if(!design_note) {
+    if(!design_note.is_set()) {
         debug_printf(DL_WARNING, "No Editor -> Design Note. Falling back on defaults.");
 
         refresh.init("", 500);
@@ -26,19 +26,21 @@ void TWTriggerAIAware::init(int time)
         trigger_object.init("", "Garrett");
 
     } else {
-
         refresh.init(design_note, 500);
         trigger_level.init(design_note, 2);
         trigger_object.init(design_note, "");
-
-        g_pMalloc -> Free(design_note);
     }
 
-    if(debug_enabled()) {
-        std::string targ_name;
-        get_object_namestr(targ_name, trigger_object.value());
+    SService<ILinkToolsSrv> link_tools(g_pScriptManager);
+    awareness_flavour = link_tools -> LinkKindNamed("AIAwareness");
+
+    // Timers in the wheel are not saved, so pick up any checks that were
+    // running when the game was saved.
+    if(int(is_checking))
+        start_timer();
 
-        debug_printf(DL_DEBUG, "Initialised trigger level %d, match object '%s', check rate %d", trigger_level.value(), targ_name.c_str(), refresh.value());
+    if(debug_enabled()) {
+        debug_printf(DL_DEBUG, "Initialised trigger level %d, match object '%s', check rate %d", trigger_level.value(), object_name(trigger_object.value()), refresh.value());
     }
 }
 
@@ -46,27 +48,25 @@ void TWTriggerAIAware::init(int time)
  *  Message handling
  */
 
+TWBaseScript::MessageTable<TWTriggerAIAware> TWTriggerAIAware::handlers(&TWTriggerAIAware::register_handlers);
+
+
+void TWTriggerAIAware::register_handlers(MessageTable<TWTriggerAIAware>& table)
+{
+    table.add<sAIAlertnessMsg, &TWTriggerAIAware::on_alertness>("Alertness");
+    table.add<sScrTimerMsg, &TWTriggerAIAware::on_timer>("Timer");
+    table.add<sSlayMsg, &TWTriggerAIAware::on_slain>("Slain");
+    table.add<sScrMsg, &TWTriggerAIAware::on_ignorepotion>("IgnorePotion");
+}
+
+
 TWBaseScript::MsgStatus TWTriggerAIAware::on_message(sScrMsg* msg, cMultiParm& reply)
 {
     // Call the superclass to let it handle any messages it needs to
     MsgStatus result = TWBaseTrigger::on_message(msg, reply);
     if(result != MS_CONTINUE) return result;
 
-    if(!::_stricmp(msg -> message, "Alertness")) {
-        return on_alertness(static_cast<sAIAlertnessMsg*>(msg), reply);
-
-    } else if(!::_stricmp(msg -> message, "Timer")) {
-        return on_timer(static_cast<sScrTimerMsg*>(msg), reply);
-
-    // Make sure death and knockout stops the check
-    } else if(!::_stricmp(msg -> message, "Slain")) {
-        return on_slain(static_cast<sSlayMsg*>(msg), reply);
-
-    } else if(!::_stricmp(msg -> message, "IgnorePotion")) {
-        return on_ignorepotion(msg, reply);
-    }
-
-    return result;
+    return handlers.dispatch(this, msg, reply);
 }
 
 
@@ -80,6 +80,12 @@ TWBaseScript::MsgStatus TWTriggerAIAware::on_alertness(sAIAlertnessMsg* msg, cMu
         if(debug_enabled())
             debug_printf(DL_DEBUG, "Alertness raised above trigger, starting link checks");
 
+        is_checking = 1;
+        check_awareness(msg);
+
+    // Alertness changes while above the trigger level usually mean the AI has
+    // noticed something, so check the links now rather than at the next tick.
+    } else if(msg -> level >= trigger_level.value() && int(is_checking)) {
         check_awareness(msg);
 
     // Is the alertness going down below the trigger level?
@@ -104,6 +110,10 @@ TWBaseScript::MsgStatus TWTriggerAIAware::on_timer(sScrTimerMsg* msg, cMultiParm
 {
     // Only bother doing anything if the timer name is correct.
     if(!::_stricmp(msg -> name, "CheckLinks")) {
+        // Games saved before the timer wheel was used will send one last
+        // engine timer, with no wheel timer set. Checks resume from that.
+        if(!update_timer) is_checking = 1;
+
         check_awareness(msg);
     }
 
@@ -145,33 +155,22 @@ TWBaseScript::MsgStatus TWTriggerAIAware::on_slain(sSlayMsg* msg, cMultiParm& re
 
 void TWTriggerAIAware::check_awareness(sScrMsg* msg)
 {
-    SService<IObjectSrv>     obj_srv(g_pScriptManager);
     SService<ILinkSrv>       link_srv(g_pScriptManager);
-    SInterface<ILinkManager> link_mgr(g_pScriptManager);
-    SService<ILinkToolsSrv>  link_tools(g_pScriptManager);
 
     bool target_linked = false;
 
-    stop_timer(); // most of the time this is redundant, but be sure.
+    // most of the time this is redundant, but be sure.
+    if(update_timer) cancel_wheel_timer(update_timer);
 
     linkset links;
-    link_srv -> GetAll(links, link_tools -> LinkKindNamed("AIAwareness"), ObjId(), 0);
+    link_srv -> GetAll(links, awareness_flavour, ObjId(), 0);
     for(; !target_linked && links.AnyLinksLeft(); links.NextLink()) {
 		sLink link = links.Get();
 
         // Ignore links to objects with too low level
         sAIAwareness* awareness = static_cast<sAIAwareness*>(links.Data());
-        if(awareness -> Level >= static_cast<eAIAwareLevel>(trigger_level.value())) {
-
-            if(trigger_object.value() > 0 && link.dest == trigger_object.value()) {
-                target_linked = true;
-            } else if(trigger_object.value() < 0) {
-                true_bool inherits;
-                obj_srv -> InheritsFrom(inherits, link.dest, trigger_object.value());
-
-                target_linked = (bool)inherits;
-            }
-        }
+        if(awareness -> Level >= static_cast<eAIAwareLevel>(trigger_level.value()))
+            target_linked = is_target(link.dest);
     }
 
     if(debug_enabled())
@@ -185,14 +184,66 @@ void TWTriggerAIAware::check_awareness(sScrMsg* msg)
         send_off_message(msg);
     }
 
-    update_timer = set_timed_message("CheckLinks", refresh.value(), kSTM_OneShot);
+    start_timer();
+}
+
+
+bool TWTriggerAIAware::is_target(const int obj_id)
+{
+    int target = trigger_object.value();
+
+    if(target > 0) return obj_id == target;
+    if(target == 0) return false;
+
+    // Metaproperties can be added to and removed from objects without any
+    // objects being created or destroyed, so the cached descendants of one
+    // would go stale. Ask the game about those every time instead.
+    if(targets_archetype != target) {
+        true_bool is_metaprop;
+        SService<IObjectSrv> ObjectSrv(g_pScriptManager);
+        ObjectSrv -> InheritsFrom(is_metaprop, target, ArchetypeCache::find("MetaProperty"));
+
+        targets_archetype  = target;
+        targets_metaprop   = is_metaprop;
+        targets_generation = 0;
+        targets.clear();
+    }
+
+    if(targets_metaprop) {
+        true_bool inherits;
+        SService<IObjectSrv> ObjectSrv(g_pScriptManager);
+        ObjectSrv -> InheritsFrom(inherits, obj_id, target);
+
+        return inherits;
+    }
+
+    // Archetypes are matched against their concrete descendants, which are
+    // only fetched again when objects are created or destroyed.
+    uint generation = ArchetypeCache::generation();
+    if(targets_generation != generation) {
+        const std::vector<int>& descendants = ArchetypeCache::descendants(target, true);
+
+        targets.assign(descendants.begin(), descendants.end());
+        std::sort(targets.begin(), targets.end());
+        targets_generation = generation;
+    }
+
+    return std::binary_search(targets.begin(), targets.end(), obj_id);
+}
+
+
+void TWTriggerAIAware::start_timer(void)
+{
+    update_timer = set_wheel_timer("CheckLinks", refresh.value());
 }
 
 
 void TWTriggerAIAware::stop_timer(void)
 {
     if(update_timer) {
-        cancel_timed_message(update_timer);
-        update_timer.Clear();
+        cancel_wheel_timer(update_timer);
+        update_timer = 0;
     }
+
+    is_checking = 0;
 }
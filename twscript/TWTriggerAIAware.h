@@ -29,12 +29,21 @@
 #include <lg/properties.h>
 #include <lg/propdefs.h>
 #include <string>
+#include <vector>
 #include "TWBaseScript.h"
 #include "TWBaseTrigger.h"
 
 
 /** @class TWTriggerAIAware
  *
+ * TWTriggerAIAware sends an On message when the AI it is on becomes aware of
+ * a given object (or any concrete descendant of an archetype, or any object
+ * with a metaproperty) while the AI's alertness is at or above a trigger
+ * level, and an Off message when it stops being aware of it, or its
+ * alertness drops.
+ *
+ * While the AI is alert, the AIAwareness links are checked whenever its
+ * alertness changes, and otherwise once every TWTriggerAIAwareRate ms.
  */
 class TWTriggerAIAware : public TWBaseTrigger
 {
@@ -43,7 +52,12 @@ public:
                                                      refresh       (object, name, "Rate"),
                                                      trigger_level (object, name, "Alertness"),
                                                      trigger_object(object, name, "Object"),
-                                                     SCRIPT_VAROBJ(TWTriggerAIAware, update_timer, object),
+                                                     update_timer(0),
+                                                     awareness_flavour(0),
+                                                     targets_generation(0),
+                                                     targets_archetype(0),
+                                                     targets_metaprop(false),
+                                                     SCRIPT_VAROBJ(TWTriggerAIAware, is_checking, object),
                                                      SCRIPT_VAROBJ(TWTriggerAIAware, is_linked, object)
         { /* fnord */ }
 
@@ -56,7 +70,7 @@ protected:
      *  parameters from the design note, and sets up the script so that
      *  it can be used correctly.
      */
-    void init(int time);
+    void init(int time, const DesignNote& design_note);
 
 
     /* ------------------------------------------------------------------------
@@ -76,6 +90,15 @@ protected:
     MsgStatus on_message(sScrMsg* msg, cMultiParm& reply);
 
 
+    /** Register the handlers for the messages this script deals with.
+     *
+     * @param table A reference to the table to register the handlers in.
+     */
+    static void register_handlers(MessageTable<TWTriggerAIAware>& table);
+
+    static MessageTable<TWTriggerAIAware> handlers; //!< The handlers for the messages this script deals with
+
+
     /** Alertness message handler.
      *
      * @param msg   A pointer to the message received by the object.
@@ -121,14 +144,22 @@ protected:
     MsgStatus on_ignorepotion(sScrMsg *msg, cMultiParm& reply);
 
 private:
+    void start_timer(void);
     void stop_timer(void);
+    bool is_target(const int obj_id);
     void check_awareness(sScrMsg* msg);
 
-    DesignParamInt    refresh;             //!< How frequently should the state be updated?
+    DesignParamInt    refresh;             //!< How often to check the links
     DesignParamInt    trigger_level;       //!< The level at which the trigger should fire an On message
     DesignParamTarget trigger_object;      //!< The object (or archetype) that must be linked before the trigger happens
 
-    script_handle<tScrTimer> update_timer; //!< A timer used to update the trigger
+    TimerWheel::Timer        update_timer; //!< A timer used to update the trigger
+    long                     awareness_flavour;  //!< The ID of the AIAwareness link flavour
+    uint                     targets_generation; //!< The archetype cache generation targets was built in
+    int                      targets_archetype;  //!< The archetype targets holds the descendants of
+    bool                     targets_metaprop;   //!< Is targets_archetype a metaproperty, matched with InheritsFrom()?
+    std::vector<int>         targets;      //!< The sorted concrete descendants of an archetype trigger object
+    script_int               is_checking;  //!< Are the links being checked? Needed to restart the timer after a load.
     script_int               is_linked;    //!< Is the target currently linked?
 };
 
@@ -9,14 +9,11 @@
  *  Initialisation related
  */
 
-void TWTriggerAIEcologyDespawn::init(int time)
+void TWTriggerAIEcologyDespawn::init(int time, const DesignNote& design_note)
 {
-    TWBaseTrigger::init(time);
+    TWBaseTrigger::init(time, design_note);
 
-    // Fetch the contents of the object's design note
-    char *design_note = GetObjectParams(ObjId());
-
-    if(!design_note) {
+    if(!design_note.is_set()) {
         debug_printf(DL_WARNING, "No Editor -> Design Note. Falling back on defaults.");
         refresh.init("", 120000);
         visible_despawn.init("", false);
@@ -25,10 +22,14 @@ void TWTriggerAIEcologyDespawn::init(int time)
         // How often should the ecology update?
         refresh.init(design_note, 120000);
         visible_despawn.init(design_note, false);
-
-        g_pMalloc -> Free(design_note);
     }
 
+    // Timers in the wheel are not saved, so restart the despawn if the AI
+    // was slain before the game was saved.
+    despawn_pending.Init(0);
+    if(int(despawn_pending))
+        update_timer = set_wheel_timer("Despawn", refresh.value());
+
     if(debug_enabled()) {
         debug_printf(DL_DEBUG, "Initialised on object. Settings:");
         debug_printf(DL_DEBUG, "Despawn rate %d", refresh.value());
@@ -40,30 +41,38 @@ void TWTriggerAIEcologyDespawn::init(int time)
  *  Message handling
  */
 
+TWBaseScript::MessageTable<TWTriggerAIEcologyDespawn> TWTriggerAIEcologyDespawn::handlers(&TWTriggerAIEcologyDespawn::register_handlers);
+
+
+void TWTriggerAIEcologyDespawn::register_handlers(MessageTable<TWTriggerAIEcologyDespawn>& table)
+{
+    table.add<sScrTimerMsg, &TWTriggerAIEcologyDespawn::on_timer>("Timer");
+    table.add<sSlayMsg, &TWTriggerAIEcologyDespawn::on_slain>("Slain");
+}
+
+
 TWBaseScript::MsgStatus TWTriggerAIEcologyDespawn::on_message(sScrMsg* msg, cMultiParm& reply)
 {
     // Call the superclass to let it handle any messages it needs to
     MsgStatus result = TWBaseTrigger::on_message(msg, reply);
     if(result != MS_CONTINUE) return result;
 
-    if(!::_stricmp(msg -> message, "Timer")) {
-        return on_timer(static_cast<sScrTimerMsg*>(msg), reply);
-    } else if(!::_stricmp(msg -> message, "Slain")) {
-        return on_slain(static_cast<sSlayMsg*>(msg), reply);
-    }
-
-    return result;
+    return handlers.dispatch(this, msg, reply);
 }
 
 
 TWBaseScript::MsgStatus TWTriggerAIEcologyDespawn::on_timer(sScrTimerMsg* msg, cMultiParm& reply)
 {
     if(!::_stricmp(msg -> name, "Despawn")) {
+        // Games saved before the timer wheel was used will send one last
+        // engine timer, with no wheel timer set.
+        if(!update_timer) despawn_pending = 1;
+
         if(!attempt_despawn(msg)) {
             if(debug_enabled())
                 debug_printf(DL_DEBUG, "Re-setting timed despawn");
 
-            update_timer = set_timed_message("Despawn", refresh.value(), kSTM_OneShot);
+            update_timer = set_wheel_timer("Despawn", refresh.value());
         }
     }
 
@@ -78,9 +87,10 @@ TWBaseScript::MsgStatus TWTriggerAIEcologyDespawn::on_slain(sSlayMsg* msg, cMult
         debug_printf(DL_DEBUG, "AI slain, setting timed despawn");
 
     if(update_timer) {
-        cancel_timed_message(update_timer);
+        cancel_wheel_timer(update_timer);
     }
-    update_timer = set_timed_message("Despawn", refresh.value(), kSTM_OneShot);
+    update_timer = set_wheel_timer("Despawn", refresh.value());
+    despawn_pending = 1;
 
     return MS_CONTINUE;
 }
@@ -47,7 +47,8 @@ public:
     TWTriggerAIEcologyDespawn(const char* name, int object) : TWBaseTrigger(name, object),
                                                               refresh(object, name, "Rate"),
                                                               visible_despawn(object, name, "Visible"),
-                                                              SCRIPT_VAROBJ(TWTriggerAIEcologyDespawn, update_timer, object)
+                                                              update_timer(0),
+                                                              SCRIPT_VAROBJ(TWTriggerAIEcologyDespawn, despawn_pending, object)
         { /* fnord */ }
 
 protected:
@@ -59,7 +60,7 @@ protected:
      *  parameters from the design note, and sets up the script so that
      *  it can be used correctly.
      */
-    void init(int time);
+    void init(int time, const DesignNote& design_note);
 
 
     /* ------------------------------------------------------------------------
@@ -79,6 +80,15 @@ protected:
     MsgStatus on_message(sScrMsg* msg, cMultiParm& reply);
 
 
+    /** Register the handlers for the messages this script deals with.
+     *
+     * @param table A reference to the table to register the handlers in.
+     */
+    static void register_handlers(MessageTable<TWTriggerAIEcologyDespawn>& table);
+
+    static MessageTable<TWTriggerAIEcologyDespawn> handlers; //!< The handlers for the messages this script deals with
+
+
     /** Timer message handler, called whenever the script receives a timer message.
      *
      * @param msg   A pointer to the message received by the object.
@@ -112,7 +122,8 @@ private:
 
     DesignParamInt  refresh;               //!< How frequently should the despawn happen after death?
     DesignParamBool visible_despawn;       //!< Allow visible despawn?
-    script_handle<tScrTimer> update_timer; //!< A timer used to despawn the AI
+    TimerWheel::Timer update_timer;        //!< A timer used to despawn the AI
+    script_int      despawn_pending;       //!< Has the AI been slain? Needed to restart the timer after a load
 };
 
 #else // SCR_GENSCRIPTS
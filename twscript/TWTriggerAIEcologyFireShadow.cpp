@@ -9,14 +9,11 @@
  *  Initialisation related
  */
 
-void TWTriggerAIEcologyFireShadow::init(int time)
+void TWTriggerAIEcologyFireShadow::init(int time, const DesignNote& design_note)
 {
-    TWBaseTrigger::init(time);
+    TWBaseTrigger::init(time, design_note);
 
-    // Fetch the contents of the object's design note
-    char *design_note = GetObjectParams(ObjId());
-
-    if(!design_note) {
+    if(!design_note.is_set()) {
         debug_printf(DL_WARNING, "No Editor -> Design Note. Falling back on defaults.");
 
         refresh.init("", 1000);
@@ -30,10 +27,14 @@ void TWTriggerAIEcologyFireShadow::init(int time)
         // parse the timewarp settings
         speed_factor.init(design_note, 0.8125);
         min_timewarp.init(design_note, 0.03);
-
-        g_pMalloc -> Free(design_note);
     }
 
+    // Timers in the wheel are not saved, so restart the speedup and despawn
+    // if the AI was slain before the game was saved.
+    despawn_pending.Init(0);
+    if(int(despawn_pending))
+        update_timer = set_wheel_timer("FireShadow", refresh.value());
+
     if(debug_enabled()) {
         debug_printf(DL_DEBUG, "Initialised on object. Settings:");
         debug_printf(DL_DEBUG, "Speedup rate %d", refresh.value());
@@ -45,34 +46,40 @@ void TWTriggerAIEcologyFireShadow::init(int time)
  *  Message handling
  */
 
+TWBaseScript::MessageTable<TWTriggerAIEcologyFireShadow> TWTriggerAIEcologyFireShadow::handlers(&TWTriggerAIEcologyFireShadow::register_handlers);
+
+
+void TWTriggerAIEcologyFireShadow::register_handlers(MessageTable<TWTriggerAIEcologyFireShadow>& table)
+{
+    table.add<sScrTimerMsg, &TWTriggerAIEcologyFireShadow::on_timer>("Timer");
+    table.add<sSlayMsg, &TWTriggerAIEcologyFireShadow::on_slain>("Slain");
+}
+
+
 TWBaseScript::MsgStatus TWTriggerAIEcologyFireShadow::on_message(sScrMsg* msg, cMultiParm& reply)
 {
     // Call the superclass to let it handle any messages it needs to
     MsgStatus result = TWBaseTrigger::on_message(msg, reply);
     if(result != MS_CONTINUE) return result;
 
-    if(!::_stricmp(msg -> message, "Timer")) {
-        return on_timer(static_cast<sScrTimerMsg*>(msg), reply);
-
-    } else if(!::_stricmp(msg -> message, "Slain")) {
-        return on_slain(static_cast<sSlayMsg*>(msg), reply);
-
-    }
-
-    return result;
+    return handlers.dispatch(this, msg, reply);
 }
 
 
 TWBaseScript::MsgStatus TWTriggerAIEcologyFireShadow::on_timer(sScrTimerMsg* msg, cMultiParm& reply)
 {
     if(!::_stricmp(msg -> name, "FireShadow")) {
+        // Games saved before the timer wheel was used will send one last
+        // engine timer, with no wheel timer set.
+        if(!update_timer) despawn_pending = 1;
+
         speedup();
 
         if(!attempt_despawn(msg)) {
             if(debug_enabled())
                 debug_printf(DL_DEBUG, "Re-setting timed despawn");
 
-            update_timer = set_timed_message("FireShadow", refresh.value(), kSTM_OneShot);
+            update_timer = set_wheel_timer("FireShadow", refresh.value());
         }
     }
 
@@ -86,9 +93,10 @@ TWBaseScript::MsgStatus TWTriggerAIEcologyFireShadow::on_slain(sSlayMsg* msg, cM
         debug_printf(DL_DEBUG, "AI slain, setting up slain behaviour");
 
     if(update_timer) {
-        cancel_timed_message(update_timer);
+        cancel_wheel_timer(update_timer);
     }
-    update_timer = set_timed_message("FireShadow", refresh.value(), kSTM_OneShot);
+    update_timer = set_wheel_timer("FireShadow", refresh.value());
+    despawn_pending = 1;
 
     fireshadow_flee();
 
@@ -42,7 +42,8 @@ public:
                                                                  refresh(object, name, "Rate"),
                                                                  speed_factor(object, name, "Speedup"),
                                                                  min_timewarp(object, name, "MinTimewarp"),
-                                                                 SCRIPT_VAROBJ(TWTriggerAIEcologyFireShadow, update_timer, object)
+                                                                 update_timer(0),
+                                                                 SCRIPT_VAROBJ(TWTriggerAIEcologyFireShadow, despawn_pending, object)
         { /* fnord */ }
 
 protected:
@@ -54,7 +55,7 @@ protected:
      *  parameters from the design note, and sets up the script so that
      *  it can be used correctly.
      */
-    void init(int time);
+    void init(int time, const DesignNote& design_note);
 
 
     /* ------------------------------------------------------------------------
@@ -74,6 +75,15 @@ protected:
     MsgStatus on_message(sScrMsg* msg, cMultiParm& reply);
 
 
+    /** Register the handlers for the messages this script deals with.
+     *
+     * @param table A reference to the table to register the handlers in.
+     */
+    static void register_handlers(MessageTable<TWTriggerAIEcologyFireShadow>& table);
+
+    static MessageTable<TWTriggerAIEcologyFireShadow> handlers; //!< The handlers for the messages this script deals with
+
+
     /** Timer message handler, called whenever the script receives a timer message.
      *
      * @param msg   A pointer to the message received by the object.
@@ -126,7 +136,8 @@ private:
     DesignParamInt   refresh;        //!< How frequently should the speedup and despawn happen after slay?
     DesignParamFloat speed_factor;   //!< The speedup factor for the fireshadow
     DesignParamFloat min_timewarp;   //!< The minimum timewarp factor.
-    script_handle<tScrTimer> update_timer; //!< A timer used to speedup and despawn the AI
+    TimerWheel::Timer update_timer;    //!< A timer used to speedup and despawn the AI
+    script_int        despawn_pending; //!< Has the AI been slain? Needed to restart the timer after a load.
 };
 
 #else // SCR_GENSCRIPTS
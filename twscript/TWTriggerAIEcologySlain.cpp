@@ -9,9 +9,9 @@
  *  Initialisation related
  */
 
-void TWTriggerAIEcologySlain::init(int time)
+void TWTriggerAIEcologySlain::init(int time, const DesignNote& design_note)
 {
-    TWBaseTrigger::init(time);
+    TWBaseTrigger::init(time, design_note);
 
     if(debug_enabled()) {
         debug_printf(DL_DEBUG, "Initialised on object. Settings:");
@@ -23,17 +23,22 @@ void TWTriggerAIEcologySlain::init(int time)
  *  Message handling
  */
 
+TWBaseScript::MessageTable<TWTriggerAIEcologySlain> TWTriggerAIEcologySlain::handlers(&TWTriggerAIEcologySlain::register_handlers);
+
+
+void TWTriggerAIEcologySlain::register_handlers(MessageTable<TWTriggerAIEcologySlain>& table)
+{
+    table.add<sSlayMsg, &TWTriggerAIEcologySlain::on_slain>("Slain");
+}
+
+
 TWBaseScript::MsgStatus TWTriggerAIEcologySlain::on_message(sScrMsg* msg, cMultiParm& reply)
 {
     // Call the superclass to let it handle any messages it needs to
     MsgStatus result = TWBaseTrigger::on_message(msg, reply);
     if(result != MS_CONTINUE) return result;
 
-    if(!::_stricmp(msg -> message, "Slain")) {
-        return on_slain(static_cast<sSlayMsg*>(msg), reply);
-    }
-
-    return result;
+    return handlers.dispatch(this, msg, reply);
 }
 
 
@@ -56,7 +56,7 @@ protected:
      *  parameters from the design note, and sets up the script so that
      *  it can be used correctly.
      */
-    void init(int time);
+    void init(int time, const DesignNote& design_note);
 
 
     /* ------------------------------------------------------------------------
@@ -76,6 +76,15 @@ protected:
     MsgStatus on_message(sScrMsg* msg, cMultiParm& reply);
 
 
+    /** Register the handlers for the messages this script deals with.
+     *
+     * @param table A reference to the table to register the handlers in.
+     */
+    static void register_handlers(MessageTable<TWTriggerAIEcologySlain>& table);
+
+    static MessageTable<TWTriggerAIEcologySlain> handlers; //!< The handlers for the messages this script deals with
+
+
     /** Slain message handler, called whenever the script receives a slain message.
      *
      * @param msg   A pointer to the message received by the object.
@@ -1,20 +1,261 @@
 #include <lg/propdefs.h>
 #include <lg/iids.h>
+#include <vector>
 #include "TWTriggerVisible.h"
 #include "ScriptLib.h"
 
+namespace {
+    /** A group of TWTriggerVisible instances that check their light rating at
+     *  the same rate. The objects and their lit state are held in parallel
+     *  arrays so that the sweep over them is a tight loop, and only the driver,
+     *  the instance that holds the group's timer, gets a timer message. The
+     *  thresholds may come from qvars, so they are not copied here, but asked
+     *  for on every sweep.
+     */
+    struct VisibilitySweep {
+        uint                           rate;       //!< How often the group is checked, in milliseconds
+        TWTriggerVisible*              driver;     //!< The instance the group's timer is set for
+        int                            driver_obj; //!< The object the driver is on
+        TimerWheel::Timer              timer;      //!< The group's timer, 0 if none is set
+        std::vector<int>               obj_ids;    //!< The objects the instances are on
+        std::vector<char>              lit;        //!< Is each object currently lit?
+        std::vector<TWTriggerVisible*> scripts;    //!< The instances themselves
+    };
+
+    /** An instance whose lit state a sweep has found needs to change.
+     */
+    struct Change {
+        TWTriggerVisible* script; //!< The instance to send CheckVis to
+        int               obj_id; //!< The object the instance is on
+        int               light;  //!< The light rating the sweep read
+    };
+
+    typedef std::vector<Change> ChangeList;
+
+
+    /** An instance whose rate no longer matches the group it is in.
+     */
+    struct Move {
+        TWTriggerVisible* script; //!< The instance to move
+        int               obj_id; //!< The object the instance is on
+        uint              rate;   //!< The instance's new rate
+        bool              lit;    //!< Is the object currently lit?
+    };
+
+    typedef std::vector<Move> MoveList;
+
+    std::vector<VisibilitySweep> sweeps;
+    ChangeList                   changes; //!< The instances a sweep needs to send CheckVis to, kept to avoid reallocating it
+    MoveList                     moves;   //!< The instances a sweep needs to move to another group, kept for the same reason
+
+    const char* const SWEEP_TIMER = "VisSweep"; //!< The name of the timer that drives a sweep
+
+
+    /** Set the group's timer for its driver.
+     */
+    void schedule_sweep(VisibilitySweep& sweep, const uint now)
+    {
+        sweep.timer = TimerWheel::schedule(sweep.driver, sweep.driver_obj, SWEEP_TIMER, now, sweep.rate);
+    }
+
+
+    /** Remove an instance from the sweep it is in, if any. If it was the
+     *  driver of its group, the group's timer is handed to another instance.
+     *  Any CheckVis a running sweep has yet to send it is dropped.
+     *
+     * @param script The instance to remove.
+     * @param now    The current sim time.
+     * @param rearm  Set a timer for the new driver? This should be false if
+     *               the game may be shutting the scripts down.
+     */
+    void remove_from_sweep(TWTriggerVisible* script, const uint now, const bool rearm)
+    {
+        int group = script -> get_sweep_group();
+        if(group < 0) return;
+
+        VisibilitySweep& sweep = sweeps[group];
+        size_t pos = script -> get_sweep_index();
+
+        // Order doesn't matter, so fill the gap with the last instance
+        size_t last = sweep.scripts.size() - 1;
+        sweep.obj_ids[pos] = sweep.obj_ids[last]; sweep.obj_ids.pop_back();
+        sweep.lit[pos]     = sweep.lit[last];     sweep.lit.pop_back();
+        sweep.scripts[pos] = sweep.scripts[last]; sweep.scripts.pop_back();
+        if(pos != last) sweep.scripts[pos] -> set_sweep_slot(group, pos);
+
+        script -> set_sweep_slot(-1, 0);
+
+        // The change list is only filled while a sweep is sending messages,
+        // so this is almost always empty
+        for(ChangeList::iterator change = changes.begin(); change != changes.end(); ++change) {
+            if(change -> script == script) change -> script = NULL;
+        }
+
+        if(sweep.driver == script) {
+            TimerWheel::cancel(sweep.timer);
+            sweep.timer  = 0;
+            sweep.driver = NULL;
+
+            if(!sweep.scripts.empty()) {
+                sweep.driver     = sweep.scripts[0];
+                sweep.driver_obj = sweep.obj_ids[0];
+                if(rearm) schedule_sweep(sweep, now);
+            }
+        }
+    }
+
+
+    /** Get the lit state the sweep holds for an instance.
+     *
+     * @return A pointer to the instance's lit state, or NULL if the instance
+     *         is not in a sweep.
+     */
+    char* sweep_lit(const TWTriggerVisible* script)
+    {
+        int group = script -> get_sweep_group();
+        if(group < 0) return NULL;
+
+        return &sweeps[group].lit[script -> get_sweep_index()];
+    }
+
+
+    /** Add an instance to the sweep for its rate, starting a new group if no
+     *  other instance uses that rate.
+     */
+    void add_to_sweep(TWTriggerVisible* script, const int obj_id, const uint rate, const bool lit, const uint now)
+    {
+        remove_from_sweep(script, now, true);
+
+        size_t group = 0;
+        while(group < sweeps.size() && sweeps[group].rate != rate) ++group;
+
+        if(group == sweeps.size()) {
+            sweeps.push_back(VisibilitySweep());
+            sweeps[group].rate       = rate;
+            sweeps[group].driver     = NULL;
+            sweeps[group].driver_obj = 0;
+            sweeps[group].timer      = 0;
+        }
+
+        VisibilitySweep& sweep = sweeps[group];
+        script -> set_sweep_slot(int(group), sweep.scripts.size());
+        sweep.obj_ids.push_back(obj_id);
+        sweep.lit.push_back(lit);
+        sweep.scripts.push_back(script);
+
+        // The group may have lost its timer when its last driver was destroyed
+        if(!sweep.timer) {
+            sweep.driver     = script;
+            sweep.driver_obj = obj_id;
+            schedule_sweep(sweep, now);
+        }
+    }
+
+
+    /** Read the light rating of every object in the group the specified
+     *  instance drives, and send CheckVis to the instances whose lit state
+     *  needs to change, with the light rating as the timer data. Instances
+     *  whose rate has changed are moved to the group for their new rate
+     *  instead, and checked there.
+     *
+     * @return false if the instance does not drive a group.
+     */
+    bool run_sweep(TWTriggerVisible* driver, const uint now)
+    {
+        int group = driver -> get_sweep_group();
+        if(group < 0 || sweeps[group].driver != driver) return false;
+
+        // Collect the changes first, as the messages may add or remove instances
+        changes.clear();
+        moves.clear();
+        {
+            VisibilitySweep& sweep = sweeps[group];
+            SService<IPropertySrv> prop_serv(g_pScriptManager);
+
+            size_t count = sweep.obj_ids.size();
+            for(size_t pos = 0; pos < count; ++pos) {
+                TWTriggerVisible* script = sweep.scripts[pos];
+
+                uint rate = script -> get_refresh();
+                if(rate != sweep.rate) {
+                    Move move = { script, sweep.obj_ids[pos], rate, sweep.lit[pos] != 0 };
+                    moves.push_back(move);
+                    continue;
+                }
+
+                if(!prop_serv -> Possessed(sweep.obj_ids[pos], "AI_Visibility")) continue;
+
+                cMultiParm light;
+                prop_serv -> Get(light, sweep.obj_ids[pos], "AI_Visibility", "Light rating");
+
+                int rating = int(light);
+                if((sweep.lit[pos] && rating < script -> get_low_threshold()) || (!sweep.lit[pos] && rating > script -> get_high_threshold())) {
+                    sweep.lit[pos] = !sweep.lit[pos];
+                    Change change = { script, sweep.obj_ids[pos], rating };
+                    changes.push_back(change);
+                }
+            }
+
+            schedule_sweep(sweep, now);
+        }
+
+        // This can change the driver and reallocate the groups, so it has to
+        // wait until the sweep is done with
+        for(MoveList::iterator move = moves.begin(); move != moves.end(); ++move) {
+            add_to_sweep(move -> script, move -> obj_id, move -> rate, move -> lit, now);
+        }
+
+        // Sweeps are only run from the timer wheel, which never nests, but the
+        // messages could end instances that have yet to be told, in which case
+        // remove_from_sweep() will have cleared them from the list
+        for(size_t pos = 0; pos < changes.size(); ++pos) {
+            Change* change = &changes[pos];
+            if(!change -> script) continue;
+
+            sScrTimerMsg msg;
+            cMultiParm   reply;
+
+            // The game's message structures do not initialise themselves, so
+            // everything a script might look at needs to be filled in here.
+            msg.from    = msg.to = change -> obj_id;
+            msg.message = "Timer";
+            msg.time    = now;
+            msg.flags   = 0;
+            msg.data    = change -> light;
+            msg.data2   = cMultiParm();
+            msg.data3   = cMultiParm();
+            msg.name    = "CheckVis";
+
+            change -> script -> ReceiveMessage(&msg, &reply, kNoAction);
+        }
+        changes.clear();
+
+        return true;
+    }
+}
+
+
 /* =============================================================================
- *  TWTriggerVisible Implementation - protected members
+ *  TWTriggerVisible Implementation - public members
  */
 
-void TWTriggerVisible::init(int time)
+TWTriggerVisible::~TWTriggerVisible()
 {
-    TWBaseTrigger::init(time);
+    // The game may be shutting every script down, so there is no point in
+    // moving the sweep's timer to another instance.
+    remove_from_sweep(this, 0, false);
+}
+
 
-    // Fetch the contents of the object's design note
-    char *design_note = GetObjectParams(ObjId());
+/* =============================================================================
+ *  TWTriggerVisible Implementation - protected members
+ */
 
-    if(!design_note) {
+void TWTriggerVisible::init(int time, const DesignNote& design_note)
+{
+    TWBaseTrigger::init(time, design_note);
+
+    if(!design_note.is_set()) {
         debug_printf(DL_WARNING, "No Editor -> Design Note. Falling back on defaults.");
 
         lowlight_threshold.init("", 35);
@@ -27,8 +268,6 @@ void TWTriggerVisible::init(int time)
         lowlight_threshold.init(design_note, 35);
         highlight_threshold.init(design_note, 55);
         refresh.init(design_note, 500);
-
-        g_pMalloc -> Free(design_note);
     }
 
     if(debug_enabled()) {
@@ -36,12 +275,20 @@ void TWTriggerVisible::init(int time)
         debug_printf(DL_DEBUG, "Update rate set to %dms", refresh.value());
     }
 
-    if(update_timer) {
-        cancel_timed_message(update_timer);
-    }
+    // And join the sweep for this rate. Sweeps are not saved, so this is
+    // needed after a load as well as when the script first starts, and the
+    // lit state is restored from the copy saved with the game.
+    add_to_sweep(this, ObjId(), get_refresh(), int(is_litup) != 0, time);
+}
+
 
-    // And schedule the next update.
-    update_timer = set_timed_message("CheckVis", refresh, kSTM_OneShot);
+TWBaseScript::MessageTable<TWTriggerVisible> TWTriggerVisible::handlers(&TWTriggerVisible::register_handlers);
+
+
+void TWTriggerVisible::register_handlers(MessageTable<TWTriggerVisible>& table)
+{
+    table.add<sScrTimerMsg, &TWTriggerVisible::on_timer>("Timer");
+    table.add<sScrMsg, &TWTriggerVisible::on_endscript>("EndScript");
 }
 
 
@@ -51,51 +298,78 @@ TWBaseScript::MsgStatus TWTriggerVisible::on_message(sScrMsg* msg, cMultiParm& r
     MsgStatus result = TWBaseScript::on_message(msg, reply);
     if(result != MS_CONTINUE) return result;
 
-    if(!::_stricmp(msg -> message, "Timer")) {
-        return on_timer(static_cast<sScrTimerMsg*>(msg), reply);
-    }
-
-    return result;
+    return handlers.dispatch(this, msg, reply);
 }
 
 
 TWBaseScript::MsgStatus TWTriggerVisible::on_timer(sScrTimerMsg *msg, cMultiParm& reply)
 {
     // Only bother doing anything if the timer name is correct.
-    if(!::_stricmp(msg -> name, "CheckVis")) {
-        check_visible(msg);
+    if(!::_stricmp(msg -> name, SWEEP_TIMER)) {
+        run_sweep(this, msg -> time);
 
-        update_timer = set_timed_message("CheckVis", refresh, kSTM_OneShot);
+    } else if(!::_stricmp(msg -> name, "CheckVis")) {
+        // The sweep has already updated the lit state, and passes the light
+        // rating it read along. Games saved before the sweep was used may send
+        // one last engine timer without it.
+        if(msg -> data.type == kMT_Int) {
+            const char* lit = sweep_lit(this);
+            if(lit) update_visible(*lit != 0, int(msg -> data), msg);
+        } else {
+            check_visible(msg);
+        }
     }
 
     return MS_CONTINUE;
 }
 
 
+TWBaseScript::MsgStatus TWTriggerVisible::on_endscript(sScrMsg* msg, cMultiParm& reply)
+{
+    remove_from_sweep(this, msg -> time, true);
+
+    return MS_CONTINUE;
+}
+
+
 void TWTriggerVisible::check_visible(sScrMsg* msg)
 {
+    char* lit = sweep_lit(this);
+    if(!lit) return;
+
     SService<IPropertySrv> prop_serv(g_pScriptManager);
     if(prop_serv -> Possessed(ObjId(), "AI_Visibility")) {
         cMultiParm light;
         prop_serv -> Get(light, ObjId(), "AI_Visibility", "Light rating");
 
-        if(debug_enabled())
-            debug_printf(DL_DEBUG, "Light: %d", int(light));
-
         // Check whether the object has changed from light to dark or vice versa
-        if(int(light) < lowlight_threshold.value() && int(is_litup)) {
-            if(debug_enabled())
-                debug_printf(DL_DEBUG, "Object is now invisible, sending off");
+        int rating = int(light);
+        if((*lit && rating < lowlight_threshold.value()) || (!*lit && rating > highlight_threshold.value())) {
+            *lit = !*lit;
+            update_visible(*lit != 0, rating, msg);
+        }
+    }
+}
 
-            is_litup = 0;
-            send_off_message(msg);
 
-        } else if(int(light) > highlight_threshold.value() && !int(is_litup)) {
-            if(debug_enabled())
-                debug_printf(DL_DEBUG, "Object is now visible, sending on");
+void TWTriggerVisible::update_visible(const bool lit, const int light, sScrMsg* msg)
+{
+    if(debug_enabled())
+        debug_printf(DL_DEBUG, "Light: %d", light);
 
-            is_litup = 1;
-            send_on_message(msg);
-        }
+    // Only the copy saved with the game is updated here, the sweep holds the
+    // state the checks are made against
+    is_litup = lit ? 1 : 0;
+
+    if(lit) {
+        if(debug_enabled())
+            debug_printf(DL_DEBUG, "Object is now visible, sending on");
+
+        send_on_message(msg);
+    } else {
+        if(debug_enabled())
+            debug_printf(DL_DEBUG, "Object is now invisible, sending off");
+
+        send_off_message(msg);
     }
 }
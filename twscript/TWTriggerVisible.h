@@ -35,6 +35,17 @@
 
 /** @class TWTriggerVisible
  *
+ * TWTriggerVisible sends an On message when the light rating of the object
+ * it is on rises above a high threshold, and an Off message when it falls
+ * below a low one.
+ *
+ * Instances that check at the same rate share a single timer: one of them
+ * reads the light rating of every object in the group in one pass, and only
+ * the instances whose state needs to change are sent a CheckVis message.
+ * The thresholds are read from each instance on every pass, so they follow
+ * any qvars they use. If an instance's rate changes, it moves to the group
+ * for its new rate on the next pass, so the change takes effect one check
+ * late.
  */
 class TWTriggerVisible : public TWBaseTrigger
 {
@@ -44,9 +55,48 @@ public:
                                                      lowlight_threshold (object, name, "Low"),
                                                      highlight_threshold(object, name, "High"),
                                                      SCRIPT_VAROBJ(TWTriggerVisible, is_litup    , object),
-                                                     SCRIPT_VAROBJ(TWTriggerVisible, update_timer, object)
+                                                     sweep_group(-1), sweep_index(0)
         { /* fnord */ }
 
+    /** Destroy the TWTriggerVisible instance, removing it from its sweep.
+     */
+    ~TWTriggerVisible();
+
+
+    /** Get the light rating below which the object is considered unlit.
+     */
+    int get_low_threshold() { return lowlight_threshold.value(); }
+
+
+    /** Get the light rating above which the object is considered lit.
+     */
+    int get_high_threshold() { return highlight_threshold.value(); }
+
+
+    /** Get how often the light rating should be checked, in milliseconds.
+     */
+    uint get_refresh() { return static_cast<uint>(refresh.value()); }
+
+
+    /** Get the index of the sweep group the instance is in, or -1 if it is
+     *  not in one.
+     */
+    int get_sweep_group() const { return sweep_group; }
+
+
+    /** Get the position of the instance within its sweep group.
+     */
+    size_t get_sweep_index() const { return sweep_index; }
+
+
+    /** Record where the instance is in the sweeps. This should only be
+     *  called by the sweep code as it moves instances around.
+     *
+     * @param group The index of the sweep group, or -1 if none.
+     * @param index The position of the instance within the group.
+     */
+    void set_sweep_slot(const int group, const size_t index) { sweep_group = group; sweep_index = index; }
+
 protected:
     /* ------------------------------------------------------------------------
      *  Initialisation related
@@ -56,7 +106,7 @@ protected:
      *  parameters from the design note, and sets up the script so that
      *  it can be used correctly.
      */
-    void init(int time);
+    void init(int time, const DesignNote& design_note);
 
 
     /* ------------------------------------------------------------------------
@@ -76,6 +126,15 @@ protected:
     MsgStatus on_message(sScrMsg* msg, cMultiParm& reply);
 
 
+    /** Register the handlers for the messages this script deals with.
+     *
+     * @param table A reference to the table to register the handlers in.
+     */
+    static void register_handlers(MessageTable<TWTriggerVisible>& table);
+
+    static MessageTable<TWTriggerVisible> handlers; //!< The handlers for the messages this script deals with
+
+
     /** Timer message handler, called whenever the script receives a timer message.
      *
      * @param msg   A pointer to the message received by the object.
@@ -86,6 +145,17 @@ protected:
      */
     MsgStatus on_timer(sScrTimerMsg* msg, cMultiParm& reply);
 
+
+    /** EndScript message handler, called when the script is shut down.
+     *
+     * @param msg   A pointer to the message received by the object.
+     * @param reply A reference to a multiparm variable in which a reply can
+     *              be stored.
+     * @return A status value indicating whether the caller should continue
+     *         processing the message
+     */
+    MsgStatus on_endscript(sScrMsg* msg, cMultiParm& reply);
+
 private:
     /**
      *  Determine whether the visibility state of the object needs updating, and
@@ -95,12 +165,24 @@ private:
      */
     void check_visible(sScrMsg* msg);
 
+
+    /** Send an on or off message for a change in the object's lit state,
+     *  once the sweep has recorded it.
+     *
+     * @param lit   Is the object now lit?
+     * @param light The object's light rating.
+     * @param msg   A pointer to the message received by the object.
+     */
+    void update_visible(const bool lit, const int light, sScrMsg* msg);
+
     DesignParamTime refresh;             //!< How frequently should the state be updated?
     DesignParamInt  lowlight_threshold;  //!< The boundary below which the player is considered in darkness
     DesignParamInt  highlight_threshold; //!< The boundary above which the player is considered in light
 
-    script_int               is_litup;     //!< Is the player currently illuminated?
-    script_handle<tScrTimer> update_timer; //!< A timer used to update the trigger
+    script_int               is_litup;     //!< The lit state saved with the game, used to restore the sweep's after a load
+
+    int                      sweep_group;  //!< The index of the sweep group the instance is in, -1 if none
+    size_t                   sweep_index;  //!< The position of the instance within its sweep group
 };
 
 #else // SCR_GENSCRIPTS